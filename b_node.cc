@@ -1,494 +1,916 @@
-#include "b_node.h"
-
-// -----------------------------------------------------------------------------
-//  BNode: basic structure of node in b-tree
-// -----------------------------------------------------------------------------
-BNode::BNode()						// constructor
-{
-	level_         = -1;
-	num_entries_   = -1;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	key_           = NULL;
-	block_         = -1;
-	capacity_      = -1;
-	dirty_         = false;
-	btree_         = NULL;
-}
-
-// -----------------------------------------------------------------------------
-BNode::~BNode()						// destructor
-{
-	key_   = NULL;
-	btree_ = NULL;
-}
-
-// -----------------------------------------------------------------------------
-void BNode::init(					// init a new node, which not exist
-	int   level,						// level (depth) in b-tree
-	BTree *btree)						// b-tree of this node
-{
-	btree_         = btree;
-	level_         = (char) level;
-	dirty_         = true;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	key_           = NULL;
-	num_entries_   = 0;
-	block_         = -1;
-	capacity_      = -1;
-}
-
-// -----------------------------------------------------------------------------
-void BNode::init_restore(			// load an exist node from disk to init
-	BTree *btree,						// b-tree of this node
-	int   block)						// addr of disk for this node
-{
-	btree_         = btree;
-	block_         = block;
-	dirty_         = false;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	key_           = NULL;
-	num_entries_   = 0;
-	level_         = -1;
-	capacity_      = -1;
-}
-
-// -----------------------------------------------------------------------------
-BNode* BNode::get_left_sibling()	// get the left-sibling node
-{
-	BNode *node = NULL;
-	if (left_sibling_ != -1) {		// left sibling node exist
-		node = new BNode();			// read left-sibling from disk
-		node->init_restore(btree_, left_sibling_);
-	}
-	return node;
-}
-
-// -----------------------------------------------------------------------------
-BNode* BNode::get_right_sibling()	// get the right-sibling node
-{
-	BNode *node = NULL;
-	if (right_sibling_ != -1) {		// right sibling node exist
-		node = new BNode();			// read right-sibling from disk
-		node->init_restore(btree_, right_sibling_);
-	}
-	return node;
-}
-
-
-// -----------------------------------------------------------------------------
-//  BIndexNode: structure of index node for b-tree
-// -----------------------------------------------------------------------------
-BIndexNode::BIndexNode()			// constructor
-{
-	level_         = -1;
-	num_entries_   = -1;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	block_         = -1;
-	capacity_      = -1;
-	dirty_         = false;
-	btree_         = NULL;
-	key_           = NULL;
-	son_           = NULL;
-}
-
-// -----------------------------------------------------------------------------
-BIndexNode::~BIndexNode()			// destructor
-{
-	if (dirty_) {					// if dirty, rewrite to disk
-		int  block_length = btree_->file_->get_blocklength();
-		char *buf = new char[block_length];
-		write_to_buffer(buf);
-		btree_->file_->write_block(buf, block_);
-
-		delete[] buf; buf = NULL;
-	}
-
-	if (key_ != NULL) {
-		delete[] key_; key_ = NULL;
-	}
-	if (son_ != NULL) {
-		delete[] son_; son_ = NULL;
-	}
-}
-
-// -----------------------------------------------------------------------------
-void BIndexNode::init(				// init a new node, which not exist
-	int   level,						// level (depth) in b-tree
-	BTree *btree)						// b-tree of this node
-{
-	btree_         = btree;
-	level_         = (char) level;
-	num_entries_   = 0;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	dirty_         = true;
-
-	//page size B
-	int b_length = btree_->file_->get_blocklength();
-	capacity_ = (b_length - get_header_size()) / get_entry_size(); //how many entries
-	if (capacity_ < 50) {			// ensure at least 50 entries
-		printf("capacity = %d, which is too small.\n", capacity_);
-		exit(1);
-	}
-
-	key_ = new float[capacity_];
-	son_ = new int[capacity_];
-	//分配内存
-	memset(key_, MINREAL, capacity_ * SIZEFLOAT);
-	memset(son_, -1,      capacity_ * SIZEINT);
-
-	char *blk = new char[b_length];	// init <block_>, get new addr
-	block_ = btree_->file_->append_block(blk);
-	delete[] blk; blk = NULL;
-}
-
-// -----------------------------------------------------------------------------
-void BIndexNode::init_restore(		// load an exist node from disk to init
-	BTree *btree,						// b-tree of this node
-	int   block)						// addr of disk for this node
-{
-	btree_ = btree;
-	block_ = block;
-	dirty_ = false;
-
-	int b_len = btree_->file_->get_blocklength();
-	capacity_ = (b_len - get_header_size()) / get_entry_size();
-	if (capacity_ < 50) {			// at least 50 entries
-		printf("capacity = %d, which is too small.\n", capacity_);
-		exit(1);
-	}
-
-	key_ = new float[capacity_];
-	son_ = new int[capacity_];
-	memset(key_, MINREAL, capacity_ * SIZEFLOAT);
-	memset(son_, -1,      capacity_ * SIZEINT);
-
-	// -------------------------------------------------------------------------
-	//  read the buffer <blk> to init <level_>, <num_entries_>, <left_sibling_>,
-	//  <right_sibling_>, <key_> and <son_>.
-	// -------------------------------------------------------------------------
-	char *blk = new char[b_len];
-	btree_->file_->read_block(blk, block);
-	read_from_buffer(blk);
-
-	delete[] blk; blk = NULL;
-}
-
-// -----------------------------------------------------------------------------
-//  Read info from buffer to initialize <level_>, <num_entries_>,
-//  <left_sibling_>, <right_sibling_>, <key_> and <son_> of b-index node
-// -----------------------------------------------------------------------------
-void BIndexNode::read_from_buffer( 	// read a b-node from buffer
-	const char *buf)					// store info of a b-index node
-{
-	int i = 0;
-	memcpy(&level_,         &buf[i], SIZECHAR); i += SIZECHAR;
-	memcpy(&num_entries_,   &buf[i], SIZEINT);  i += SIZEINT;
-	memcpy(&left_sibling_,  &buf[i], SIZEINT);  i += SIZEINT;
-	memcpy(&right_sibling_, &buf[i], SIZEINT);  i += SIZEINT;
-
-	for (int j = 0; j < num_entries_; ++j) {
-		memcpy(&key_[j], &buf[i], SIZEFLOAT); i += SIZEFLOAT;
-		memcpy(&son_[j], &buf[i], SIZEINT);   i += SIZEINT;
-	}
-}
-
-// -----------------------------------------------------------------------------
-void BIndexNode::write_to_buffer( 	// write info of node into buffer
-	char *buf)							// store info of this node (return)
-{
-	int i = 0;
-	memcpy(&buf[i], &level_,         SIZECHAR); i += SIZECHAR;
-	memcpy(&buf[i], &num_entries_,   SIZEINT);  i += SIZEINT;
-	memcpy(&buf[i], &left_sibling_,  SIZEINT);  i += SIZEINT;
-	memcpy(&buf[i], &right_sibling_, SIZEINT);  i += SIZEINT;
-
-	for (int j = 0; j < num_entries_; ++j) {
-		memcpy(&buf[i], &key_[j], SIZEFLOAT); i += SIZEFLOAT;
-		memcpy(&buf[i], &son_[j], SIZEINT);   i += SIZEINT;
-	}
-}
-
-// -----------------------------------------------------------------------------
-//  find position of entry that is just less than or equal to input entry.
-//  if input entry is smaller than all entry in this node, we'll return -1.
-//  the scan order is from right to left.
-// -----------------------------------------------------------------------------
-int BIndexNode::find_position_by_key(
-	float key)							// input key
-{
-	int pos = -1;
-	for (int i = num_entries_ - 1; i >= 0; --i) {
-		if (key_[i] <= key) {
-			pos = i;
-			break;
-		}
-	}
-	return pos;
-}
-
-// -----------------------------------------------------------------------------
-//  get the left-sibling node
-// -----------------------------------------------------------------------------
-BIndexNode* BIndexNode::get_left_sibling()
-{
-	BIndexNode *node = NULL;
-	if (left_sibling_ != -1) {		// left sibling node exist
-		node = new BIndexNode();	// read left-sibling from disk
-		node->init_restore(btree_, left_sibling_);
-	}
-	return node;
-}
-
-// -----------------------------------------------------------------------------
-//  get the right-sibling node
-// -----------------------------------------------------------------------------
-BIndexNode* BIndexNode::get_right_sibling()
-{
-	BIndexNode *node = NULL;
-	if (right_sibling_ != -1) {		// right sibling node exist
-		node = new BIndexNode();	// read right-sibling from disk
-		node->init_restore(btree_, right_sibling_);
-	}
-	return node;
-}
-
-// -----------------------------------------------------------------------------
-void BIndexNode::add_new_child( // add a new entry from its child node
-	float key,							// input key
-	int   son)							// input son
-{
-	// assert(num_entries_ >= 0 && num_entries_ < capacity_);
-	key_[num_entries_] = key;		// add new entry into its pos
-	son_[num_entries_] = son;
-
-	++num_entries_;					// update <num_entries_>
-	dirty_ = true;					// node modified, <dirty_> is true
-}
-
-
-// -----------------------------------------------------------------------------
-//  BLeafNode: structure of leaf node in b-tree
-// -----------------------------------------------------------------------------
-BLeafNode::BLeafNode()				// constructor
-{
-	level_         = -1;
-	num_entries_   = -1;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	block_         = -1;
-	capacity_      = -1;
-	dirty_         = false;
-	btree_         = NULL;
-	num_keys_      = -1;
-	capacity_keys_ = -1;
-	key_           = NULL;
-	id_            = NULL;
-}
-
-// -----------------------------------------------------------------------------
-BLeafNode::~BLeafNode()				// destructor
-{
-	if (dirty_) {					// if dirty, rewrite to disk
-		int  block_length = btree_->file_->get_blocklength();
-		char *buf = new char[block_length];
-		write_to_buffer(buf);
-		btree_->file_->write_block(buf, block_);
-
-		delete[] buf; buf = NULL;
-	}
-	
-	if (key_ != NULL) {
-		delete[] key_; key_ = NULL;
-	}
-	if (id_ != NULL) {
-		delete[] id_; id_ = NULL;
-	}
-}
-
-// -----------------------------------------------------------------------------
-void BLeafNode::init(				// init a new node, which not exist
-	int   level,						// level (depth) in b-tree
-	BTree *btree)						// b-tree of this node
-{
-	btree_         = btree;
-	level_         = (char) level;
-
-	num_entries_   = 0;
-	num_keys_      = 0;
-	left_sibling_  = -1;
-	right_sibling_ = -1;
-	dirty_         = true;
-
-	// -------------------------------------------------------------------------
-	//  init <capacity_keys_> and calc key size
-	// -------------------------------------------------------------------------
-	//page size B
-	int b_length = btree_->file_->get_blocklength();
-	int key_size = get_key_size(b_length);
-
-	key_ = new float[capacity_keys_];
-	memset(key_, MINREAL, capacity_keys_ * SIZEFLOAT);
-	
-	int header_size = get_header_size();
-	int entry_size = get_entry_size();
-
-	capacity_ = (b_length - header_size - key_size) / entry_size;
-	if (capacity_ < 100) {			// at least 100 entries
-		printf("capacity = %d, which is too small.\n", capacity_);
-		exit(1);
-	}
-	id_ = new int[capacity_];
-	memset(id_, -1, capacity_ * SIZEINT);
-
-	char *blk = new char[b_length];
-	block_ = btree_->file_->append_block(blk);
-	delete[] blk; blk = NULL;
-}
-
-// -----------------------------------------------------------------------------
-void BLeafNode::init_restore(		// load an exist node from disk to init
-	BTree *btree,						// b-tree of this node
-	int   block)						// addr of disk for this node
-{
-	btree_ = btree;
-	block_ = block;
-	dirty_ = false;
-
-	// -------------------------------------------------------------------------
-	//  init <capacity_keys> and calc key size
-	// -------------------------------------------------------------------------
-	int b_length = btree_->file_->get_blocklength();
-	int key_size = get_key_size(b_length);
-
-	key_ = new float[capacity_keys_];
-	memset(key_, MINREAL, capacity_keys_ * SIZEFLOAT);
-	
-	int header_size = get_header_size();
-	int entry_size = get_entry_size();
-
-	capacity_ = (b_length - header_size - key_size) / entry_size;
-	if (capacity_ < 100) {			// at least 100 entries
-		printf("capacity = %d, which is too small.\n", capacity_);
-		exit(1);
-	}
-	id_ = new int[capacity_];
-	memset(id_, -1, capacity_ * SIZEINT);
-
-	// -------------------------------------------------------------------------
-	//  read the buffer <blk> to init <level_>, <num_entries_>, <left_sibling_>,
-	//  <right_sibling_>, <num_keys_> <key_> and <id_>
-	// -------------------------------------------------------------------------
-	char *blk = new char[b_length];
-	btree_->file_->read_block(blk, block);
-	read_from_buffer(blk);
-
-	delete[] blk; blk = NULL;
-}
-
-// -----------------------------------------------------------------------------
-void BLeafNode::read_from_buffer(	// read a b-node from buffer
-	const char *buf)					// store info of a b-node
-{
-	int i = 0;
-	// -------------------------------------------------------------------------
-	//  read header: <level_> <num_entries_> <left_sibling_> <right_sibling_>
-	// -------------------------------------------------------------------------
-	memcpy(&level_,         &buf[i], SIZECHAR); i += SIZECHAR;
-	memcpy(&num_entries_,   &buf[i], SIZEINT);  i += SIZEINT;
-	memcpy(&left_sibling_,  &buf[i], SIZEINT);  i += SIZEINT;
-	memcpy(&right_sibling_, &buf[i], SIZEINT);  i += SIZEINT;
-
-	// -------------------------------------------------------------------------
-	//  read keys: <num_keys_> and <key_> and entries: <id_>
-	// -------------------------------------------------------------------------
-	memcpy(&num_keys_, &buf[i], SIZEINT); i += SIZEINT;
-	for (int j = 0; j < capacity_keys_; ++j) {
-		memcpy(&key_[j], &buf[i], SIZEFLOAT); i += SIZEFLOAT;
-	}
-	for (int j = 0; j < num_entries_; ++j) {
-		memcpy(&id_[j], &buf[i], SIZEINT); i += SIZEINT;
-	}
-}
-
-// -----------------------------------------------------------------------------
-void BLeafNode::write_to_buffer(	// write a b-node into buffer
-	char *buf)							// store info of a b-node (return)
-{
-	int i = 0;
-	// -------------------------------------------------------------------------
-	//  write header: <level_> <num_entries_> <left_sibling_> <right_sibling_>
-	// -------------------------------------------------------------------------
-	memcpy(&buf[i], &level_,         SIZECHAR); i += SIZECHAR;
-	memcpy(&buf[i], &num_entries_,   SIZEINT);  i += SIZEINT;
-	memcpy(&buf[i], &left_sibling_,  SIZEINT);  i += SIZEINT;
-	memcpy(&buf[i], &right_sibling_, SIZEINT);  i += SIZEINT;
-
-	// -------------------------------------------------------------------------
-	//  write keys: <num_keys_> and <key_> and entries: <id_>
-	// -------------------------------------------------------------------------
-	memcpy(&buf[i], &num_keys_, SIZEINT); i += SIZEINT;
-	for (int j = 0; j < capacity_keys_; ++j) {
-		memcpy(&buf[i], &key_[j], SIZEFLOAT); i += SIZEFLOAT;
-	}
-	for (int j = 0; j < num_entries_; ++j) {
-		memcpy(&buf[i], &id_[j], SIZEINT); i += SIZEINT;
-	}
-}
-
-// -----------------------------------------------------------------------------
-int BLeafNode::find_position_by_key(// find pos just less than input key
-	float key)							// input key
-{
-	int pos = -1;							
-	for (int i = num_keys_ - 1; i >= 0; --i) {
-		if (key_[i] <= key) {
-			pos = i;				// position of corresponding id
-			break;
-		}
-	}
-	return pos;
-}
-
-// -----------------------------------------------------------------------------
-BLeafNode* BLeafNode::get_left_sibling() // get left-sibling node
-{
-	BLeafNode *node = NULL;
-	if (left_sibling_ != -1) {		// left sibling node exist
-		node = new BLeafNode();		// read left-sibling from disk
-		node->init_restore(btree_, left_sibling_);
-	}
-	return node;
-}
-
-// -----------------------------------------------------------------------------
-BLeafNode* BLeafNode::get_right_sibling() // get right sibling node
-{
-	BLeafNode *node = NULL;
-	if (right_sibling_ != -1) {		// right sibling node exist
-		node = new BLeafNode();		// read right-sibling from disk
-		node->init_restore(btree_, right_sibling_);
-	}
-	return node;
-}
-
-// -----------------------------------------------------------------------------
-void BLeafNode::add_new_child( 		// add new child by input id and key
-	int   id,							// input object id
-	float key)							// input key
-{
-	// assert(num_entries_ < capacity_);
-
-	id_[num_entries_] = id;			// add new id into its pos
-	if ((num_entries_ * SIZEINT) % LEAF_NODE_SIZE == 0) {  //16 entries
-		assert(num_keys_ < capacity_keys_);
-		key_[num_keys_] = key;		// add new key into its pos
-		++num_keys_;				// update <num_keys>
-	}
-	++num_entries_;					// update <num_entries>
-	dirty_ = true;					// node modified, <dirty> is true
-}
+#include "b_node.h"
+
+// -----------------------------------------------------------------------------
+//  BNode: basic structure of node in b-tree
+// -----------------------------------------------------------------------------
+BNode::BNode()						// constructor
+{
+	level_         = -1;
+	num_entries_   = -1;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	key_           = NULL;
+	block_         = -1;
+	capacity_      = -1;
+	dirty_         = false;
+	btree_         = NULL;
+}
+
+// -----------------------------------------------------------------------------
+BNode::~BNode()						// destructor
+{
+	key_   = NULL;
+	btree_ = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BNode::init(					// init a new node, which not exist
+	int   level,						// level (depth) in b-tree
+	BTree *btree,						// b-tree of this node
+	int   /* near */)					// place after this block if free
+{
+	btree_         = btree;
+	level_         = (char) level;
+	dirty_         = true;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	key_           = NULL;
+	num_entries_   = 0;
+	block_         = -1;
+	capacity_      = -1;
+}
+
+// -----------------------------------------------------------------------------
+void BNode::init_restore(			// load an exist node from disk to init
+	BTree *btree,						// b-tree of this node
+	int   block)						// addr of disk for this node
+{
+	btree_         = btree;
+	block_         = block;
+	dirty_         = false;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	key_           = NULL;
+	num_entries_   = 0;
+	level_         = -1;
+	capacity_      = -1;
+}
+
+// -----------------------------------------------------------------------------
+BNode* BNode::get_left_sibling()	// get the left-sibling node
+{
+	BNode *node = NULL;
+	if (left_sibling_ != -1) {		// left sibling node exist
+		node = new BNode();			// read left-sibling from disk
+		node->init_restore(btree_, left_sibling_);
+	}
+	return node;
+}
+
+// -----------------------------------------------------------------------------
+BNode* BNode::get_right_sibling()	// get the right-sibling node
+{
+	BNode *node = NULL;
+	if (right_sibling_ != -1) {		// right sibling node exist
+		node = new BNode();			// read right-sibling from disk
+		node->init_restore(btree_, right_sibling_);
+	}
+	return node;
+}
+
+
+// -----------------------------------------------------------------------------
+//  BIndexNode: structure of index node for b-tree
+// -----------------------------------------------------------------------------
+BIndexNode::BIndexNode()			// constructor
+{
+	level_         = -1;
+	num_entries_   = -1;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	block_         = -1;
+	capacity_      = -1;
+	dirty_         = false;
+	btree_         = NULL;
+	key_           = NULL;
+	son_           = NULL;
+}
+
+// -----------------------------------------------------------------------------
+BIndexNode::~BIndexNode()			// destructor
+{
+	if (dirty_) {					// if dirty, rewrite to disk
+		int  block_length = btree_->file_->get_blocklength();
+		char *buf = new_block(block_length);
+		write_to_buffer(buf);
+		btree_->file_->write_block(buf, block_);
+
+		delete_block(buf); buf = NULL;
+	}
+
+	if (key_ != NULL) {
+		delete[] key_; key_ = NULL;
+	}
+	if (son_ != NULL) {
+		delete[] son_; son_ = NULL;
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::init(				// init a new node, which not exist
+	int   level,						// level (depth) in b-tree
+	BTree *btree,						// b-tree of this node
+	int   near)							// place after this block if free
+{
+	init_at(level, btree, -1);
+
+	//page size B
+	int b_length = btree_->file_->get_blocklength();
+	char *blk = new_block(b_length);	// init <block_>, get new addr
+	block_ = btree_->file_->append_block(blk, near);
+	delete_block(blk); blk = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::init_at(			// init a new node in an allocated block
+	int   level,						// level (depth) in b-tree
+	BTree *btree,						// b-tree of this node
+	int   block)						// addr of disk for this node
+{
+	btree_         = btree;
+	level_         = (char) level;
+	num_entries_   = 0;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	dirty_         = true;
+	block_         = block;
+
+	capacity_ = get_capacity(btree_->file_->get_payload_length(),
+		btree_->format_);			//how many entries
+	if (capacity_ < 50) {			// ensure at least 50 entries
+		printf("capacity = %d, which is too small.\n", capacity_);
+		exit(1);
+	}
+
+	key_ = new float[capacity_];
+	son_ = new int[capacity_];
+	//分配内存
+	memset(key_, MINREAL, capacity_ * SIZEFLOAT);
+	memset(son_, -1,      capacity_ * SIZEINT);
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::init_restore(		// load an exist node from disk to init
+	BTree *btree,						// b-tree of this node
+	int   block)						// addr of disk for this node
+{
+	int  b_len = btree->file_->get_blocklength();
+	char *blk = new_block(b_len);
+	if (!btree->file_->read_block(blk, block)) {
+		printf("could not read index node %d\n", block);
+		exit(1);
+	}
+	init_restore(btree, block, blk);
+
+	delete_block(blk); blk = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::init_restore(		// init an exist node from its block
+	BTree *btree,						// b-tree of this node
+	int   block,						// addr of disk for this node
+	const char *blk)					// content of the block
+{
+	btree_ = btree;
+	block_ = block;
+	dirty_ = false;
+
+	capacity_ = get_capacity(btree_->file_->get_payload_length(),
+		btree_->format_);
+	if (capacity_ < 50) {			// at least 50 entries
+		printf("capacity = %d, which is too small.\n", capacity_);
+		exit(1);
+	}
+
+	key_ = new float[capacity_];
+	son_ = new int[capacity_];
+	memset(key_, MINREAL, capacity_ * SIZEFLOAT);
+	memset(son_, -1,      capacity_ * SIZEINT);
+
+	// -------------------------------------------------------------------------
+	//  read the buffer <blk> to init <level_>, <num_entries_>, <left_sibling_>,
+	//  <right_sibling_>, <key_> and <son_>.
+	// -------------------------------------------------------------------------
+	read_from_buffer(blk);
+}
+
+// -----------------------------------------------------------------------------
+//  Read info from buffer to initialize <level_>, <num_entries_>,
+//  <left_sibling_>, <right_sibling_>, <key_> and <son_> of b-index node
+// -----------------------------------------------------------------------------
+void BIndexNode::read_from_buffer( 	// read a b-node from buffer
+	const char *buf)					// store info of a b-index node
+{
+	int i = 0;
+	memcpy(&level_,         &buf[i], SIZECHAR); i += SIZECHAR;
+	memcpy(&num_entries_,   &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&left_sibling_,  &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&right_sibling_, &buf[i], SIZEINT);  i += SIZEINT;
+
+	int format = btree_->format_;
+	if (format == NODE_FORMAT_SOA) {
+		memcpy(key_, keys_of_buffer(buf), num_entries_ * SIZEFLOAT);
+		memcpy(son_, sons_of_buffer(buf, capacity_), num_entries_ * SIZEINT);
+		return;
+	}
+	if (format == NODE_FORMAT_EYTZINGER) {
+		eytzinger_decode(keys_of_buffer(buf),
+			sons_of_buffer(buf, get_key_slots(capacity_, format)),
+			num_entries_, key_, son_);
+		return;
+	}
+	for (int j = 0; j < num_entries_; ++j) {
+		memcpy(&key_[j], &buf[i], SIZEFLOAT); i += SIZEFLOAT;
+		memcpy(&son_[j], &buf[i], SIZEINT);   i += SIZEINT;
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::write_to_buffer( 	// write info of node into buffer
+	char *buf)							// store info of this node (return)
+{
+	int i = 0;
+	memcpy(&buf[i], &level_,         SIZECHAR); i += SIZECHAR;
+	memcpy(&buf[i], &num_entries_,   SIZEINT);  i += SIZEINT;
+	memcpy(&buf[i], &left_sibling_,  SIZEINT);  i += SIZEINT;
+	memcpy(&buf[i], &right_sibling_, SIZEINT);  i += SIZEINT;
+
+	int format = btree_->format_;
+	if (format == NODE_FORMAT_SOA) {
+		int son_off = get_son_offset(capacity_);
+		memset(&buf[i], 0, CACHE_LINE - i);
+		memcpy(&buf[CACHE_LINE], key_, num_entries_ * SIZEFLOAT);
+		memcpy(&buf[son_off],    son_, num_entries_ * SIZEINT);
+		return;
+	}
+	if (format == NODE_FORMAT_EYTZINGER) {
+		int son_off = get_son_offset(get_key_slots(capacity_, format));
+		memset(&buf[i], 0, CACHE_LINE - i);
+		eytzinger_encode(key_, son_, num_entries_,
+			(float *) &buf[CACHE_LINE], (int *) &buf[son_off]);
+		return;
+	}
+	for (int j = 0; j < num_entries_; ++j) {
+		memcpy(&buf[i], &key_[j], SIZEFLOAT); i += SIZEFLOAT;
+		memcpy(&buf[i], &son_[j], SIZEINT);   i += SIZEINT;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  max num of entries of an index node in a block of <b_length> bytes. with
+//  NODE_FORMAT_SOA, key[] starts at <CACHE_LINE> and son[] starts at the
+//  next cache line after key[], so both arrays are cache-line aligned.
+//  NODE_FORMAT_EYTZINGER needs one more slot in each array (1-based keys).
+// -----------------------------------------------------------------------------
+int BIndexNode::get_capacity(		// max num of entries in a block
+	int b_length,						// block length
+	int format)							// format of index nodes
+{
+	int header_size = SIZECHAR + SIZEINT * 3;
+	int entry_size  = SIZEFLOAT + SIZEINT;
+	if (format == NODE_FORMAT_PACKED) {
+		return (b_length - header_size) / entry_size;
+	}
+
+	int capacity = (b_length - CACHE_LINE) / entry_size;
+	while (capacity > 0) {
+		int slots = get_key_slots(capacity, format);
+		if (get_son_offset(slots) + slots * SIZEINT <= b_length) break;
+		--capacity;
+	}
+	return capacity;
+}
+
+// -----------------------------------------------------------------------------
+//  key[r] (sorted) is stored at ekey[k], where k is the r-th node of an
+//  in-order walk of the implicit tree (children of k are 2k and 2k+1).
+//  eytzinger_search() ends at the first key larger than the input, so
+//  eson[k] keeps the son of the entry before key[r], and eson[0] the son of
+//  the last entry (no key is larger than the input).
+// -----------------------------------------------------------------------------
+void BIndexNode::eytzinger_encode(	// sorted entries to eytzinger order
+	const float *key,					// sorted keys
+	const int   *son,					// sons
+	int   num,							// num of entries
+	float *ekey,						// keys in eytzinger order (return)
+	int   *eson)						// sons in eytzinger order (return)
+{
+	if (num <= 0) return;
+
+	int k = 1;						// leftmost node
+	while (2 * k <= num) k *= 2;
+	for (int r = 0; r < num; ++r) {
+		ekey[k] = key[r];
+		eson[k] = son[MAX(r - 1, 0)];
+
+		if (2 * k + 1 <= num) {		// next: leftmost node of right subtree
+			k = 2 * k + 1;
+			while (2 * k <= num) k *= 2;
+		}
+		else {						// next: first ancestor on the right
+			k >>= __builtin_ffs(~k);
+		}
+	}
+	eson[0] = son[num - 1];
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::eytzinger_decode(	// eytzinger order to sorted entries
+	const float *ekey,					// keys in eytzinger order
+	const int   *eson,					// sons in eytzinger order
+	int   num,							// num of entries
+	float *key,							// sorted keys (return)
+	int   *son)							// sons (return)
+{
+	if (num <= 0) return;
+
+	int k = 1;
+	while (2 * k <= num) k *= 2;
+	for (int r = 0; r < num; ++r) {
+		key[r] = ekey[k];
+		if (r > 0) son[r - 1] = eson[k];
+
+		if (2 * k + 1 <= num) {
+			k = 2 * k + 1;
+			while (2 * k <= num) k *= 2;
+		}
+		else {
+			k >>= __builtin_ffs(~k);
+		}
+	}
+	son[num - 1] = eson[0];
+}
+
+// -----------------------------------------------------------------------------
+//  find position of entry that is just less than or equal to input entry.
+//  if input entry is smaller than all entry in this node, we'll return -1.
+//  the scan order is from right to left.
+// -----------------------------------------------------------------------------
+int BIndexNode::find_position_by_key(
+	float key)							// input key
+{
+	PerfScope scope(PHASE_NODE_SEARCH);
+	return find_position(key_, num_entries_, key);
+}
+
+// -----------------------------------------------------------------------------
+int BIndexNode::find_position(		// find pos just less than input key
+	const float *keys,					// sorted keys
+	int   num,							// num of keys
+	float key)							// input key
+{
+	int pos = -1;
+	for (int i = num - 1; i >= 0; --i) {
+		if (keys[i] <= key) {
+			pos = i;
+			break;
+		}
+	}
+	return pos;
+}
+
+// -----------------------------------------------------------------------------
+//  get the left-sibling node
+// -----------------------------------------------------------------------------
+BIndexNode* BIndexNode::get_left_sibling()
+{
+	BIndexNode *node = NULL;
+	if (left_sibling_ != -1) {		// left sibling node exist
+		node = new BIndexNode();	// read left-sibling from disk
+		node->init_restore(btree_, left_sibling_);
+	}
+	return node;
+}
+
+// -----------------------------------------------------------------------------
+//  get the right-sibling node
+// -----------------------------------------------------------------------------
+BIndexNode* BIndexNode::get_right_sibling()
+{
+	BIndexNode *node = NULL;
+	if (right_sibling_ != -1) {		// right sibling node exist
+		node = new BIndexNode();	// read right-sibling from disk
+		node->init_restore(btree_, right_sibling_);
+	}
+	return node;
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::add_new_child( // add a new entry from its child node
+	float key,							// input key
+	int   son)							// input son
+{
+	// assert(num_entries_ >= 0 && num_entries_ < capacity_);
+	key_[num_entries_] = key;		// add new entry into its pos
+	son_[num_entries_] = son;
+
+	++num_entries_;					// update <num_entries_>
+	dirty_ = true;					// node modified, <dirty_> is true
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::insert_child(		// insert an entry at <pos> (not full)
+	int   pos,							// pos of new entry
+	float key,							// input key
+	int   son)							// input son
+{
+	assert(num_entries_ < capacity_ && pos >= 0 && pos <= num_entries_);
+	int num = num_entries_ - pos;
+	memmove(&key_[pos + 1], &key_[pos], num * SIZEFLOAT);
+	memmove(&son_[pos + 1], &son_[pos], num * SIZEINT);
+	key_[pos] = key;
+	son_[pos] = son;
+
+	++num_entries_;
+	dirty_ = true;
+}
+
+// -----------------------------------------------------------------------------
+void BIndexNode::move_entries(		// move entries [from, num) to <dest>
+	int   from,							// first entry to move
+	BIndexNode *dest)					// node to append them to
+{
+	for (int i = from; i < num_entries_; ++i) {
+		dest->add_new_child(key_[i], son_[i]);
+	}
+	num_entries_ = from;
+	dirty_ = true;
+}
+
+
+// -----------------------------------------------------------------------------
+//  BLeafNode: structure of leaf node in b-tree
+// -----------------------------------------------------------------------------
+BLeafNode::BLeafNode()				// constructor
+{
+	level_         = -1;
+	num_entries_   = -1;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	block_         = -1;
+	capacity_      = -1;
+	dirty_         = false;
+	btree_         = NULL;
+	num_keys_      = -1;
+	capacity_keys_ = -1;
+	key_           = NULL;
+	id_            = NULL;
+	compressed_    = false;
+}
+
+// -----------------------------------------------------------------------------
+BLeafNode::~BLeafNode()				// destructor
+{
+	if (dirty_) {					// if dirty, rewrite to disk
+		int  block_length = btree_->file_->get_blocklength();
+		char *buf = new_block(block_length);
+		write_to_buffer(buf);
+		btree_->file_->write_block(buf, block_);
+
+		delete_block(buf); buf = NULL;
+	}
+	
+	if (key_ != NULL) {
+		delete[] key_; key_ = NULL;
+	}
+	if (id_ != NULL) {
+		delete[] id_; id_ = NULL;
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::init(				// init a new node, which not exist
+	int   level,						// level (depth) in b-tree
+	BTree *btree,						// b-tree of this node
+	int   near)							// place after this block if free
+{
+	init_at(level, btree, -1);
+
+	//page size B
+	int b_length = btree_->file_->get_blocklength();
+	char *blk = new_block(b_length);
+	block_ = btree_->file_->append_block(blk, near);
+	delete_block(blk); blk = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::init_at(			// init a new node in an allocated block
+	int   level,						// level (depth) in b-tree
+	BTree *btree,						// b-tree of this node
+	int   block)						// addr of disk for this node
+{
+	btree_         = btree;
+	level_         = (char) level;
+
+	num_entries_   = 0;
+	num_keys_      = 0;
+	left_sibling_  = -1;
+	right_sibling_ = -1;
+	dirty_         = true;
+	block_         = block;
+	compressed_    = btree_->compress_;
+
+	init_capacity(btree_->file_->get_payload_length());
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::init_restore(		// load an exist node from disk to init
+	BTree *btree,						// b-tree of this node
+	int   block)						// addr of disk for this node
+{
+	int  b_length = btree->file_->get_blocklength();
+	char *blk = new_block(b_length);
+	if (!btree->file_->read_block(blk, block)) {
+		printf("could not read leaf node %d\n", block);
+		exit(1);
+	}
+	init_restore(btree, block, blk);
+
+	delete_block(blk); blk = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::init_restore(		// init an exist node from its block
+	BTree *btree,						// b-tree of this node
+	int   block,						// addr of disk for this node
+	const char *blk)					// content of the block
+{
+	btree_ = btree;
+	block_ = block;
+	dirty_ = false;
+	compressed_ = (blk[0] & LEAF_COMPRESSED) != 0;
+
+	init_capacity(btree_->file_->get_payload_length());
+
+	// -------------------------------------------------------------------------
+	//  read the buffer <blk> to init <level_>, <num_entries_>, <left_sibling_>,
+	//  <right_sibling_>, <num_keys_> <key_> and <id_>
+	// -------------------------------------------------------------------------
+	read_from_buffer(blk);
+}
+
+// -----------------------------------------------------------------------------
+int BLeafNode::get_increment()		// num of ids per key (of the tree)
+{
+	return btree_->key_stride_;
+}
+
+// -----------------------------------------------------------------------------
+//  init <capacity_keys_> and <capacity_>. a compressed leaf allows up to
+//  <LEAF_COMPRESS_RATIO> times the entries of a plain one, and has_room()
+//  checks whether they fit into the block.
+// -----------------------------------------------------------------------------
+void BLeafNode::init_capacity(		// init <capacity_> and <capacity_keys_>
+	int b_length)						// block length
+{
+	int key_size = get_key_size(b_length);
+	int header_size = get_header_size();
+	int entry_size = get_entry_size();
+
+	capacity_ = (b_length - header_size - key_size) / entry_size;
+	capacity_ = MIN(capacity_, capacity_keys_ * get_increment());
+	if (capacity_ < 100) {			// at least 100 entries
+		printf("capacity = %d, which is too small.\n", capacity_);
+		exit(1);
+	}
+	if (compressed_) {
+		capacity_ *= LEAF_COMPRESS_RATIO;
+		capacity_keys_ = (capacity_ + get_increment() - 1) / get_increment();
+	}
+
+	key_ = new float[capacity_keys_];
+	memset(key_, MINREAL, capacity_keys_ * SIZEFLOAT);
+
+	id_ = new int[capacity_];
+	memset(id_, -1, capacity_ * SIZEINT);
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::read_from_buffer(	// read a b-node from buffer
+	const char *buf)					// store info of a b-node
+{
+	int i = 0;
+	// -------------------------------------------------------------------------
+	//  read header: <level_> <num_entries_> <left_sibling_> <right_sibling_>
+	// -------------------------------------------------------------------------
+	memcpy(&level_,         &buf[i], SIZECHAR); i += SIZECHAR;
+	memcpy(&num_entries_,   &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&left_sibling_,  &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&right_sibling_, &buf[i], SIZEINT);  i += SIZEINT;
+
+	compressed_ = (level_ & LEAF_COMPRESSED) != 0;
+	level_ &= LEVEL_MASK;
+	if (compressed_) {
+		read_compressed(buf);
+		return;
+	}
+
+	// -------------------------------------------------------------------------
+	//  read keys: <num_keys_> and <key_> and entries: <id_>
+	// -------------------------------------------------------------------------
+	memcpy(&num_keys_, &buf[i], SIZEINT); i += SIZEINT;
+	for (int j = 0; j < capacity_keys_; ++j) {
+		memcpy(&key_[j], &buf[i], SIZEFLOAT); i += SIZEFLOAT;
+	}
+	for (int j = 0; j < num_entries_; ++j) {
+		memcpy(&id_[j], &buf[i], SIZEINT); i += SIZEINT;
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::write_to_buffer(	// write a b-node into buffer
+	char *buf)							// store info of a b-node (return)
+{
+	int i = 0;
+	char level = compressed_ ? (char) (level_ | LEAF_COMPRESSED) : level_;
+	// -------------------------------------------------------------------------
+	//  write header: <level_> <num_entries_> <left_sibling_> <right_sibling_>
+	// -------------------------------------------------------------------------
+	memcpy(&buf[i], &level,          SIZECHAR); i += SIZECHAR;
+	memcpy(&buf[i], &num_entries_,   SIZEINT);  i += SIZEINT;
+	memcpy(&buf[i], &left_sibling_,  SIZEINT);  i += SIZEINT;
+	memcpy(&buf[i], &right_sibling_, SIZEINT);  i += SIZEINT;
+
+	if (compressed_) {
+		write_compressed(buf);
+		return;
+	}
+
+	// -------------------------------------------------------------------------
+	//  write keys: <num_keys_> and <key_> and entries: <id_>
+	// -------------------------------------------------------------------------
+	memcpy(&buf[i], &num_keys_, SIZEINT); i += SIZEINT;
+	for (int j = 0; j < capacity_keys_; ++j) {
+		memcpy(&buf[i], &key_[j], SIZEFLOAT); i += SIZEFLOAT;
+	}
+	for (int j = 0; j < num_entries_; ++j) {
+		memcpy(&buf[i], &id_[j], SIZEINT); i += SIZEINT;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  keys are sorted in a leaf, so only the first and the last one are read
+//  from the block (or unpacked, for a compressed leaf).
+// -----------------------------------------------------------------------------
+void BLeafNode::key_range_of_buffer(// first and last key of a leaf block
+	const char *buf,					// block of a leaf (not empty)
+	float &first,						// first key (return)
+	float &last)						// last key (return)
+{
+	int i = SIZECHAR + SIZEINT * 3;	// <num_keys_>
+	int num_keys = 0;
+	memcpy(&num_keys, &buf[i], SIZEINT); i += SIZEINT;
+
+	if ((buf[0] & LEAF_COMPRESSED) == 0) {
+		memcpy(&first, &buf[i], SIZEFLOAT);
+		memcpy(&last,  &buf[i + (num_keys - 1) * SIZEFLOAT], SIZEFLOAT);
+		return;
+	}
+	uint32_t key_base = 0;
+	unsigned char key_bits = 0;
+	memcpy(&key_base, &buf[i], SIZEINT);  i += SIZEINT * 2;
+	memcpy(&key_bits, &buf[i], SIZECHAR); i += SIZECHAR * 2;
+
+	first = ordered_to_float(bitpack_get(&buf[i], 0, key_base, key_bits));
+	last  = ordered_to_float(bitpack_get(&buf[i], num_keys - 1, key_base,
+		key_bits));
+}
+
+// -----------------------------------------------------------------------------
+//  compressed leaf: after the header, <num_keys_>, the bases of keys and ids
+//  and their bit widths, then the packed keys and the packed ids. the keys
+//  are mapped to uint32_t in the same order, so frame-of-reference works for
+//  keys as well as for ids.
+// -----------------------------------------------------------------------------
+void BLeafNode::read_compressed(	// decode keys and ids
+	const char *buf)					// store info of a b-node
+{
+	int i = get_header_size();
+	uint32_t key_base = 0, id_base = 0;
+	unsigned char key_bits = 0, id_bits = 0;
+
+	memcpy(&num_keys_, &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&key_base,  &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&id_base,   &buf[i], SIZEINT);  i += SIZEINT;
+	memcpy(&key_bits,  &buf[i], SIZECHAR); i += SIZECHAR;
+	memcpy(&id_bits,   &buf[i], SIZECHAR); i += SIZECHAR;
+
+	uint32_t *vals = (uint32_t *) id_;	// decode in place
+	bitpack_decode(&buf[i], num_keys_, key_base, key_bits, vals);
+	min_key_ = max_key_ = key_base;
+	for (int j = 0; j < num_keys_; ++j) {
+		max_key_ = MAX(max_key_, vals[j]);
+		key_[j] = ordered_to_float(vals[j]);
+	}
+	i += bitpack_size(num_keys_, key_bits);
+
+	bitpack_decode(&buf[i], num_entries_, id_base, id_bits, vals);
+	min_id_ = max_id_ = id_base;
+	for (int j = 0; j < num_entries_; ++j) {
+		max_id_ = MAX(max_id_, vals[j]);
+		id_[j] = (int) (vals[j] ^ 0x80000000u);
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::write_compressed(	// encode keys and ids
+	char *buf)							// store info of a b-node (return)
+{
+	uint32_t *vals = new uint32_t[MAX(num_entries_, num_keys_) + 1];
+	uint32_t key_base = 0, id_base = 0;
+	unsigned char key_bits = 0, id_bits = 0;
+
+	for (int j = 0; j < num_keys_; ++j) vals[j] = float_to_ordered(key_[j]);
+	for (int j = 0; j < num_keys_; ++j) {
+		if (j == 0 || vals[j] < key_base) key_base = vals[j];
+	}
+	for (int j = 0; j < num_keys_; ++j) {
+		key_bits = MAX(key_bits, bitpack_width(vals[j] - key_base));
+	}
+
+	int i = get_header_size();
+	memcpy(&buf[i], &num_keys_, SIZEINT); i += SIZEINT;
+	int base_pos = i; i += SIZEINT * 2 + SIZECHAR * 2;
+
+	bitpack_encode(vals, num_keys_, key_base, key_bits, &buf[i]);
+	i += bitpack_size(num_keys_, key_bits);
+
+	for (int j = 0; j < num_entries_; ++j) vals[j] = id_to_ordered(id_[j]);
+	for (int j = 0; j < num_entries_; ++j) {
+		if (j == 0 || vals[j] < id_base) id_base = vals[j];
+	}
+	for (int j = 0; j < num_entries_; ++j) {
+		id_bits = MAX(id_bits, bitpack_width(vals[j] - id_base));
+	}
+	bitpack_encode(vals, num_entries_, id_base, id_bits, &buf[i]);
+
+	i = base_pos;
+	memcpy(&buf[i], &key_base, SIZEINT);  i += SIZEINT;
+	memcpy(&buf[i], &id_base,  SIZEINT);  i += SIZEINT;
+	memcpy(&buf[i], &key_bits, SIZECHAR); i += SIZECHAR;
+	memcpy(&buf[i], &id_bits,  SIZECHAR); i += SIZECHAR;
+
+	delete[] vals; vals = NULL;
+}
+
+// -----------------------------------------------------------------------------
+int BLeafNode::get_compressed_size(	// bytes of a compressed leaf
+	int num_entries,					// num of entries
+	int num_keys,						// num of keys
+	uint32_t id_range,					// max id  - min id  (ordered)
+	uint32_t key_range)					// max key - min key (ordered)
+{
+	return get_compressed_header_size() +
+		bitpack_size(num_keys,    bitpack_width(key_range)) +
+		bitpack_size(num_entries, bitpack_width(id_range)) + BITPACK_SLACK;
+}
+
+// -----------------------------------------------------------------------------
+int BLeafNode::find_position_by_key(// find pos just less than input key
+	float key)							// input key
+{
+	PerfScope scope(PHASE_NODE_SEARCH);
+	int pos = -1;							
+	for (int i = num_keys_ - 1; i >= 0; --i) {
+		if (key_[i] <= key) {
+			pos = i;				// position of corresponding id
+			break;
+		}
+	}
+	return pos;
+}
+
+// -----------------------------------------------------------------------------
+//  with full keys, key i belongs to id i, so both arrays are shifted.
+// -----------------------------------------------------------------------------
+void BLeafNode::insert_entry(		// insert an entry at <pos> (not full)
+	int   pos,							// pos of new entry
+	int   id,							// input object id
+	float key)							// input key
+{
+	assert(get_increment() == 1 && !compressed_);
+	assert(num_entries_ < capacity_ && pos >= 0 && pos <= num_entries_);
+	int num = num_entries_ - pos;
+	memmove(&id_[pos + 1],  &id_[pos],  num * SIZEINT);
+	memmove(&key_[pos + 1], &key_[pos], num * SIZEFLOAT);
+	id_[pos]  = id;
+	key_[pos] = key;
+
+	++num_entries_;
+	++num_keys_;
+	dirty_ = true;
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::remove_entry(		// remove the entry at <pos>
+	int   pos)							// pos of entry
+{
+	assert(get_increment() == 1 && !compressed_);
+	assert(pos >= 0 && pos < num_entries_);
+	int num = num_entries_ - pos - 1;
+	memmove(&id_[pos],  &id_[pos + 1],  num * SIZEINT);
+	memmove(&key_[pos], &key_[pos + 1], num * SIZEFLOAT);
+
+	--num_entries_;
+	--num_keys_;
+	dirty_ = true;
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::move_entries(		// move entries [from, num) to <dest>
+	int   from,							// first entry to move
+	BLeafNode *dest)					// node to append them to
+{
+	assert(get_increment() == 1 && !compressed_);
+	for (int i = from; i < num_entries_; ++i) {
+		dest->add_new_child(id_[i], key_[i]);
+	}
+	num_entries_ = num_keys_ = from;
+	dirty_ = true;
+}
+
+// -----------------------------------------------------------------------------
+BLeafNode* BLeafNode::get_left_sibling() // get left-sibling node
+{
+	BLeafNode *node = NULL;
+	if (left_sibling_ != -1) {		// left sibling node exist
+		node = new BLeafNode();		// read left-sibling from disk
+		node->init_restore(btree_, left_sibling_);
+	}
+	return node;
+}
+
+// -----------------------------------------------------------------------------
+BLeafNode* BLeafNode::get_right_sibling() // get right sibling node
+{
+	BLeafNode *node = NULL;
+	if (right_sibling_ != -1) {		// right sibling node exist
+		node = new BLeafNode();		// read right-sibling from disk
+		node->init_restore(btree_, right_sibling_);
+	}
+	return node;
+}
+
+// -----------------------------------------------------------------------------
+void BLeafNode::add_new_child( 		// add new child by input id and key
+	int   id,							// input object id
+	float key)							// input key
+{
+	// assert(num_entries_ < capacity_);
+
+	if (compressed_) {				// update ranges of has_room()
+		uint32_t oid = id_to_ordered(id);
+		if (num_entries_ == 0 || oid < min_id_) min_id_ = oid;
+		if (num_entries_ == 0 || oid > max_id_) max_id_ = oid;
+	}
+	id_[num_entries_] = id;			// add new id into its pos
+	if (num_entries_ % get_increment() == 0) { // one key per stride
+		assert(num_keys_ < capacity_keys_);
+		if (compressed_) {
+			uint32_t okey = float_to_ordered(key);
+			if (num_keys_ == 0 || okey < min_key_) min_key_ = okey;
+			if (num_keys_ == 0 || okey > max_key_) max_key_ = okey;
+		}
+		key_[num_keys_] = key;		// add new key into its pos
+		++num_keys_;				// update <num_keys>
+	}
+	++num_entries_;					// update <num_entries>
+	dirty_ = true;					// node modified, <dirty> is true
+}
+
+// -----------------------------------------------------------------------------
+//  a plain leaf has room until it is full. a compressed leaf has room if the
+//  block still holds all entries after adding (id, key), since the new entry
+//  may widen the bits of all ids (or keys).
+// -----------------------------------------------------------------------------
+bool BLeafNode::has_room(			// whether add_new_child(id, key) fits
+	int   id,							// input object id
+	float key)							// input key
+{
+	if (isFull()) return false;
+	if (!compressed_ || num_entries_ == 0) return true;
+
+	uint32_t oid = id_to_ordered(id);
+	uint32_t id_range = MAX(max_id_, oid) - MIN(min_id_, oid);
+
+	int num_keys = num_keys_;
+	uint32_t key_range = max_key_ - min_key_;
+	if (num_entries_ % get_increment() == 0) {
+		uint32_t okey = float_to_ordered(key);
+		key_range = MAX(max_key_, okey) - MIN(min_key_, okey);
+		++num_keys;
+	}
+	int size = get_compressed_size(num_entries_ + 1, num_keys, id_range,
+		key_range);
+	return size <= btree_->file_->get_payload_length();
+}
@@ -1,236 +1,466 @@
-#ifndef __B_NODE_H
-#define __B_NODE_H
-
-#include <iostream>
-#include <algorithm>
-#include <cassert>
-#include <cmath>
-#include <cstring>
-
-#include "def.h"
-#include "block_file.h"
-#include "b_tree.h"
-
-class BTree;
-
-// -----------------------------------------------------------------------------
-//  BNode: basic structure of node in b-tree
-// -----------------------------------------------------------------------------
-class BNode {
-public:
-	BNode();						// constructor
-	virtual ~BNode();				// destructor
-
-	// -------------------------------------------------------------------------
-	virtual void init(				// init a new node, which not exist
-		int   level,					// level (depth) in b-tree
-		BTree *btree);					// b-tree of this node
-
-	// -------------------------------------------------------------------------
-	virtual void init_restore(		// load an exist node from disk to init
-		BTree *btree,					// b-tree of this node
-		int   block);					// address of file of this node
-
-	// -------------------------------------------------------------------------
-	virtual void read_from_buffer(const char *buf) {}
-
-	// -------------------------------------------------------------------------
-	virtual void write_to_buffer(char *buf) {}
-
-	// -------------------------------------------------------------------------
-	virtual inline int get_entry_size() { return 0; }
-
-	// -------------------------------------------------------------------------
-	virtual int find_position_by_key(float key) { return -1; }
-
-	// -------------------------------------------------------------------------
-	virtual inline float get_key(int index) { return -1.0f; }
-
-	// -------------------------------------------------------------------------
-	virtual BNode* get_left_sibling(); // get left sibling node
-
-	virtual BNode* get_right_sibling(); // get right sibling node
-
-	// -------------------------------------------------------------------------
-	inline int get_block() { return block_; }
-
-	// -------------------------------------------------------------------------
-	inline int get_num_entries() { return num_entries_; }
-
-	// -------------------------------------------------------------------------
-	inline int get_level() { return level_; }
-
-	// -------------------------------------------------------------------------
-	//	<level>: SIZECHAR
-	//	<num_entries> <left_sibling> and <right_sibling>: SIZEINT
-	//  get header size in b-node
-	// -------------------------------------------------------------------------
-	inline int get_header_size() { return SIZECHAR+SIZEINT*3; } 
-
-	// -------------------------------------------------------------------------
-	inline float get_key_of_node() { return key_[0]; }	
-
-	// -------------------------------------------------------------------------
-	inline bool isFull() { 
-		if (num_entries_ >= capacity_) return true; 
-		else return false; 
-	}
-
-	// -------------------------------------------------------------------------
-	inline void set_left_sibling(int left_sibling) { 
-		left_sibling_ = left_sibling; 
-	}
-
-	// -------------------------------------------------------------------------
-	inline void set_right_sibling(int right_sibling) { 
-		right_sibling_ = right_sibling; 
-	}
-
-protected:
-	char  level_;					// level of b-tree (level > 0)
-	int   num_entries_;				// number of entries in this node
-	int   left_sibling_;			// addr in disk for left  sibling
-	int   right_sibling_;			// addr in disk for right sibling
-	float *key_;					// keys
-
-	bool  dirty_;					// if dirty, write back to file
-	int   block_;					// addr of disk for this node
-	int   capacity_;				// max num of entries can be stored
-	BTree *btree_;					// b-tree of this node
-};
-
-// -----------------------------------------------------------------------------
-//  BIndexNode: structure of index node in b-tree
-// -----------------------------------------------------------------------------
-class BIndexNode : public BNode {
-public:
-	BIndexNode();					// constructor
-	virtual ~BIndexNode();			// destructor
-
-	// -------------------------------------------------------------------------
-	virtual void init(				// init a new node, which not exist
-		int   level,					// level (depth) in b-tree
-		BTree *btree);					// b-tree of this node
-
-	virtual void init_restore(		// load an exist node from disk to init
-		BTree *btree,					// b-tree of this node
-		int   block);					// address of file of this node
-
-	// -------------------------------------------------------------------------
-	virtual void read_from_buffer(	// read a b-node from buffer
-		const char *buf);				// store info of a b-node
-
-	virtual void write_to_buffer(	// write a b-node into buffer
-		char *buf);						// store info of a b-node (return)
-
-	// -------------------------------------------------------------------------
-	//  entry: <key_>: SIZEFLOAT and <son_>: SIZEINT
-	// -------------------------------------------------------------------------
-	virtual inline int get_entry_size() { return SIZEFLOAT + SIZEINT; }
-
-	// -------------------------------------------------------------------------
-	virtual int find_position_by_key(// find pos just less than input key
-		float key);						// input key
-
-	// -------------------------------------------------------------------------
-	virtual inline float get_key(int index) { 
-		// assert(index >= 0 && index < num_entries_); 
-		return key_[index]; 
-	}
-
-	// -------------------------------------------------------------------------
-	virtual BIndexNode* get_left_sibling(); // get left sibling node
-
-	virtual BIndexNode* get_right_sibling(); // get right sibling node
-
-	// -------------------------------------------------------------------------
-	inline int get_son(int index) {	// get son indexed by <index>
-		// assert(index >= 0 && index < num_entries_); 
-		return son_[index]; 
-	}
-
-	// -------------------------------------------------------------------------
-	void add_new_child(				// add new child by its child node
-		float key,						// input key
-		int son);						// input son
-
-protected:
-	int *son_;						// addr of son node
-};
-
-
-// -----------------------------------------------------------------------------
-//  BLeafNode: structure of leaf node in b-tree
-// -----------------------------------------------------------------------------
-class BLeafNode : public BNode {
-public:
-	BLeafNode();					// constructor
-	virtual ~BLeafNode();			// destructor
-
-	// -------------------------------------------------------------------------
-	virtual void init(				// init a new node, which not exist
-		int   level,					// level (depth) in b-tree
-		BTree *btree);					// b-tree of this node
-
-	virtual void init_restore(		// load an exist node from disk to init
-		BTree *btree,					// b-tree of this node
-		int   block);					// address of file of this node
-
-	// -------------------------------------------------------------------------
-	virtual void read_from_buffer(	// read a b-node from buffer
-		const char *buf);				// store info of a b-node
-
-	virtual void write_to_buffer(	// write a b-node into buffer
-		char *buf);						// store info of a b-node (return)
-
-	// -------------------------------------------------------------------------
-	virtual inline int get_entry_size() { return SIZEINT; }
-
-	// -------------------------------------------------------------------------
-	virtual int find_position_by_key( // find pos just less than input key
-		float key);						// input key
-
-	// -------------------------------------------------------------------------
-	virtual inline float get_key(int index) { 
-		// assert(index >= 0 && index < num_keys_);
-		return key_[index]; 
-	}
-
-	// -------------------------------------------------------------------------
-	virtual BLeafNode* get_left_sibling(); // get left sibling node
-
-	virtual BLeafNode* get_right_sibling(); // get right sibling node
-
-	// -------------------------------------------------------------------------
-	//  array of <key_> with number <capacity_keys_> + <number_keys_> (SIZEINT)
-	// -------------------------------------------------------------------------
-	inline int get_key_size(int block_length) { // block length
-		capacity_keys_ = (int) ceil((float) block_length / LEAF_NODE_SIZE); 
-		return capacity_keys_ * SIZEFLOAT + SIZEINT;
-	} 
-
-	// -------------------------------------------------------------------------
-	inline int get_increment() { return LEAF_NODE_SIZE / get_entry_size(); }
-
-	// -------------------------------------------------------------------------
-	inline int get_num_keys() { return num_keys_; }
-
-	// -------------------------------------------------------------------------
-	inline int get_entry_id(int index) { 
-		// assert(index >= 0 && index < num_entries_); 
-		return id_[index];
-	}
-
-	// -------------------------------------------------------------------------
-	void add_new_child(				// add new child by input id and key
-		int id,							// input object id
-		float key);						// input key
-
-protected:
-	int num_keys_;					// number of keys
-	int *id_;						// object id
-
-	int capacity_keys_;				// max num of keys can be stored
-};
-
-#endif // __B_NODE_H
+#ifndef __B_NODE_H
+#define __B_NODE_H
+
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "def.h"
+#include "bit_pack.h"
+#include "block_file.h"
+#include "b_tree.h"
+
+class BTree;
+
+// -----------------------------------------------------------------------------
+//  BNode: basic structure of node in b-tree
+// -----------------------------------------------------------------------------
+class BNode {
+public:
+	BNode();						// constructor
+	virtual ~BNode();				// destructor
+
+	// -------------------------------------------------------------------------
+	virtual void init(				// init a new node, which not exist
+		int   level,					// level (depth) in b-tree
+		BTree *btree,					// b-tree of this node
+		int   near = -1);				// place after this block if free
+
+	// -------------------------------------------------------------------------
+	virtual void init_restore(		// load an exist node from disk to init
+		BTree *btree,					// b-tree of this node
+		int   block);					// address of file of this node
+
+	// -------------------------------------------------------------------------
+	virtual void read_from_buffer(const char *buf) {}
+
+	// -------------------------------------------------------------------------
+	virtual void write_to_buffer(char *buf) {}
+
+	// -------------------------------------------------------------------------
+	virtual inline int get_entry_size() { return 0; }
+
+	// -------------------------------------------------------------------------
+	virtual int find_position_by_key(float key) { return -1; }
+
+	// -------------------------------------------------------------------------
+	virtual inline float get_key(int index) { return -1.0f; }
+
+	// -------------------------------------------------------------------------
+	virtual BNode* get_left_sibling(); // get left sibling node
+
+	virtual BNode* get_right_sibling(); // get right sibling node
+
+	// -------------------------------------------------------------------------
+	inline int get_block() { return block_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_num_entries() { return num_entries_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_level() { return level_; }
+
+	// -------------------------------------------------------------------------
+	//	<level>: SIZECHAR
+	//	<num_entries> <left_sibling> and <right_sibling>: SIZEINT
+	//  get header size in b-node
+	// -------------------------------------------------------------------------
+	inline int get_header_size() { return SIZECHAR+SIZEINT*3; } 
+
+	// -------------------------------------------------------------------------
+	inline float get_key_of_node() { return key_[0]; }	
+
+	inline int get_capacity_of_node() { return capacity_; }
+
+	// -------------------------------------------------------------------------
+	//  <level> is the first byte of a node in a block (with flags), followed
+	//  by <num_entries>, <left_sibling> and <right_sibling>
+	// -------------------------------------------------------------------------
+	static inline int level_of_buffer(const char *buf) {
+		return (int) buf[0] & LEVEL_MASK;
+	}
+
+	static inline int num_entries_of_buffer(const char *buf) {
+		int num = 0; memcpy(&num, &buf[SIZECHAR], SIZEINT); return num;
+	}
+
+	static inline int right_of_buffer(const char *buf) {
+		int right = 0; memcpy(&right, &buf[SIZECHAR + SIZEINT * 2], SIZEINT);
+		return right;
+	}
+
+	static inline void set_siblings_of_buffer(char *buf, int left, int right) {
+		memcpy(&buf[SIZECHAR + SIZEINT],     &left,  SIZEINT);
+		memcpy(&buf[SIZECHAR + SIZEINT * 2], &right, SIZEINT);
+	}
+
+	// -------------------------------------------------------------------------
+	inline bool isFull() { 
+		if (num_entries_ >= capacity_) return true; 
+		else return false; 
+	}
+
+	// -------------------------------------------------------------------------
+	inline void set_left_sibling(int left_sibling) { 
+		left_sibling_ = left_sibling; 
+		dirty_ = true;
+	}
+
+	// -------------------------------------------------------------------------
+	inline void set_right_sibling(int right_sibling) { 
+		right_sibling_ = right_sibling; 
+		dirty_ = true;
+	}
+
+	// -------------------------------------------------------------------------
+	inline int get_left_block() { return left_sibling_; }
+
+	inline int get_right_block() { return right_sibling_; }
+
+	// -------------------------------------------------------------------------
+	inline void move_to(int block) { // write the node to another block
+		block_ = block;
+		dirty_ = true;
+	}
+
+	// -------------------------------------------------------------------------
+	inline void set_clean() {		// written by its builder, not on delete
+		dirty_ = false;
+	}
+
+protected:
+	char  level_;					// level of b-tree (level > 0)
+	int   num_entries_;				// number of entries in this node
+	int   left_sibling_;			// addr in disk for left  sibling
+	int   right_sibling_;			// addr in disk for right sibling
+	float *key_;					// keys
+
+	bool  dirty_;					// if dirty, write back to file
+	int   block_;					// addr of disk for this node
+	int   capacity_;				// max num of entries can be stored
+	BTree *btree_;					// b-tree of this node
+};
+
+// -----------------------------------------------------------------------------
+//  BIndexNode: structure of index node in b-tree
+// -----------------------------------------------------------------------------
+class BIndexNode : public BNode {
+public:
+	BIndexNode();					// constructor
+	virtual ~BIndexNode();			// destructor
+
+	// -------------------------------------------------------------------------
+	virtual void init(				// init a new node, which not exist
+		int   level,					// level (depth) in b-tree
+		BTree *btree,					// b-tree of this node
+		int   near = -1);				// place after this block if free
+
+	void init_at(					// init a new node in an allocated block
+		int   level,					// level (depth) in b-tree
+		BTree *btree,					// b-tree of this node
+		int   block);					// address of file of this node
+
+	virtual void init_restore(		// load an exist node from disk to init
+		BTree *btree,					// b-tree of this node
+		int   block);					// address of file of this node
+
+	void init_restore(				// init an exist node from its block
+		BTree *btree,					// b-tree of this node
+		int   block,					// address of file of this node
+		const char *blk);				// content of the block
+
+	// -------------------------------------------------------------------------
+	virtual void read_from_buffer(	// read a b-node from buffer
+		const char *buf);				// store info of a b-node
+
+	virtual void write_to_buffer(	// write a b-node into buffer
+		char *buf);						// store info of a b-node (return)
+
+	// -------------------------------------------------------------------------
+	//  entry: <key_>: SIZEFLOAT and <son_>: SIZEINT
+	// -------------------------------------------------------------------------
+	virtual inline int get_entry_size() { return SIZEFLOAT + SIZEINT; }
+
+	// -------------------------------------------------------------------------
+	//  NODE_FORMAT_PACKED:    header, then pairs of <key> and <son>
+	//  NODE_FORMAT_SOA:       header padded to <CACHE_LINE> bytes, then all
+	//                         keys, then all sons from the next cache line
+	//  NODE_FORMAT_EYTZINGER: as NODE_FORMAT_SOA, but key[1..n] is in
+	//                         eytzinger (bfs) order and son[k] is the son to
+	//                         follow when key[k] is the first key > input
+	// -------------------------------------------------------------------------
+	static int get_capacity(		// max num of entries in a block
+		int b_length,					// block length
+		int format);					// format of index nodes
+
+	// -------------------------------------------------------------------------
+	static inline int get_key_slots(int capacity, int format) {
+		return format == NODE_FORMAT_EYTZINGER ? capacity + 1 : capacity;
+	}
+
+	// -------------------------------------------------------------------------
+	static inline int get_son_offset(int slots) { // offset of son[]
+		int key_end = CACHE_LINE + slots * SIZEFLOAT;
+		return (key_end + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+	}
+
+	// -------------------------------------------------------------------------
+	//  zero-copy access of a block of NODE_FORMAT_SOA or EYTZINGER
+	// -------------------------------------------------------------------------
+	static inline const float* keys_of_buffer(const char *buf) {
+		return (const float *) &buf[CACHE_LINE];
+	}
+
+	static inline const int* sons_of_buffer(const char *buf, int slots) {
+		return (const int *) &buf[get_son_offset(slots)];
+	}
+
+	// -------------------------------------------------------------------------
+	static void eytzinger_encode(	// sorted entries to eytzinger order
+		const float *key,				// sorted keys
+		const int   *son,				// sons
+		int   num,						// num of entries
+		float *ekey,					// keys in eytzinger order (return)
+		int   *eson);					// sons in eytzinger order (return)
+
+	// -------------------------------------------------------------------------
+	static void eytzinger_decode(	// eytzinger order to sorted entries
+		const float *ekey,				// keys in eytzinger order
+		const int   *eson,				// sons in eytzinger order
+		int   num,						// num of entries
+		float *key,						// sorted keys (return)
+		int   *son);					// sons (return)
+
+	// -------------------------------------------------------------------------
+	static inline int eytzinger_search( // son to follow for input key
+		const float *ekey,				// keys in eytzinger order
+		const int   *eson,				// sons in eytzinger order
+		int   num,						// num of entries
+		float key)						// input key
+	{
+		int k = 1;					// branchless, 4 levels prefetched
+		while (k <= num) {
+			__builtin_prefetch(&ekey[k * (CACHE_LINE / SIZEFLOAT)]);
+			k = 2 * k + (ekey[k] <= key);
+		}
+		k >>= __builtin_ffs(~k);	// first key > input (0: none)
+		return eson[k];
+	}
+
+	// -------------------------------------------------------------------------
+	static int find_position(		// find pos just less than input key
+		const float *keys,				// sorted keys
+		int   num,						// num of keys
+		float key);						// input key
+
+	// -------------------------------------------------------------------------
+	virtual int find_position_by_key(// find pos just less than input key
+		float key);						// input key
+
+	// -------------------------------------------------------------------------
+	virtual inline float get_key(int index) { 
+		// assert(index >= 0 && index < num_entries_); 
+		return key_[index]; 
+	}
+
+	// -------------------------------------------------------------------------
+	virtual BIndexNode* get_left_sibling(); // get left sibling node
+
+	virtual BIndexNode* get_right_sibling(); // get right sibling node
+
+	// -------------------------------------------------------------------------
+	inline int get_son(int index) {	// get son indexed by <index>
+		// assert(index >= 0 && index < num_entries_); 
+		return son_[index]; 
+	}
+
+	// -------------------------------------------------------------------------
+	void add_new_child(				// add new child by its child node
+		float key,						// input key
+		int son);						// input son
+
+	// -------------------------------------------------------------------------
+	void insert_child(				// insert an entry at <pos> (not full)
+		int   pos,						// pos of new entry
+		float key,						// input key
+		int   son);						// input son
+
+	// -------------------------------------------------------------------------
+	void move_entries(				// move entries [from, num) to <dest>
+		int   from,						// first entry to move
+		BIndexNode *dest);				// node to append them to
+
+	// -------------------------------------------------------------------------
+	inline void set_key(int index, float key) {
+		key_[index] = key;
+		dirty_ = true;
+	}
+
+protected:
+	int *son_;						// addr of son node
+};
+
+
+// -----------------------------------------------------------------------------
+//  BLeafNode: structure of leaf node in b-tree
+// -----------------------------------------------------------------------------
+class BLeafNode : public BNode {
+public:
+	BLeafNode();					// constructor
+	virtual ~BLeafNode();			// destructor
+
+	// -------------------------------------------------------------------------
+	virtual void init(				// init a new node, which not exist
+		int   level,					// level (depth) in b-tree
+		BTree *btree,					// b-tree of this node
+		int   near = -1);				// place after this block if free
+
+	void init_at(					// init a new node in an allocated block
+		int   level,					// level (depth) in b-tree
+		BTree *btree,					// b-tree of this node
+		int   block);					// address of file of this node
+
+	virtual void init_restore(		// load an exist node from disk to init
+		BTree *btree,					// b-tree of this node
+		int   block);					// address of file of this node
+
+	void init_restore(				// init an exist node from its block
+		BTree *btree,					// b-tree of this node
+		int   block,					// address of file of this node
+		const char *blk);				// content of the block
+
+	// -------------------------------------------------------------------------
+	virtual void read_from_buffer(	// read a b-node from buffer
+		const char *buf);				// store info of a b-node
+
+	virtual void write_to_buffer(	// write a b-node into buffer
+		char *buf);						// store info of a b-node (return)
+
+	// -------------------------------------------------------------------------
+	virtual inline int get_entry_size() { return SIZEINT; }
+
+	// -------------------------------------------------------------------------
+	virtual int find_position_by_key( // find pos just less than input key
+		float key);						// input key
+
+	// -------------------------------------------------------------------------
+	virtual inline float get_key(int index) { 
+		// assert(index >= 0 && index < num_keys_);
+		return key_[index]; 
+	}
+
+	// -------------------------------------------------------------------------
+	virtual BLeafNode* get_left_sibling(); // get left sibling node
+
+	virtual BLeafNode* get_right_sibling(); // get right sibling node
+
+	// -------------------------------------------------------------------------
+	//  array of <key_> with number <capacity_keys_> + <number_keys_> (SIZEINT)
+	//  one key per <LEAF_NODE_SIZE> bytes of block by default; with another
+	//  stride, just enough keys for the ids which fit in the rest.
+	// -------------------------------------------------------------------------
+	inline int get_key_size(int block_length) { // block length
+		int stride = get_increment();
+		if (stride == LEAF_NODE_SIZE / SIZEINT) {
+			capacity_keys_ = (int) ceil((float) block_length / LEAF_NODE_SIZE);
+		}
+		else {
+			int room = block_length - get_header_size() - SIZEINT;
+			int capacity = room * stride / (SIZEFLOAT + stride * SIZEINT);
+			capacity_keys_ = (capacity + stride - 1) / stride;
+		}
+		return capacity_keys_ * SIZEFLOAT + SIZEINT;
+	} 
+
+	// -------------------------------------------------------------------------
+	int get_increment();			// num of ids per key (of the tree)
+
+	// -------------------------------------------------------------------------
+	inline int get_num_keys() { return num_keys_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_entry_id(int index) { 
+		// assert(index >= 0 && index < num_entries_); 
+		return id_[index];
+	}
+
+	// -------------------------------------------------------------------------
+	void add_new_child(				// add new child by input id and key
+		int id,							// input object id
+		float key);						// input key
+
+	// -------------------------------------------------------------------------
+	bool has_room(					// whether add_new_child(id, key) fits
+		int id,							// input object id
+		float key);						// input key
+
+	// -------------------------------------------------------------------------
+	//  updates of a leaf with full keys (<key_stride_> = 1, uncompressed)
+	// -------------------------------------------------------------------------
+	void insert_entry(				// insert an entry at <pos> (not full)
+		int   pos,						// pos of new entry
+		int   id,						// input object id
+		float key);						// input key
+
+	// -------------------------------------------------------------------------
+	void remove_entry(				// remove the entry at <pos>
+		int   pos);						// pos of entry
+
+	// -------------------------------------------------------------------------
+	void move_entries(				// move entries [from, num) to <dest>
+		int   from,						// first entry to move
+		BLeafNode *dest);				// node to append them to
+
+	// -------------------------------------------------------------------------
+	inline bool is_compressed() { return compressed_; }
+
+	// -------------------------------------------------------------------------
+	static void key_range_of_buffer(// first and last key of a leaf block
+		const char *buf,				// block of a leaf (not empty)
+		float &first,					// first key (return)
+		float &last);					// last key (return)
+
+protected:
+	int num_keys_;					// number of keys
+	int *id_;						// object id
+
+	int capacity_keys_;				// max num of keys can be stored
+
+	bool compressed_;				// frame-of-reference + bit-packing
+	uint32_t min_id_, max_id_;		// range of ids   (ordered, compressed)
+	uint32_t min_key_, max_key_;	// range of keys  (ordered, compressed)
+
+	// -------------------------------------------------------------------------
+	void init_capacity(				// init <capacity_> and <capacity_keys_>
+		int b_length);					// block length
+
+	// -------------------------------------------------------------------------
+	//  <num_keys_>: SIZEINT, base of keys and ids: SIZEINT * 2, bits of keys
+	//  and ids: SIZECHAR * 2
+	// -------------------------------------------------------------------------
+	inline int get_compressed_header_size() {
+		return get_header_size() + SIZEINT * 3 + SIZECHAR * 2;
+	}
+
+	// -------------------------------------------------------------------------
+	int get_compressed_size(		// bytes of a compressed leaf
+		int num_entries,				// num of entries
+		int num_keys,					// num of keys
+		uint32_t id_range,				// max id  - min id  (ordered)
+		uint32_t key_range);			// max key - min key (ordered)
+
+	// -------------------------------------------------------------------------
+	void read_compressed(const char *buf); // decode keys and ids
+
+	// -------------------------------------------------------------------------
+	void write_compressed(char *buf); // encode keys and ids
+
+	// -------------------------------------------------------------------------
+	static inline uint32_t id_to_ordered(int id) { // order-preserving
+		return (uint32_t) id ^ 0x80000000u;
+	}
+};
+
+#endif // __B_NODE_H
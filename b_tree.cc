@@ -1,510 +1,1790 @@
-#include "b_tree.h"
-
-// -----------------------------------------------------------------------------
-//  BTree: b-tree to index hash values produced by qalsh
-// -----------------------------------------------------------------------------
-BTree::BTree()						// default constructor
-{
-	root_     = -1;
-	file_     = NULL;
-	root_ptr_ = NULL;
-}
-
-// -----------------------------------------------------------------------------
-BTree::~BTree()						// destructor
-{
-	char *header = new char[file_->get_blocklength()];
-	write_header(header);			// write <root_> to <header>
-	file_->set_header(header);		// write back to disk
-	delete[] header; header = NULL;
-
-	if (root_ptr_ != NULL) {
-		delete root_ptr_; root_ptr_ = NULL;
-	}
-	if (file_ != NULL) {
-		delete file_; file_ = NULL;
-	}
-}
-
-// -----------------------------------------------------------------------------
-void BTree::init(					// init a new tree
-	int   b_length,						// block length
-	const char *fname)					// file name
-{
-	FILE *fp = fopen(fname, "r");
-	if (fp) {						// check whether the file exist
-		fclose(fp);					// ask whether replace?
-		// printf("The file \"%s\" exists. Replace? (y/n)", fname);
-
-		// char c = getchar();			// input 'Y' or 'y' or others
-		// getchar();					// input <ENTER>
-		// assert(c == 'y' || c == 'Y');
-		remove(fname);				// otherwise, remove existing file
-	}			
-	file_ = new BlockFile(b_length, fname); // b-tree stores here
-
-	// -------------------------------------------------------------------------
-	//  init the first node: to store <blocklength> (page size of a node),
-	//  <number> (number of nodes including both index node and leaf node), 
-	//  and <root> (address of root node)
-	// -------------------------------------------------------------------------
-	root_ptr_ = new BIndexNode();
-	root_ptr_->init(0, this);
-	//返回BIndexNode中的变量block_
-	root_ = root_ptr_->get_block();
-	//释放root-ptr的内存
-	delete_root();
-}
-
-// -----------------------------------------------------------------------------
-void BTree::init_restore(			// load the tree from a tree file
-	const char *fname)					// file name
-{
-	FILE *fp = fopen(fname, "r");	// check whether the file exists
-	if (!fp) {
-		printf("tree file %s does not exist\n", fname);
-		exit(1);
-	}
-	fclose(fp);
-
-	// -------------------------------------------------------------------------
-	//  it doesn't matter to initialize blocklength to 0.
-	//  after reading file, <blocklength> will be reinitialized by file.
-	// -------------------------------------------------------------------------
-	file_ = new BlockFile(0, fname);
-	root_ptr_ = NULL;
-
-	// -------------------------------------------------------------------------
-	//  read the content after first 8 bytes of first block into <header>
-	// -------------------------------------------------------------------------
-	char *header = new char[file_->get_blocklength()];
-	file_->read_header(header);		// read remain bytes from header
-	read_header(header);			// init <root> from <header>
-
-	delete[] header; header = NULL;
-}
-
-// -----------------------------------------------------------------------------
-int BTree::bulkload(				// bulkload a tree from memory
-	int   n,							// number of entries
-	const Result *table)				// hash table
-{
-	BIndexNode *index_child   = NULL;
-	BIndexNode *index_prev_nd = NULL;
-	BIndexNode *index_act_nd  = NULL;
-	BLeafNode  *leaf_child    = NULL;
-	BLeafNode  *leaf_prev_nd  = NULL;
-	BLeafNode  *leaf_act_nd   = NULL;
-
-	int   id    = -1;
-	int   block = -1;
-	float key   = MINREAL;
-
-	// -------------------------------------------------------------------------
-	//  build leaf node from <_hashtable> (level = 0)
-	// -------------------------------------------------------------------------
-	bool first_node  = true;		// determine relationship of sibling
-	int  start_block = 0;			// position of first node
-	int  end_block   = 0;			// position of last node
-
-	for (int i = 0; i < n; ++i) {
-		id  = table[i].id_;
-		key = table[i].key_;
-
-		if (!leaf_act_nd) {
-			leaf_act_nd = new BLeafNode();
-			leaf_act_nd->init(0, this);
-
-			if (first_node) {
-				first_node  = false; // init <start_block>
-				start_block = leaf_act_nd->get_block();
-			}
-			else {					// label sibling
-				leaf_act_nd->set_left_sibling(leaf_prev_nd->get_block());
-				leaf_prev_nd->set_right_sibling(leaf_act_nd->get_block());
-
-				delete leaf_prev_nd; leaf_prev_nd = NULL;
-			}
-			end_block = leaf_act_nd->get_block();
-		}							
-		leaf_act_nd->add_new_child(id, key); // add new entry
-
-		if (leaf_act_nd->isFull()) {// change next node to store entries
-			leaf_prev_nd = leaf_act_nd;
-			leaf_act_nd  = NULL;
-		}
-	}
-	if (leaf_prev_nd != NULL) {
-		delete leaf_prev_nd; leaf_prev_nd = NULL;
-	}
-	if (leaf_act_nd != NULL) {
-		delete leaf_act_nd; leaf_act_nd = NULL;
-	}
-
-	// -------------------------------------------------------------------------
-	//  stop condition: lastEndBlock == lastStartBlock (only one node, as root)
-	// -------------------------------------------------------------------------
-	int current_level    = 1;		// current level (leaf level is 0)
-	int last_start_block = start_block;	// build b-tree level by level
-	int last_end_block   = end_block;	// build b-tree level by level
-
-	while (last_end_block > last_start_block) {
-		first_node = true;
-		for (int i = last_start_block; i <= last_end_block; ++i) {
-			block = i;				// get <block>
-			if (current_level == 1) {
-				leaf_child = new BLeafNode();
-				leaf_child->init_restore(this, block);
-				key = leaf_child->get_key_of_node();
-
-				delete leaf_child; leaf_child = NULL;
-			}
-			else {
-				index_child = new BIndexNode();
-				index_child->init_restore(this, block);
-				key = index_child->get_key_of_node();
-
-				delete index_child; index_child = NULL;
-			}
-
-			if (!index_act_nd) {
-				index_act_nd = new BIndexNode();
-				index_act_nd->init(current_level, this);
-
-				if (first_node) {
-					first_node = false;
-					start_block = index_act_nd->get_block();
-				}
-				else {
-					index_act_nd->set_left_sibling(index_prev_nd->get_block());
-					index_prev_nd->set_right_sibling(index_act_nd->get_block());
-
-					delete index_prev_nd; index_prev_nd = NULL;
-				}
-				end_block = index_act_nd->get_block();
-			}						
-			index_act_nd->add_new_child(key, block); // add new entry
-
-			if (index_act_nd->isFull()) {
-				index_prev_nd = index_act_nd;
-				index_act_nd = NULL;
-			}
-		}
-		if (index_prev_nd != NULL) {// release the space
-			delete index_prev_nd; index_prev_nd = NULL;
-		}
-		if (index_act_nd != NULL) {
-			delete index_act_nd; index_act_nd = NULL;
-		}
-		
-		last_start_block = start_block;// update info
-		last_end_block = end_block;	// build b-tree of higher level
-		++current_level;
-	}
-	root_ = last_start_block;		// update the <root>
-
-	if (index_prev_nd != NULL) delete index_prev_nd; 
-	if (index_act_nd  != NULL) delete index_act_nd;
-	if (index_child   != NULL) delete index_child;
-	if (leaf_prev_nd  != NULL) delete leaf_prev_nd; 
-	if (leaf_act_nd   != NULL) delete leaf_act_nd; 	
-	if (leaf_child    != NULL) delete leaf_child; 
-
-	return 0;
-}
-
-// -----------------------------------------------------------------------------
-void BTree::load_root() 		// load root of b-tree
-{	
-	if (root_ptr_ == NULL) {
-		root_ptr_ = new BIndexNode();
-		root_ptr_->init_restore(this, root_);
-	}
-}
-
-// -----------------------------------------------------------------------------
-void BTree::delete_root()		// delete root of b-tree
-{
-	if (root_ptr_ != NULL) { delete root_ptr_; root_ptr_ = NULL; }
-}
-
-
-
-// pthread function
-// each worker builds a subtree
-static void* works(void* arg){
-    thread_arg* argument = (thread_arg*)arg;
-    int num_entries = argument->num_entries;
-    int start_entry = argument->start_entry;
-    int end_entry = start_entry + num_entries;
-    const Result* table = argument->table;
-    BTree* tree = argument->tree;
-    pthread_mutex_t* lock = argument->lock;
-    ret_arg* ret = (ret_arg*)malloc(sizeof(ret_arg));   //returns of each thread
-	std::set <int> myblocks;
-	int device = end_entry / num_entries;
-
-    BIndexNode *index_child   = NULL;
-	BIndexNode *index_prev_nd = NULL;
-	BIndexNode *index_act_nd  = NULL;
-	BLeafNode  *leaf_child    = NULL;
-	BLeafNode  *leaf_prev_nd  = NULL;
-	BLeafNode  *leaf_act_nd   = NULL;
-
-    int   id    = -1;
-	int   block = -1;
-	float key   = MINREAL;
-
-    bool first_node  = true;		// determine relationship of sibling
-	int  start_block = 0;			// position of first node
-	int  end_block   = 0;			// position of last node
-	int start = 0;
-	int end = 0;
-    printf("loading data: %d ~ %d\n",start_entry, end_entry);
-    for (int i = start_entry; i < end_entry; ++i) {
-		id  = table[i].id_;
-		key = table[i].key_;
-		if (!leaf_act_nd) {
-			leaf_act_nd = new BLeafNode();
-            pthread_mutex_lock(lock);
-			leaf_act_nd->init(0, tree);
-            pthread_mutex_unlock(lock);
-			myblocks.insert(leaf_act_nd->get_block());	//insert block
-
-			if (first_node) {
-				first_node  = false; // init <start_block>
-				start_block = leaf_act_nd->get_block();
-			}
-			else {					// label sibling
-				leaf_act_nd->set_left_sibling(leaf_prev_nd->get_block());
-				leaf_prev_nd->set_right_sibling(leaf_act_nd->get_block());
-				pthread_mutex_lock(lock);
-				delete leaf_prev_nd; leaf_prev_nd = NULL;
-            	pthread_mutex_unlock(lock);
-				
-			}
-			end_block = leaf_act_nd->get_block();
-		}							
-		leaf_act_nd->add_new_child(id, key); // add new entry
-
-		if (leaf_act_nd->isFull()) {// change next node to store entries
-			leaf_prev_nd = leaf_act_nd;
-			leaf_act_nd  = NULL;
-		}
-	}
-    if (leaf_prev_nd != NULL) {
-		pthread_mutex_lock(lock);
-		delete leaf_prev_nd; leaf_prev_nd = NULL;		
-        pthread_mutex_unlock(lock);
-	}
-	if (leaf_act_nd != NULL) {
-		pthread_mutex_lock(lock);
-		delete leaf_act_nd; leaf_act_nd = NULL;		
-        pthread_mutex_unlock(lock);
-	}
-    ret->start[start++] = start_block;
-    ret->end[end++] = end_block;
-
-    int current_level    = 1;		// current level (leaf level is 0)
-	int last_start_block = start_block;	// build b-tree level by level
-	int last_end_block   = end_block;	// build b-tree level by level
-	
-	while (last_end_block > last_start_block) {
-		
-		first_node = true;
-
-
-		for (int i = last_start_block; i <= last_end_block; ++i) {
-			if(myblocks.find(i)==myblocks.end()) continue;
-			block = i;				// get <block>
-			if (current_level == 1) {
-				leaf_child = new BLeafNode();
-                pthread_mutex_lock(lock);
-				leaf_child->init_restore(tree, block);
-				key = leaf_child->get_key_of_node();
-				delete leaf_child; leaf_child = NULL;
-            	pthread_mutex_unlock(lock);
-				
-			}
-			else {
-				index_child = new BIndexNode();
-                pthread_mutex_lock(lock);
-				index_child->init_restore(tree, block);
-				key = index_child->get_key_of_node();
-				delete index_child; index_child = NULL;
-            	pthread_mutex_unlock(lock);
-				
-			}
-
-			if (!index_act_nd) {
-				index_act_nd = new BIndexNode();
-                pthread_mutex_lock(lock);
-				index_act_nd->init(current_level, tree);
-                pthread_mutex_unlock(lock);
-				myblocks.insert(index_act_nd->get_block());
-				if (first_node) {
-					first_node = false;
-					start_block = index_act_nd->get_block();
-				}
-				else {
-					index_act_nd->set_left_sibling(index_prev_nd->get_block());
-					index_prev_nd->set_right_sibling(index_act_nd->get_block());
-					pthread_mutex_lock(lock);
-					delete index_prev_nd; index_prev_nd = NULL;
-            		pthread_mutex_unlock(lock);
-					
-				}
-				end_block = index_act_nd->get_block();
-			}						
-			index_act_nd->add_new_child(key, block); // add new entry
-
-			if (index_act_nd->isFull()) {
-				index_prev_nd = index_act_nd;
-				index_act_nd = NULL;
-			}
-		}
-		if (index_prev_nd != NULL) {// release the space
-			pthread_mutex_lock(lock);
-			delete index_prev_nd; index_prev_nd = NULL;	
-            pthread_mutex_unlock(lock);
-			
-		}
-		if (index_act_nd != NULL) {
-			pthread_mutex_lock(lock);
-			delete index_act_nd; index_act_nd = NULL;	
-            pthread_mutex_unlock(lock);
-			
-		}
-
-		ret->start[start++] = start_block;
-        ret->end[end++] = end_block;
-		last_start_block = start_block;// update info
-		last_end_block = end_block;	// build b-tree of higher level
-		++current_level;
-	}
-
-    ret->levels = current_level;
-	ret->root = last_start_block;
-	pthread_mutex_lock(lock);
-	if (index_prev_nd != NULL) delete index_prev_nd; 
-	if (index_act_nd  != NULL) delete index_act_nd;
-	if (index_child   != NULL) delete index_child;
-	if (leaf_prev_nd  != NULL) delete leaf_prev_nd; 
-	if (leaf_act_nd   != NULL) delete leaf_act_nd; 	
-	if (leaf_child    != NULL) delete leaf_child; 			
-    pthread_mutex_unlock(lock);
-	
-    pthread_exit((void*)ret);
-}
-
-
-int BTree::bulkload_parallel(
-    int n,
-    const Result *table,
-    int num_workers
-)
-{
-    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-    pthread_mutex_t* lock = &mutex;
-    pthread_t* threads = (pthread_t*)malloc(num_workers * sizeof(pthread_t));
-    thread_arg* args = (thread_arg*)malloc(num_workers * sizeof(thread_arg));
-
-    if (threads == NULL || args == NULL){
-        printf("create threads failed\n");
-        return 1;
-    }
-    pthread_mutex_lock(lock);
-    for (int i = 0; i < num_workers; i++){
-        args[i].table = table;
-        args[i].tree = this;
-        args[i].lock = lock;
-        args[i].start_entry = ceil(float(n) / num_workers) * i;
-        if(i != num_workers - 1){
-            args[i].num_entries = ceil(float(n) / num_workers);
-        }
-        else{
-            args[i].num_entries = n - (num_workers - 1) * ceil(float(n) / num_workers);
-        }
-
-        if(pthread_create(&(threads[i]), NULL, &works, 
-            (void*)(args + i)) != 0){
-                printf("create failed!");
-                return 1;
-            }
-    }
-    pthread_mutex_unlock(lock);
-
-    void* ret[16];
-	ret_arg* ra[16];
-    for(int i = 0; i < num_workers; i++){
-        pthread_join(threads[i], &(ret[i]));
-    }
-	printf("threads complete\n");
-	for(int i = 0; i < num_workers; i++) ra[i] = (ret_arg*)ret[i];
-    int levels = ra[0]->levels;
-    for(int i = 0; i < num_workers; i++){
-        assert(ra[i]->levels == levels);
-    }
-
-
-    //connect the leftmost nodes and rightmost nodes
-    for(int i = 0; i < levels; i++){
-		
-        if(i == 0){
-            BLeafNode* cur_first;
-            BLeafNode* cur_last;
-            BLeafNode* pre_first;
-            BLeafNode* pre_last;
-            for(int j = 0; j < num_workers; j++){
-                cur_first = new BLeafNode();
-                cur_first->init_restore(this, ra[j]->start[i]);
-                cur_last = new BLeafNode();
-                cur_last->init_restore(this, ra[j]->end[i]);
-                if(j != 0){
-                    cur_first->set_left_sibling(pre_last->get_block());
-                    pre_last->set_right_sibling(cur_first->get_block());
-                    delete pre_first;
-                    delete pre_last;
-                }
-                pre_first = cur_first;
-                pre_last = cur_last;
-            }
-            delete pre_first;   pre_first = NULL;
-            delete pre_last;    pre_last = NULL;
-        }
-        else{
-            BIndexNode* cur_first;
-            BIndexNode* cur_last;
-            BIndexNode* pre_first;
-            BIndexNode* pre_last;
-            for (int j = 0; j < num_workers; j++){
-                cur_first = new BIndexNode();
-                cur_first->init_restore(this, ra[j]->start[i]);
-                cur_last = new BIndexNode();
-                cur_last->init_restore(this, ra[j]->end[i]);
-                if(j != 0){
-                    cur_first->set_left_sibling(pre_last->get_block());
-                    pre_last->set_right_sibling(cur_first->get_block());
-                    delete pre_first;
-                    delete pre_last;
-                }
-                pre_first = cur_first;
-                pre_last = cur_last;
-            }
-            delete pre_first;   pre_first = NULL;
-            delete pre_last;    pre_last = NULL;
-        }
-    }
-	
-    BIndexNode* root = new BIndexNode();
-    root->init(levels, this);
-    for(int i = 0; i < num_workers; i++){
-        BIndexNode* son = new BIndexNode();
-        son->init_restore(this, ra[i]->root);
-        root->add_new_child(son->get_key_of_node(), son->get_block());
-        delete son;
-    }
-    root_ = root->get_block();
-    delete root; root = NULL;
-    return 0;
-}
\ No newline at end of file
+#include "b_tree.h"
+#include "bulk_loader.h"
+#include "task_pool.h"
+
+// -----------------------------------------------------------------------------
+//  BTree: b-tree to index hash values produced by qalsh
+// -----------------------------------------------------------------------------
+BTree::BTree()						// default constructor
+{
+	root_     = -1;
+	format_   = NODE_FORMAT_PACKED;
+	compress_ = false;
+	key_stride_ = LEAF_NODE_SIZE / SIZEINT;
+	numa_     = NULL;
+	file_     = NULL;
+	root_ptr_ = NULL;
+	seq_      = 0;
+	slot_     = 1;					// the first commit uses slot 0
+	committed_root_ = -1;
+	num_copied_ = 0;
+	wal_      = NULL;
+	pthread_mutex_init(&update_lock_, NULL);
+	checkpointing_ = false;
+	pthread_mutex_init(&snap_lock_, NULL);
+	pthread_cond_init(&snap_cond_, NULL);
+}
+
+// -----------------------------------------------------------------------------
+BTree::~BTree()						// destructor
+{
+	if (root_ptr_ != NULL) {		// written back before commit
+		delete root_ptr_; root_ptr_ = NULL;
+	}
+	if (wal_ != NULL) {				// clean shutdown: empty log
+		checkpoint();
+		delete wal_; wal_ = NULL;
+	}
+	if (root_ != committed_root_) commit(); // publish the last <root_>
+	pthread_mutex_destroy(&update_lock_);
+	pthread_cond_destroy(&snap_cond_);
+	pthread_mutex_destroy(&snap_lock_);
+
+	if (root_ptr_ != NULL) {
+		delete root_ptr_; root_ptr_ = NULL;
+	}
+	if (file_ != NULL) {
+		delete file_; file_ = NULL;
+	}
+	if (numa_ != NULL) {
+		delete numa_; numa_ = NULL;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  the threads of bulkload_parallel() are pinned to numa nodes, so that the
+//  slice of the table which a thread starts with is local to it, if the
+//  table is placed by NumaTopo::first_touch() with the same num of threads.
+// -----------------------------------------------------------------------------
+void BTree::enable_numa()			// numa-local threads of bulkload_parallel
+{
+	if (numa_ == NULL) numa_ = new NumaTopo();
+}
+
+// -----------------------------------------------------------------------------
+void BTree::init(					// init a new tree
+	int   b_length,						// block length
+	const char *fname,					// file name
+	int   format,						// format of index nodes
+	int   key_stride)					// num of ids per key in leaves
+{
+	FILE *fp = fopen(fname, "r");
+	if (fp) {						// check whether the file exist
+		fclose(fp);					// ask whether replace?
+		// printf("The file \"%s\" exists. Replace? (y/n)", fname);
+
+		// char c = getchar();			// input 'Y' or 'y' or others
+		// getchar();					// input <ENTER>
+		// assert(c == 'y' || c == 'Y');
+		::remove(fname);			// otherwise, remove existing file
+	}			
+	char wname[300];				// and its log of updates
+	sprintf(wname, "%s.wal", fname);
+	::remove(wname);
+	file_ = new BlockFile(b_length, fname); // b-tree stores here
+	format_ = format;
+	key_stride_ = MAX(key_stride, 1);
+
+	// -------------------------------------------------------------------------
+	//  init the first node: to store <blocklength> (page size of a node),
+	//  <number> (number of nodes including both index node and leaf node), 
+	//  and <root> (address of root node)
+	// -------------------------------------------------------------------------
+	root_ptr_ = new BIndexNode();
+	root_ptr_->init(0, this);
+	//返回BIndexNode中的变量block_
+	root_ = root_ptr_->get_block();
+	//释放root-ptr的内存
+	delete_root();
+}
+
+// -----------------------------------------------------------------------------
+void BTree::init_restore(			// load the tree from a tree file
+	const char *fname)					// file name
+{
+	FILE *fp = fopen(fname, "r");	// check whether the file exists
+	if (!fp) {
+		printf("tree file %s does not exist\n", fname);
+		exit(1);
+	}
+	fclose(fp);
+
+	// -------------------------------------------------------------------------
+	//  it doesn't matter to initialize blocklength to 0.
+	//  after reading file, <blocklength> will be reinitialized by file.
+	// -------------------------------------------------------------------------
+	file_ = new BlockFile(0, fname);
+	root_ptr_ = NULL;
+
+	// -------------------------------------------------------------------------
+	//  read the content after first 8 bytes of first block into <header>
+	// -------------------------------------------------------------------------
+	char *header = new_block(file_->get_blocklength());
+	file_->read_header(header);		// read remain bytes from header
+	if (!read_slots(header)) {		// old tree file: single header
+		read_header(header);
+		committed_root_ = root_;
+	}
+	delete_block(header); header = NULL;
+	if (file_->get_map_block() < 0) find_free_blocks();
+
+	char wname[300];				// redo the updates after a crash
+	wal_name(wname);
+	if (access(wname, F_OK) == 0) recover();
+}
+
+// -----------------------------------------------------------------------------
+//  a header slot is <magic>, <seq>, the header of tree (<root>, <format>,
+//  <key_stride>), <num_blocks>, the extent of the free map (HEADER_MAGIC2
+//  only) and the crc32c of them. the slot which has a valid crc and the
+//  larger <seq> is the committed tree. a slot being written by a crash is
+//  invalid, so the other one is used.
+// -----------------------------------------------------------------------------
+bool BTree::read_slots(				// load the newest valid header slot
+	const char *header)					// header of tree file
+{
+	int best = -1, best_seq = -1, best_len = 0, num_blocks = 0;
+	for (int s = 0; s < 2; ++s) {
+		const char *slot = &header[s * HEADER_SLOT];
+		int magic = 0, seq = 0, len = SIZEINT * 2 + SIZEINT * 3 + SIZEINT;
+		uint32_t crc = 0;
+		memcpy(&magic, slot, SIZEINT);
+		memcpy(&seq,   &slot[SIZEINT], SIZEINT);
+		if (magic == HEADER_MAGIC2) len += SIZEINT * 2;
+		else if (magic != HEADER_MAGIC) continue;
+		memcpy(&crc,   &slot[len], SIZEINT);
+		if (crc != crc32c(slot, len)) continue;
+		if (seq > best_seq) { best = s; best_seq = seq; best_len = len; }
+	}
+	if (best < 0) return false;
+
+	const char *slot = &header[best * HEADER_SLOT];
+	read_header(&slot[SIZEINT * 2]);
+	memcpy(&num_blocks, &slot[SIZEINT * 5], SIZEINT);
+
+	seq_  = best_seq;
+	slot_ = best;
+	committed_root_ = root_;
+	file_->set_committed(num_blocks, seq_); // the committed tree is read-only
+
+	if (best_len > SIZEINT * 6) {	// free map of the committed tree
+		int map_block = 0, map_num = 0;
+		memcpy(&map_block, &slot[SIZEINT * 6], SIZEINT);
+		memcpy(&map_num,   &slot[SIZEINT * 7], SIZEINT);
+		if (!file_->load_free_map(map_block, map_num)) {
+			printf("could not read the free map\n");
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  a tree file without free map (or with a lost one): the blocks which are
+//  not reachable from <root_> are free.
+// -----------------------------------------------------------------------------
+void BTree::find_free_blocks()		// rebuild free map from the tree
+{
+	std::vector<int> used;
+	if (root_ >= 0) collect_blocks(root_, used);
+	file_->init_free_map(used);
+}
+
+// -----------------------------------------------------------------------------
+//  shadow paging: the nodes of a committed tree are never written in place,
+//  a new tree (e.g., a rebuild by bulkload) only appends blocks. commit()
+//  makes them durable, then writes the other header slot with <seq> + 1
+//  and syncs again. a crash before the second sync leaves the old slot as
+//  the newest valid one, so a reader sees either the old tree or the new
+//  one. afterwards, the blocks of the new tree are read-only as well.
+// -----------------------------------------------------------------------------
+int BTree::commit()					// publish <root_> atomically
+{
+	if (!file_->save_free_map() || !file_->sync()) { // nodes before header
+		printf("could not sync the tree file\n");
+		return 1;
+	}
+	int  num_blocks = file_->get_num_of_blocks();
+	int  map_block  = file_->get_map_block();
+	int  map_num    = file_->get_map_num();
+	int  next = 1 - slot_;
+	int  seq  = seq_ + 1;
+	int  len  = SIZEINT * 2 + SIZEINT * 3 + SIZEINT * 3;
+	char slot[HEADER_SLOT];
+	memset(slot, 0, HEADER_SLOT);
+
+	int magic = HEADER_MAGIC2;
+	memcpy(slot, &magic, SIZEINT);
+	memcpy(&slot[SIZEINT], &seq, SIZEINT);
+	write_header(&slot[SIZEINT * 2]);
+	memcpy(&slot[SIZEINT * 5], &num_blocks, SIZEINT);
+	memcpy(&slot[SIZEINT * 6], &map_block,  SIZEINT);
+	memcpy(&slot[SIZEINT * 7], &map_num,    SIZEINT);
+	uint32_t crc = crc32c(slot, len);
+	memcpy(&slot[len], &crc, SIZEINT);
+
+	file_->put_bytes(slot, HEADER_SLOT, BFHEAD_LENGTH + next * HEADER_SLOT);
+	if (!file_->sync()) {
+		printf("could not sync the header of tree file\n");
+		return 1;
+	}
+	pthread_mutex_lock(&snap_lock_); // new pins see the new tree
+	seq_  = seq;
+	slot_ = next;
+	committed_root_ = root_;
+	file_->set_committed(num_blocks, seq_);
+	file_->reclaim(oldest_pinned());
+	pthread_mutex_unlock(&snap_lock_);
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+//  a new tree (by bulkload) replaces the committed one: once it is committed
+//  (as epoch <seq_>), the blocks of the old tree are freed, but they are not
+//  reused while a reader has pinned an older epoch.
+// -----------------------------------------------------------------------------
+int BTree::replace_tree(			// commit a new tree, free the old one
+	int old_root)						// root of the replaced tree
+{
+	if (commit()) return 1;
+	if (old_root < 0 || old_root == root_) return 0;
+
+	std::vector<int> blocks;
+	collect_blocks(old_root, blocks);
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		file_->free_block(blocks[i], seq_);
+	}
+	pthread_mutex_lock(&snap_lock_);
+	file_->reclaim(oldest_pinned());
+	pthread_mutex_unlock(&snap_lock_);
+
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+//  level by level from <root>: the sons of level 1 are the leaves, so they
+//  are not read.
+// -----------------------------------------------------------------------------
+void BTree::collect_blocks(			// all blocks of a tree
+	int   root,							// root of the tree
+	std::vector<int> &blocks)			// blocks (return)
+{
+	std::vector<int> cur(1, root), next;
+	char *blk = new_block(file_->get_blocklength());
+	while (!cur.empty()) {
+		next.clear();
+		for (size_t i = 0; i < cur.size(); ++i) {
+			blocks.push_back(cur[i]);
+			if (!file_->read_block(blk, cur[i])) {
+				printf("could not read node %d\n", cur[i]);
+				exit(1);
+			}
+			int level = BNode::level_of_buffer(blk);
+			if (level == 0) continue;
+
+			BIndexNode *node = new BIndexNode();
+			node->init_restore(this, cur[i], blk);
+			for (int j = 0; j < node->get_num_entries(); ++j) {
+				if (level == 1) blocks.push_back(node->get_son(j));
+				else next.push_back(node->get_son(j));
+			}
+			delete node; node = NULL;
+		}
+		cur.swap(next);
+	}
+	delete_block(blk); blk = NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  compaction: splits and rebuilds scatter the leaves over the file, so a
+//  scan of the leaf chain is random i/o. the leaves are copied in key order
+//  to one extent of free blocks (empty leaves are dropped), the index levels
+//  are built on them, and the new tree replaces the old one, whose blocks
+//  become free once no reader sees them. updates wait meanwhile.
+// -----------------------------------------------------------------------------
+int BTree::compact()				// rewrite leaves in key order
+{
+	pthread_mutex_lock(&update_lock_);
+	int ret = 0;
+	if (wal_ != NULL) ret = write_checkpoint(); // no dirty blocks
+	else if (root_ != committed_root_) ret = commit();
+	if (ret != 0 || root_ < 0) {
+		pthread_mutex_unlock(&update_lock_);
+		return ret;
+	}
+
+	// -------------------------------------------------------------------------
+	//  the leaves in key order: the leftmost one and its right siblings
+	// -------------------------------------------------------------------------
+	std::vector<int> leaves;
+	char *blk   = new_block(file_->get_blocklength());
+	int  block  = root_;
+	while (true) {
+		if (!file_->read_block(blk, block)) {
+			printf("could not read node %d\n", block);
+			exit(1);
+		}
+		if (BNode::level_of_buffer(blk) == 0) break;
+
+		BIndexNode *node = new BIndexNode();
+		node->init_restore(this, block, blk);
+		block = node->get_son(0);
+		delete node; node = NULL;
+	}
+	int leftmost = block;
+	for (; block != -1; block = BNode::right_of_buffer(blk)) {
+		if (!file_->read_block(blk, block)) {
+			printf("could not read leaf node %d\n", block);
+			exit(1);
+		}
+		if (BNode::num_entries_of_buffer(blk) > 0) leaves.push_back(block);
+	}
+	delete_block(blk); blk = NULL;
+	if (leaves.empty()) leaves.push_back(leftmost); // keep one leaf
+
+	// -------------------------------------------------------------------------
+	//  copy the leaves to an extent, then build the index levels on them
+	// -------------------------------------------------------------------------
+	int num   = (int) leaves.size();
+	int first = file_->alloc_blocks(num);
+	std::vector<int>   sons(num);
+	std::vector<float> keys(num);
+	for (int i = 0; i < num; ++i) {
+		BLeafNode *leaf = new BLeafNode();
+		leaf->init_restore(this, leaves[i]);
+		leaf->move_to(first + i);
+		leaf->set_left_sibling(i > 0 ? first + i - 1 : -1);
+		leaf->set_right_sibling(i + 1 < num ? first + i + 1 : -1);
+		sons[i] = first + i;
+		keys[i] = leaf->get_key_of_node();
+		delete leaf; leaf = NULL;	// written to its new block
+	}
+
+	int level = 1;
+	while (sons.size() > 1) {
+		std::vector<int>   up_sons;
+		std::vector<float> up_keys;
+		BIndexNode *act = NULL, *prev = NULL;
+		for (size_t i = 0; i < sons.size(); ++i) {
+			if (act == NULL) {
+				act = new BIndexNode();
+				act->init(level, this, prev ? prev->get_block() : sons.back());
+				if (prev != NULL) {
+					act->set_left_sibling(prev->get_block());
+					prev->set_right_sibling(act->get_block());
+					delete prev; prev = NULL;
+				}
+				up_sons.push_back(act->get_block());
+				up_keys.push_back(keys[i]);
+			}
+			act->add_new_child(keys[i], sons[i]);
+			if (act->isFull()) { prev = act; act = NULL; }
+		}
+		if (prev != NULL) { delete prev; prev = NULL; }
+		if (act  != NULL) { delete act;  act  = NULL; }
+
+		sons.swap(up_sons);
+		keys.swap(up_keys);
+		++level;
+	}
+	int old_root = root_;
+	root_ = sons[0];
+	ret = replace_tree(old_root);
+	pthread_mutex_unlock(&update_lock_);
+
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+//  MVCC: a reader pins the committed tree (<committed_root_>, <seq_>), and
+//  reads its blocks by BlockFile::read_version(), while writers keep
+//  updating and committing. pins wait while a checkpoint overwrites blocks
+//  of the committed tree, since the new images become visible only with
+//  the next epoch.
+// -----------------------------------------------------------------------------
+Snapshot* BTree::pin_snapshot()		// pin the committed tree for reads
+{
+	Snapshot *snap = new Snapshot();
+	pthread_mutex_lock(&snap_lock_);
+	while (checkpointing_) pthread_cond_wait(&snap_cond_, &snap_lock_);
+	snap->root_  = committed_root_;
+	snap->epoch_ = seq_;
+	pinned_.insert(seq_);
+	file_->reclaim(oldest_pinned());
+	pthread_mutex_unlock(&snap_lock_);
+
+	return snap;
+}
+
+// -----------------------------------------------------------------------------
+void BTree::release_snapshot(		// unpin a snapshot (and reclaim blocks)
+	Snapshot *snap)						// snapshot of pin_snapshot()
+{
+	pthread_mutex_lock(&snap_lock_);
+	pinned_.erase(pinned_.find(snap->epoch_));
+	file_->reclaim(oldest_pinned());
+	pthread_mutex_unlock(&snap_lock_);
+
+	delete snap;
+}
+
+// -----------------------------------------------------------------------------
+//  a scan descends to the first leaf which may hold <lo> and follows the
+//  right siblings, all read as of the snapshot. with sampled keys in leaves
+//  (<key_stride_> > 1), the ids of every group of <key_stride_> ids which
+//  may overlap [lo, hi] are returned (candidates), with the key of the group.
+// -----------------------------------------------------------------------------
+int BTree::range_scan(				// ids of keys in [lo, hi] of a snapshot
+	const Snapshot *snap,				// snapshot
+	float lo,							// lower bound of keys
+	float hi,							// upper bound of keys
+	std::vector<int> &ids,				// ids in key order (return)
+	std::vector<float> *keys)			// keys of <ids> (return)
+{
+	int  num   = (int) ids.size();
+	int  block = snap->root_;
+	char *blk  = new_block(file_->get_blocklength());
+	while (block != -1) {			// descend
+		if (!file_->read_version(blk, block, snap->epoch_)) {
+			printf("could not read node %d\n", block);
+			exit(1);
+		}
+		if (BNode::level_of_buffer(blk) == 0) break;
+
+		BIndexNode *node = new BIndexNode();
+		node->init_restore(this, block, blk);
+		int p = node->get_num_entries() - 1;
+		while (p > 0 && node->get_key(p) >= lo) --p;
+		block = node->get_son(MAX(p, 0));
+		delete node; node = NULL;
+	}
+
+	bool done = false;
+	while (block != -1 && !done) {	// scan the leaf chain
+		BLeafNode *leaf = new BLeafNode();
+		leaf->init_restore(this, block, blk);
+		int stride   = leaf->get_increment();
+		int num_keys = leaf->get_num_keys();
+		int num_ids  = leaf->get_num_entries();
+		for (int j = 0; j < num_keys; ++j) {
+			float key = leaf->get_key(j);
+			if (key > hi) { done = true; break; }
+
+			float next = j + 1 < num_keys ? leaf->get_key(j + 1) : MAXREAL;
+			if (stride == 1 ? key < lo : next < lo) continue;
+			int end = MIN((j + 1) * stride, num_ids);
+			for (int i = j * stride; i < end; ++i) {
+				ids.push_back(leaf->get_entry_id(i));
+				if (keys != NULL) keys->push_back(key);
+			}
+		}
+		block = leaf->get_right_block();
+		delete leaf; leaf = NULL;
+
+		if (block != -1 && !done &&
+				!file_->read_version(blk, block, snap->epoch_)) {
+			printf("could not read leaf node %d\n", block);
+			exit(1);
+		}
+	}
+	delete_block(blk); blk = NULL;
+
+	return (int) ids.size() - num;
+}
+
+// -----------------------------------------------------------------------------
+//  online updates need full keys in leaves (<key_stride_> = 1) and are not
+//  applied to compressed leaves. an update changes the nodes in place, but
+//  the blocks of the committed tree only change in memory (the write-back
+//  mode of BlockFile) until a checkpoint, while new blocks (splits) are
+//  appended. so the file keeps the committed tree, and the log is enough to
+//  redo the updates after it.
+// -----------------------------------------------------------------------------
+bool BTree::enable_wal()			// log updates in <fname>.wal
+{
+	pthread_mutex_lock(&update_lock_);
+	bool ok = open_wal();
+	pthread_mutex_unlock(&update_lock_);
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  <wal_> is published only after the write-back mode is on, so no update
+//  sees the log while the committed blocks are still read-only.
+// -----------------------------------------------------------------------------
+bool BTree::open_wal()				// enable_wal (hold update_lock_)
+{
+	if (wal_ != NULL) return true;
+	if (key_stride_ != 1) {
+		printf("updates need full keys in leaves (-stride 1)\n");
+		return false;
+	}
+	char wname[300];
+	wal_name(wname);
+	Wal *wal = new Wal();
+	if (!wal->open(wname, seq_)) {
+		delete wal; wal = NULL;
+		return false;
+	}
+	if (wal->get_base() != seq_) wal->reset(seq_); // already checkpointed
+	file_->enable_writeback();
+	wal_ = wal;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  the update is applied and logged under <update_lock_>, so the order of
+//  the log is the order of the updates. the wait for durability is outside
+//  of the lock: while one writer syncs the log, the others apply and log
+//  their updates, and then share the next sync (group commit). the first
+//  update opens the log; an update whose nodes could not be written is an
+//  error, is undone and is not logged. an update whose record was lost by
+//  a failed sync is taken back by its inverse, which is logged too: a
+//  checkpoint may have written the update before it is taken back.
+// -----------------------------------------------------------------------------
+int BTree::insert(					// insert an entry (durable on return)
+	float key,							// input key
+	int   id)							// input object id
+{
+	return update(WAL_INSERT, key, id);
+}
+
+// -----------------------------------------------------------------------------
+int BTree::remove(					// remove an entry (durable on return)
+	float key,							// input key
+	int   id)							// input object id
+{
+	return update(WAL_DELETE, key, id);
+}
+
+// -----------------------------------------------------------------------------
+int BTree::update(					// insert or remove an entry
+	int   type,							// WAL_INSERT or WAL_DELETE
+	float key,							// input key
+	int   id)							// input object id
+{
+	char rec[SIZEFLOAT + SIZEINT];
+	memcpy(rec, &key, SIZEFLOAT);
+	memcpy(&rec[SIZEFLOAT], &id, SIZEINT);
+
+	pthread_mutex_lock(&update_lock_);
+	bool ok = open_wal() && apply_update(type, key, id);
+	int64_t lsn = ok ? wal_->append(type, rec, sizeof(rec)) : 0;
+	pthread_mutex_unlock(&update_lock_);
+	if (!ok) return 1;
+
+	if (!wal_->commit(lsn)) {		// lost with its batch: take it back
+		int inverse = (type == WAL_INSERT) ? WAL_DELETE : WAL_INSERT;
+		pthread_mutex_lock(&update_lock_);
+		ok  = apply_update(inverse, key, id);
+		lsn = ok ? wal_->append(inverse, rec, sizeof(rec)) : 0;
+		pthread_mutex_unlock(&update_lock_);
+		if (!ok || !wal_->commit(lsn)) printf("could not take back update\n");
+		return 1;
+	}
+	if (wal_->get_size() > WAL_CHECKPOINT) checkpoint();
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+//  the blocks changed by the update keep their images (see end_undo()). if
+//  a node could not be written, the images are restored, the new blocks are
+//  free again and <root_> is the old one, so the nodes are as before.
+// -----------------------------------------------------------------------------
+bool BTree::apply_update(			// apply an update, undo it on error
+	int   type,							// WAL_INSERT or WAL_DELETE
+	float key,							// input key
+	int   id)							// input object id
+{
+	int errors = file_->get_write_errors();
+	int root   = root_;
+
+	file_->begin_undo();
+	bool ok = (type == WAL_INSERT) ? apply_insert(key, id) :
+		apply_remove(key, id);
+	if (file_->get_write_errors() != errors) ok = false;
+	if (!ok) root_ = root;
+	file_->end_undo(ok);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+int BTree::checkpoint()				// write back updates, reset the log
+{
+	pthread_mutex_lock(&update_lock_);
+	int ret = (wal_ != NULL) ? write_checkpoint() : 0;
+	pthread_mutex_unlock(&update_lock_);
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+//  the dirty blocks of the committed tree are first logged as images with a
+//  WAL_CKPT record (<root_>, <num_blocks>), then written in place and
+//  committed. a crash while they are written in place is repaired by the
+//  images; once the tree is committed (<seq_> + 1), the log is stale.
+// -----------------------------------------------------------------------------
+int BTree::write_checkpoint()		// checkpoint (hold update_lock_)
+{
+	if (!wal_->flush() || !file_->sync()) {
+		printf("could not sync before checkpoint\n");
+		return 1;
+	}
+	std::vector<int>   index;
+	std::vector<char*> blocks;
+	file_->get_dirty(index, blocks);
+
+	int  b_length = file_->get_blocklength();
+	char *rec = new char[SIZEINT + b_length];
+	for (size_t i = 0; i < index.size(); ++i) {
+		memcpy(rec, &index[i], SIZEINT);
+		memcpy(&rec[SIZEINT], blocks[i], b_length);
+		wal_->append(WAL_IMAGE, rec, SIZEINT + b_length);
+	}
+	delete[] rec; rec = NULL;
+	if (!wal_->flush()) return 1;	// images before the checkpoint record
+
+	int ckpt[2] = { root_, file_->get_num_of_blocks() };
+	wal_->append(WAL_CKPT, (const char *) ckpt, sizeof(ckpt));
+	if (!wal_->flush()) return 1;
+
+	pthread_mutex_lock(&snap_lock_);	// no new pins until the commit
+	checkpointing_ = true;
+	pthread_mutex_unlock(&snap_lock_);
+
+	bool ok = true;
+	for (size_t i = 0; i < index.size(); ++i) {
+		if (!file_->write_image(blocks[i], index[i])) ok = false;
+	}
+	if (ok && commit()) ok = false;
+
+	pthread_mutex_lock(&snap_lock_);
+	checkpointing_ = false;
+	pthread_cond_broadcast(&snap_cond_);
+	pthread_mutex_unlock(&snap_lock_);
+	if (!ok) return 1;
+	file_->clear_dirty();
+
+	return wal_->reset(seq_) ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+//  the log applies to the committed tree of seq <base>. if the tree is newer,
+//  the log was checkpointed already. if it has a complete checkpoint, its
+//  images are written again and the tree is committed. otherwise, the blocks
+//  appended after the committed tree are dropped and the updates are redone.
+// -----------------------------------------------------------------------------
+void BTree::recover()				// redo the log after init_restore
+{
+	if (!enable_wal()) exit(1);
+
+	std::vector<WalRecord> recs;
+	if (!wal_->recover(recs)) exit(1);
+
+	int last_ckpt = -1;
+	for (int i = 0; i < (int) recs.size(); ++i) {
+		if (recs[i].type_ == WAL_CKPT) last_ckpt = i;
+	}
+	if (last_ckpt >= 0) {
+		for (int i = 0; i < last_ckpt; ++i) {
+			if (recs[i].type_ != WAL_IMAGE) continue;
+			int block = 0;
+			memcpy(&block, recs[i].data_, SIZEINT);
+			file_->write_image(&recs[i].data_[SIZEINT], block);
+		}
+		int ckpt[2];
+		memcpy(ckpt, recs[last_ckpt].data_, sizeof(ckpt));
+		root_ = ckpt[0];
+		int extra = file_->get_num_of_blocks() - ckpt[1];
+		if (extra > 0) file_->delete_last_blocks(extra);
+		find_free_blocks();			// nodes of the checkpoint may reuse
+		if (commit() || !wal_->reset(seq_)) exit(1);
+
+		printf("recovered checkpoint of %d blocks\n", last_ckpt);
+		return;
+	}
+	int extra = file_->get_num_of_blocks() - file_->committed_;
+	if (extra > 0) file_->delete_last_blocks(extra);
+
+	int num = 0;
+	for (size_t i = 0; i < recs.size(); ++i) {
+		float key = 0.0f;
+		int   id  = 0;
+		memcpy(&key, recs[i].data_, SIZEFLOAT);
+		memcpy(&id,  &recs[i].data_[SIZEFLOAT], SIZEINT);
+		if (recs[i].type_ == WAL_INSERT) apply_insert(key, id);
+		else if (recs[i].type_ == WAL_DELETE) apply_remove(key, id);
+		else continue;
+		++num;
+	}
+	if (num > 0) printf("redo %d updates of log\n", num);
+}
+
+// -----------------------------------------------------------------------------
+//  with <strict>, the son of the largest key < input is taken, i.e., the
+//  first leaf which may hold the key (keys of index nodes are lower bounds).
+// -----------------------------------------------------------------------------
+int BTree::find_path(				// descend to the leaf of a key
+	float key,							// input key
+	bool  strict,						// follow key < input (not <=)?
+	int   *path,						// blocks of path, leaf last (return)
+	int   *pos)							// son taken at each level (return)
+{
+	int  depth = 0;
+	int  block = root_;
+	char *blk  = new_block(file_->get_blocklength());
+	while (true) {
+		if (!file_->read_block(blk, block)) {
+			printf("could not read node %d\n", block);
+			exit(1);
+		}
+		if (BNode::level_of_buffer(blk) == 0) break;
+		assert(depth < MAX_LEVELS);
+
+		BIndexNode *node = new BIndexNode();
+		node->init_restore(this, block, blk);
+		int p = node->get_num_entries() - 1;
+		while (p > 0 && (strict ? node->get_key(p) >= key :
+				node->get_key(p) > key)) {
+			--p;
+		}
+		path[depth] = block;
+		pos[depth]  = MAX(p, 0);
+		block = node->get_son(pos[depth]);
+		++depth;
+		delete node; node = NULL;
+	}
+	delete_block(blk); blk = NULL;
+
+	path[depth] = block;
+	return depth;
+}
+
+// -----------------------------------------------------------------------------
+void BTree::link_right(				// link <node> -> <right> -> old right
+	BNode *node,						// node which is split
+	BNode *right)						// new right sibling of <node>
+{
+	int old_right = node->get_right_block();
+	right->set_left_sibling(node->get_block());
+	right->set_right_sibling(old_right);
+	node->set_right_sibling(right->get_block());
+	if (old_right == -1) return;
+
+	BNode *next = NULL;				// same level as <node>
+	if (node->get_level() == 0) next = new BLeafNode();
+	else next = new BIndexNode();
+	next->init_restore(this, old_right);
+	next->set_left_sibling(right->get_block());
+	delete next; next = NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  a full node is split in half, and the first key of the right half goes
+//  up to the parent (right after the son taken by the path). a split of the
+//  root adds a new root. a new first key of the leftmost leaf is copied up,
+//  so that the keys of index nodes stay lower bounds.
+// -----------------------------------------------------------------------------
+bool BTree::apply_insert(			// insert an entry into the nodes
+	float key,							// input key
+	int   id)							// input object id
+{
+	int path[MAX_LEVELS + 1];
+	int pos[MAX_LEVELS];
+	int depth = find_path(key, false, path, pos);
+
+	BLeafNode *leaf = new BLeafNode();
+	leaf->init_restore(this, path[depth]);
+	if (leaf->is_compressed()) {
+		printf("updates of compressed leaves are not supported\n");
+		delete leaf; leaf = NULL;
+		return false;
+	}
+	int p = leaf->get_num_entries();	// after the equal keys
+	while (p > 0 && leaf->get_key(p - 1) > key) --p;
+
+	if (p == 0) {					// new first key of leftmost path
+		for (int i = depth - 1; i >= 0; --i) {
+			BIndexNode *node = new BIndexNode();
+			node->init_restore(this, path[i]);
+			bool lower = node->get_key(pos[i]) > key;
+			if (lower) node->set_key(pos[i], key);
+			delete node; node = NULL;
+			if (!lower || pos[i] != 0) break;
+		}
+	}
+	if (!leaf->isFull()) {
+		leaf->insert_entry(p, id, key);
+		delete leaf; leaf = NULL;
+		return true;
+	}
+
+	BLeafNode *right = new BLeafNode();
+	right->init(0, this, leaf->get_block()); // next to <leaf> if free
+	int half = leaf->get_num_entries() / 2;
+	leaf->move_entries(half, right);
+	if (p <= half) leaf->insert_entry(p, id, key);
+	else right->insert_entry(p - half, id, key);
+	link_right(leaf, right);
+
+	float sep   = right->get_key_of_node();	// entry to add to the parent
+	int   son   = right->get_block();
+	float first = leaf->get_key_of_node();	// first key of a split root
+	int   level = 0;
+	delete leaf;  leaf  = NULL;
+	delete right; right = NULL;
+
+	for (int i = depth - 1; i >= 0; --i) {
+		BIndexNode *node = new BIndexNode();
+		node->init_restore(this, path[i]);
+		int at = pos[i] + 1;
+		if (!node->isFull()) {
+			node->insert_child(at, sep, son);
+			delete node; node = NULL;
+			return true;
+		}
+		BIndexNode *rnode = new BIndexNode();
+		rnode->init(node->get_level(), this, node->get_block());
+		int nhalf = node->get_num_entries() / 2;
+		node->move_entries(nhalf, rnode);
+		if (at <= nhalf) node->insert_child(at, sep, son);
+		else rnode->insert_child(at - nhalf, sep, son);
+		link_right(node, rnode);
+
+		sep   = rnode->get_key_of_node();
+		son   = rnode->get_block();
+		first = node->get_key_of_node();
+		level = node->get_level();
+		delete node;  node  = NULL;
+		delete rnode; rnode = NULL;
+	}
+	BIndexNode *root = new BIndexNode();	// the root is split
+	root->init(level + 1, this);
+	root->add_new_child(first, root_);
+	root->add_new_child(sep, son);
+	root_ = root->get_block();
+	delete root; root = NULL;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  the entry is searched from the first leaf which may hold <key> along the
+//  sibling chain. nodes are not merged: a leaf may become empty, and the
+//  keys of index nodes stay valid lower bounds.
+// -----------------------------------------------------------------------------
+bool BTree::apply_remove(			// remove an entry from the nodes
+	float key,							// input key
+	int   id)							// input object id
+{
+	int path[MAX_LEVELS + 1];
+	int pos[MAX_LEVELS];
+	int depth = find_path(key, true, path, pos);
+
+	int block = path[depth];
+	while (block != -1) {
+		BLeafNode *leaf = new BLeafNode();
+		leaf->init_restore(this, block);
+		if (leaf->is_compressed()) {
+			printf("updates of compressed leaves are not supported\n");
+			delete leaf; leaf = NULL;
+			return false;
+		}
+		int num = leaf->get_num_entries();
+		for (int i = 0; i < num; ++i) {
+			float k = leaf->get_key(i);
+			if (k > key) {
+				delete leaf; leaf = NULL;
+				return false;
+			}
+			if (k == key && leaf->get_entry_id(i) == id) {
+				leaf->remove_entry(i);
+				delete leaf; leaf = NULL;
+				return true;
+			}
+		}
+		block = leaf->get_right_block();
+		delete leaf; leaf = NULL;
+	}
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+//  one pass by a BulkLoader: every node is written once, when it is closed,
+//  and no node is read back to build the level above it.
+// -----------------------------------------------------------------------------
+int BTree::bulkload(				// bulkload a tree from memory
+	int   n,							// number of entries
+	const Result *table)				// hash table
+{
+	BulkLoader *loader = new BulkLoader();
+	loader->init(this);
+
+	PerfScope *leaf_scope = new PerfScope(PHASE_LEAF_BUILD);
+	loader->push_batch(n, table);	// finish() keeps the old tree if unsorted
+	delete leaf_scope; leaf_scope = NULL;
+
+	int ret = loader->finish();
+	delete loader; loader = NULL;
+
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+int BTree::first_leaf(				// descend to the leftmost leaf
+	const Snapshot *snap,				// snapshot
+	char  *blk)							// block of the leaf (return)
+{
+	int block = snap->root_;
+	while (true) {
+		if (!file_->read_version(blk, block, snap->epoch_)) {
+			printf("could not read node %d\n", block);
+			exit(1);
+		}
+		if (BNode::level_of_buffer(blk) == 0) break;
+
+		BIndexNode *node = new BIndexNode();
+		node->init_restore(this, block, blk);
+		block = node->get_son(0);
+		delete node; node = NULL;
+	}
+	return block;
+}
+
+// -----------------------------------------------------------------------------
+BTree* BTree::create_copy(			// new tree file with the same layout
+	const char *fname,					// file name
+	bool  compressed)					// build compressed leaves?
+{
+	BTree *tree = new BTree();
+	tree->init(file_->get_blocklength(), fname, format_, key_stride_);
+	tree->compress_ = compress_ || compressed;
+	if (file_->is_lz4()) tree->file_->enable_lz4();
+	if (file_->is_crc()) tree->file_->enable_crc(true);
+
+	return tree;
+}
+
+// -----------------------------------------------------------------------------
+//  rebuild streams the leaves of a pinned snapshot along the sibling chain
+//  into the bulk stream of a new tree file, so the copy is packed and its
+//  nodes are in key order, while this tree keeps serving reads and updates
+//  (the logged updates are checkpointed first, so they are in the copy).
+//  leaves are filled to <fill_factor> of their capacity, index nodes are
+//  full. with sampled keys, the ids of a group share the key of the group
+//  in the old leaf, so a new leaf only takes whole groups, and a group cut
+//  short in the old leaf (its last one) also ends the new leaf. otherwise
+//  the key of a group could be the key of an id of an earlier group, and
+//  a search would skip the ids of that earlier group.
+// -----------------------------------------------------------------------------
+int BTree::rebuild(					// packed copy of this tree in a new file
+	const char *new_fname,				// file name of the copy
+	float fill_factor)					// fill of leaves, in (0, 1]
+{
+	if (fill_factor <= 0.0f || fill_factor > 1.0f) {
+		printf("fill factor %f is not in (0, 1]\n", fill_factor);
+		return 1;
+	}
+	if (checkpoint()) return 1;		// copy logged updates too
+
+	Snapshot *snap = pin_snapshot();
+	char *blk   = new_block(file_->get_blocklength());
+	int  block  = first_leaf(snap, blk);
+	BTree *tree = create_copy(new_fname, (blk[0] & LEAF_COMPRESSED) != 0);
+
+	BLeafNode *leaf_prev_nd = NULL;
+	BLeafNode *leaf_act_nd  = NULL;
+	int  limit       = -1;			// max num of ids of a new leaf
+	int  start_block = 0;			// position of first node
+	int  end_block   = 0;			// position of last node
+
+	tree->file_->begin_bulk(BULK_BUFFER, true); // one sequential stream
+	PerfScope *leaf_scope = new PerfScope(PHASE_LEAF_BUILD);
+	while (block != -1) {
+		BLeafNode *leaf = new BLeafNode();
+		leaf->init_restore(this, block, blk);
+		int stride = leaf->get_increment();
+		int num    = leaf->get_num_entries();
+		for (int i = 0; i < num; ++i) {
+			int   id  = leaf->get_entry_id(i);
+			float key = leaf->get_key(i / stride);
+			if (leaf_act_nd && (leaf_act_nd->get_num_entries() >= limit ||
+					(i % stride == 0 &&
+						leaf_act_nd->get_num_entries() % stride != 0) ||
+					!leaf_act_nd->has_room(id, key))) {
+				leaf_prev_nd = leaf_act_nd;
+				leaf_act_nd  = NULL;
+			}
+			if (!leaf_act_nd) {
+				leaf_act_nd = new BLeafNode();
+				leaf_act_nd->init(0, tree);
+				if (leaf_prev_nd == NULL) {
+					start_block = leaf_act_nd->get_block();
+					int cap = leaf_act_nd->get_capacity_of_node();
+					limit = (int) (cap * fill_factor);
+					if (limit < cap) limit = MAX(limit / stride, 1) * stride;
+				}
+				else {
+					leaf_act_nd->set_left_sibling(leaf_prev_nd->get_block());
+					leaf_prev_nd->set_right_sibling(leaf_act_nd->get_block());
+
+					delete leaf_prev_nd; leaf_prev_nd = NULL;
+				}
+				end_block = leaf_act_nd->get_block();
+			}
+			leaf_act_nd->add_new_child(id, key);
+		}
+		block = leaf->get_right_block();
+		delete leaf; leaf = NULL;
+
+		if (block != -1 && !file_->read_version(blk, block, snap->epoch_)) {
+			printf("could not read leaf node %d\n", block);
+			exit(1);
+		}
+	}
+	delete_block(blk); blk = NULL;
+	release_snapshot(snap); snap = NULL;
+
+	if (leaf_act_nd == NULL && leaf_prev_nd == NULL) { // empty tree
+		leaf_act_nd = new BLeafNode();
+		leaf_act_nd->init(0, tree);
+		start_block = end_block = leaf_act_nd->get_block();
+	}
+	if (leaf_prev_nd != NULL) {
+		delete leaf_prev_nd; leaf_prev_nd = NULL;
+	}
+	if (leaf_act_nd != NULL) {
+		delete leaf_act_nd; leaf_act_nd = NULL;
+	}
+	delete leaf_scope; leaf_scope = NULL;
+
+	tree->root_ = tree->build_index(start_block, end_block);
+	tree->file_->end_bulk();
+	int ret = tree->replace_tree(-1);
+	delete tree; tree = NULL;
+
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+//  LeafStream: the leaves of a new tree in its bulk stream, either built
+//  entry by entry or copied from blocks of another tree. the leaves are
+//  consecutive blocks, so the siblings of a leaf are the blocks next to it,
+//  and only the last leaf needs to be known to end the chain. a copy is kept
+//  until the next leaf starts for this reason.
+// -----------------------------------------------------------------------------
+class LeafStream {
+public:
+	int num_built_;					// num of leaves built
+	int num_copied_;				// num of leaves copied
+
+	// -------------------------------------------------------------------------
+	LeafStream(BTree *tree)			// constructor
+	{
+		tree_  = tree;
+		act_   = NULL;
+		copy_  = new_block(tree->file_->get_blocklength());
+		has_copy_    = false;
+		start_block_ = -1;
+		end_block_   = -1;
+		num_built_   = 0;
+		num_copied_  = 0;
+	}
+
+	// -------------------------------------------------------------------------
+	~LeafStream()					// destructor
+	{
+		delete_block(copy_); copy_ = NULL;
+	}
+
+	// -------------------------------------------------------------------------
+	void add(						// add an entry to the built leaf
+		int   id,						// input object id
+		float key)						// input key
+	{
+		if (act_ != NULL && !act_->has_room(id, key)) close(false);
+		if (has_copy_) close(false);
+		if (act_ == NULL) {
+			act_ = new BLeafNode();
+			act_->init(0, tree_);
+			start(act_->get_block());
+			if (act_->get_block() > start_block_) {
+				act_->set_left_sibling(act_->get_block() - 1);
+			}
+			++num_built_;
+		}
+		act_->add_new_child(id, key);
+	}
+
+	// -------------------------------------------------------------------------
+	void copy(						// copy a leaf block as it is
+		const char *blk)				// block of the leaf
+	{
+		close(false);
+		memcpy(copy_, blk, tree_->file_->get_blocklength());
+		has_copy_ = true;
+		++num_copied_;
+	}
+
+	// -------------------------------------------------------------------------
+	void finish(					// end the chain of leaves
+		int &start_block,				// first leaf (return)
+		int &end_block)					// last leaf (return)
+	{
+		if (act_ == NULL && !has_copy_ && start_block_ < 0) {
+			act_ = new BLeafNode();	// an empty tree has one leaf
+			act_->init(0, tree_);
+			start(act_->get_block());
+		}
+		close(true);
+		start_block = start_block_;
+		end_block   = end_block_;
+	}
+
+protected:
+	BTree *tree_;					// the new tree
+	BLeafNode *act_;				// leaf being built (NULL: none)
+	char  *copy_;					// copied leaf, not written yet
+	bool  has_copy_;				// whether <copy_> is kept
+	int   start_block_;				// first leaf
+	int   end_block_;				// last leaf
+
+	// -------------------------------------------------------------------------
+	void start(int block)			// a leaf starts at <block>
+	{
+		if (start_block_ < 0) start_block_ = block;
+		end_block_ = block;
+	}
+
+	// -------------------------------------------------------------------------
+	void close(bool last)			// write the open leaf
+	{
+		if (act_ != NULL) {
+			act_->set_right_sibling(last ? -1 : act_->get_block() + 1);
+			delete act_; act_ = NULL;
+		}
+		if (has_copy_) {
+			int block = tree_->file_->get_num_of_blocks(); // next in stream
+			start(block);
+			BNode::set_siblings_of_buffer(copy_,
+				block > start_block_ ? block - 1 : -1, last ? -1 : block + 1);
+			tree_->file_->append_block(copy_);
+			has_copy_ = false;
+		}
+	}
+};
+
+// -----------------------------------------------------------------------------
+//  merge writes the entries of this tree (as of a snapshot) and a sorted
+//  <delta> in key order into a new tree file, in one pass over the leaf
+//  chain. a delta entry comes after the entries of the same key, also of
+//  the next leaves. a leaf whose keys are all below the next delta key is
+//  copied as a block, and only its siblings are changed; the other leaves
+//  are decoded, merged and packed. the index levels are built as bulkload()
+//  does. like updates, this needs full keys in leaves (<key_stride_> = 1).
+// -----------------------------------------------------------------------------
+int BTree::merge(					// merge a sorted delta into a new file
+	const char *new_fname,				// file name of the merged tree
+	int   n,							// number of delta entries
+	const Result *delta)				// delta entries, sorted by key
+{
+	if (key_stride_ != 1) {
+		printf("merge needs full keys in leaves (stride 1)\n");
+		return 1;
+	}
+	for (int j = 1; j < n; ++j) {
+		if (delta[j].key_ < delta[j - 1].key_) {
+			printf("delta is not sorted by key at %d\n", j);
+			return 1;
+		}
+	}
+	if (checkpoint()) return 1;		// merge logged updates too
+
+	Snapshot *snap = pin_snapshot();
+	char *blk   = new_block(file_->get_blocklength());
+	int  block  = first_leaf(snap, blk);
+	BTree *tree = create_copy(new_fname, (blk[0] & LEAF_COMPRESSED) != 0);
+
+	tree->file_->begin_bulk(BULK_BUFFER, true); // one sequential stream
+	PerfScope *leaf_scope = new PerfScope(PHASE_LEAF_BUILD);
+	LeafStream *leaves = new LeafStream(tree);
+	int j = 0;						// next delta entry
+	while (block != -1) {
+		int num = BNode::num_entries_of_buffer(blk);
+		if (num > 0) {
+			float first = MINREAL, last = MINREAL;
+			BLeafNode::key_range_of_buffer(blk, first, last);
+			for (; j < n && delta[j].key_ < first; ++j) {
+				leaves->add(delta[j].id_, delta[j].key_);
+			}
+			if (j == n || delta[j].key_ > last) leaves->copy(blk);
+			else {
+				BLeafNode *leaf = new BLeafNode();
+				leaf->init_restore(this, block, blk);
+				for (int i = 0; i < num; ++i) {
+					float key = leaf->get_key(i);
+					for (; j < n && delta[j].key_ < key; ++j) {
+						leaves->add(delta[j].id_, delta[j].key_);
+					}
+					leaves->add(leaf->get_entry_id(i), key);
+				}
+				delete leaf; leaf = NULL;
+			}
+		}
+		block = BNode::right_of_buffer(blk);
+		if (block != -1 && !file_->read_version(blk, block, snap->epoch_)) {
+			printf("could not read leaf node %d\n", block);
+			exit(1);
+		}
+	}
+	for (; j < n; ++j) leaves->add(delta[j].id_, delta[j].key_);
+	delete_block(blk); blk = NULL;
+	release_snapshot(snap); snap = NULL;
+
+	int start_block = 0, end_block = 0;
+	leaves->finish(start_block, end_block);
+	num_copied_ = leaves->num_copied_;
+	delete leaves; leaves = NULL;
+	delete leaf_scope; leaf_scope = NULL;
+
+	tree->root_ = tree->build_index(start_block, end_block);
+	tree->file_->end_bulk();
+	int ret = tree->replace_tree(-1);
+	delete tree; tree = NULL;
+
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+//  <delta_fname> is a binary file of Result (key, id) records.
+// -----------------------------------------------------------------------------
+int BTree::merge(					// merge a sorted delta file
+	const char *new_fname,				// file name of the merged tree
+	const char *delta_fname)			// file of delta, sorted by key
+{
+	FILE *fp = fopen(delta_fname, "rb");
+	if (!fp) {
+		printf("Could not open %s\n", delta_fname);
+		return 1;
+	}
+	fseek(fp, 0, SEEK_END);
+	int n = (int) (ftell(fp) / sizeof(Result));
+	fseek(fp, 0, SEEK_SET);
+
+	Result *delta = new Result[MAX(n, 1)];
+	bool ok = (int) fread(delta, sizeof(Result), n, fp) == n;
+	fclose(fp);
+	if (!ok) printf("could not read %s\n", delta_fname);
+
+	int ret = ok ? merge(new_fname, n, delta) : 1;
+	delete[] delta; delta = NULL;
+
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+//  <input> is the merge of an external sort (see ExtSort::open()), so that
+//  the table does not need to fit into memory: the runs are merged into a
+//  BulkLoader, which builds all levels in one pass.
+// -----------------------------------------------------------------------------
+int BTree::bulkload(				// bulkload a tree from sorted runs
+	ExtSort *input)						// runs of an external sort
+{
+	BulkLoader *loader = new BulkLoader();
+	loader->init(this);
+
+	PerfScope *leaf_scope = new PerfScope(PHASE_LEAF_BUILD);
+	Result r;
+	while (input->next(r)) loader->push(r.key_, r.id_);
+	delete leaf_scope; leaf_scope = NULL;
+
+	int ret = 1;
+	if (input->is_ok()) ret = loader->finish();
+	else printf("could not merge the runs of external sort\n");
+	delete loader; loader = NULL;
+
+	return ret;
+}
+
+// -----------------------------------------------------------------------------
+//  the leaves [start_block, end_block] are consecutive blocks of the bulk
+//  stream, and so are the nodes of every index level built on them.
+// -----------------------------------------------------------------------------
+int BTree::build_index(				// build index levels on a run of leaves
+	int start_block,					// first leaf (of bulk stream)
+	int end_block)						// last leaf (of bulk stream)
+{
+	BIndexNode *index_child   = NULL;
+	BIndexNode *index_prev_nd = NULL;
+	BIndexNode *index_act_nd  = NULL;
+	BLeafNode  *leaf_child    = NULL;
+
+	int   block = -1;
+	float key   = MINREAL;
+	bool  first_node = true;		// determine relationship of sibling
+
+	// -------------------------------------------------------------------------
+	//  stop condition: lastEndBlock == lastStartBlock (only one node, as root)
+	// -------------------------------------------------------------------------
+	int current_level    = 1;		// current level (leaf level is 0)
+	int last_start_block = start_block;	// build b-tree level by level
+	int last_end_block   = end_block;	// build b-tree level by level
+
+	while (last_end_block > last_start_block) {
+		PerfScope scope(PHASE_INDEX_BUILD);
+		first_node = true;
+		for (int i = last_start_block; i <= last_end_block; ++i) {
+			block = i;				// get <block>
+			if (current_level == 1) {
+				leaf_child = new BLeafNode();
+				leaf_child->init_restore(this, block);
+				key = leaf_child->get_key_of_node();
+
+				delete leaf_child; leaf_child = NULL;
+			}
+			else {
+				index_child = new BIndexNode();
+				index_child->init_restore(this, block);
+				key = index_child->get_key_of_node();
+
+				delete index_child; index_child = NULL;
+			}
+
+			if (!index_act_nd) {
+				index_act_nd = new BIndexNode();
+				index_act_nd->init(current_level, this);
+
+				if (first_node) {
+					first_node = false;
+					start_block = index_act_nd->get_block();
+				}
+				else {
+					index_act_nd->set_left_sibling(index_prev_nd->get_block());
+					index_prev_nd->set_right_sibling(index_act_nd->get_block());
+
+					delete index_prev_nd; index_prev_nd = NULL;
+				}
+				end_block = index_act_nd->get_block();
+			}						
+			index_act_nd->add_new_child(key, block); // add new entry
+
+			if (index_act_nd->isFull()) {
+				index_prev_nd = index_act_nd;
+				index_act_nd = NULL;
+			}
+		}
+		if (index_prev_nd != NULL) {// release the space
+			delete index_prev_nd; index_prev_nd = NULL;
+		}
+		if (index_act_nd != NULL) {
+			delete index_act_nd; index_act_nd = NULL;
+		}
+		
+		last_start_block = start_block;// update info
+		last_end_block = end_block;	// build b-tree of higher level
+		++current_level;
+	}
+	return last_start_block;		// the <root>
+}
+
+// -----------------------------------------------------------------------------
+//  descend from <root_> to the leaf level. since only one key of every
+//  <key_stride_> ids is kept in a leaf, the result is the leaf <block> and
+//  the <pos> of the first id covered by the largest key which is not larger
+//  than <key> (or the first id if there is no such key). with full keys
+//  (<key_stride_> = 1), <pos> is the exact entry of <key> if it exists.
+// -----------------------------------------------------------------------------
+int BTree::search(					// find the leaf entries of a key
+	float key,							// input key
+	int   *pos)							// pos of first candidate entry (return)
+{
+	int  block = -1;
+	search_batch(1, &key, &block, pos);
+	return block;
+}
+
+// -----------------------------------------------------------------------------
+//  the queries descend the tree level by level. all nodes needed by a level
+//  are read by one call of read_blocks, so with io_uring there are up to
+//  <URING_DEPTH> reads in flight instead of one. queries in sorted order
+//  share the reads of the same nodes. index nodes of NODE_FORMAT_SOA and
+//  NODE_FORMAT_EYTZINGER are searched in the read buffers without being
+//  copied into a node.
+// -----------------------------------------------------------------------------
+void BTree::search_batch(			// find the leaf entries of many keys
+	int   n,							// number of keys
+	const float *keys,					// input keys
+	int   *blocks,						// leaf block of each key (return)
+	int   *pos)							// pos of first candidate (return)
+{
+	int  b_length = file_->get_blocklength();
+	int  *index   = new int[SEARCH_BATCH];	// distinct blocks of a level
+	int  *slot    = new int[SEARCH_BATCH];	// slot of block of each query
+	char **bufs   = new char*[SEARCH_BATCH];
+	for (int i = 0; i < SEARCH_BATCH; ++i) bufs[i] = new_block(b_length);
+	int  capacity = BIndexNode::get_capacity(file_->get_payload_length(),
+		format_);
+	int  slots    = BIndexNode::get_key_slots(capacity, format_);
+
+	for (int start = 0; start < n; start += SEARCH_BATCH) {
+		int cnt  = MIN(SEARCH_BATCH, n - start);
+		int *blk = &blocks[start];
+		for (int i = 0; i < cnt; ++i) blk[i] = root_;
+
+		bool leaf_level = false;
+		while (!leaf_level) {
+			int num = 0;				// dedup blocks of adjacent queries
+			for (int i = 0; i < cnt; ++i) {
+				if (num == 0 || index[num - 1] != blk[i]) index[num++] = blk[i];
+				slot[i] = num - 1;
+			}
+			if (!file_->read_blocks(num, index, bufs)) {
+				printf("could not read the nodes of a level\n");
+				exit(1);
+			}
+
+			leaf_level = BNode::level_of_buffer(bufs[0]) == 0;
+			for (int i = 0; i < cnt; ) {
+				int s = slot[i];
+				if (leaf_level) {
+					BLeafNode *leaf = new BLeafNode();
+					leaf->init_restore(this, index[s], bufs[s]);
+					for (; i < cnt && slot[i] == s; ++i) {
+						int p = leaf->find_position_by_key(keys[start + i]);
+						pos[start + i] = MAX(p, 0) * leaf->get_increment();
+					}
+					delete leaf; leaf = NULL;
+				}
+				else if (format_ != NODE_FORMAT_PACKED) { // search in place
+					const char  *buf = bufs[s];
+					const float *key = BIndexNode::keys_of_buffer(buf);
+					const int   *son = BIndexNode::sons_of_buffer(buf, slots);
+					int num = BIndexNode::num_entries_of_buffer(buf);
+					for (; i < cnt && slot[i] == s; ++i) {
+						float k = keys[start + i];
+						if (format_ == NODE_FORMAT_EYTZINGER) {
+							blk[i] = BIndexNode::eytzinger_search(
+								key, son, num, k);
+						}
+						else {
+							int p = BIndexNode::find_position(key, num, k);
+							blk[i] = son[MAX(p, 0)];
+						}
+					}
+				}
+				else {
+					BIndexNode *node = new BIndexNode();
+					node->init_restore(this, index[s], bufs[s]);
+					for (; i < cnt && slot[i] == s; ++i) {
+						int p = node->find_position_by_key(keys[start + i]);
+						blk[i] = node->get_son(MAX(p, 0));
+					}
+					delete node; node = NULL;
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < SEARCH_BATCH; ++i) {
+		delete_block(bufs[i]); bufs[i] = NULL;
+	}
+	delete[] bufs;  bufs  = NULL;
+	delete[] slot;  slot  = NULL;
+	delete[] index; index = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BTree::load_root() 		// load root of b-tree
+{	
+	if (root_ptr_ == NULL) {
+		root_ptr_ = new BIndexNode();
+		root_ptr_->init_restore(this, root_);
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BTree::delete_root()		// delete root of b-tree
+{
+	if (root_ptr_ != NULL) { delete root_ptr_; root_ptr_ = NULL; }
+}
+
+// -----------------------------------------------------------------------------
+//  compressed leaves take as many entries as fit, so their boundaries are
+//  only known by filling them: a leaf is filled (but not written) until
+//  has_room() fails, the same as BulkLoader::push() does.
+// -----------------------------------------------------------------------------
+void BTree::count_leaves(			// greedy compressed leaves of entries
+	const Result *table,				// hash table
+	int   from,							// first entry
+	int   to,							// end entry
+	std::vector<int> &start)			// first entry of each leaf (return)
+{
+	BLeafNode *leaf = NULL;
+	for (int i = from; i < to; ++i) {
+		if (leaf != NULL && !leaf->has_room(table[i].id_, table[i].key_)) {
+			leaf->set_clean();
+			delete leaf; leaf = NULL;
+		}
+		if (leaf == NULL) {
+			leaf = new BLeafNode();
+			leaf->init_at(0, this, -1);
+			start.push_back(i);
+		}
+		leaf->add_new_child(table[i].id_, table[i].key_);
+	}
+	if (leaf != NULL) {
+		leaf->set_clean();
+		delete leaf; leaf = NULL;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  every node of the range is built from <plan> alone: the sons of an index
+//  node are blocks of the level below, and the key of a son is the first
+//  key of its leftmost leaf, which is read from the table. the siblings are
+//  the neighbor blocks of the level, so no node is read back or fixed up
+//  later. the nodes are encoded into <run>, which is written by one
+//  BlockFile::write_run() when it is full.
+// -----------------------------------------------------------------------------
+bool BTree::build_nodes(			// build nodes [from, to) of a level
+	const LoadPlan *plan,				// layout of the new tree
+	int   level,						// level (0: leaves)
+	int   from,							// first node of the level
+	int   to,							// end node of the level
+	char  *run,							// buffer of <run_cap> blocks
+	int   run_cap)						// num of blocks of <run>
+{
+	PerfScope scope(level == 0 ? PHASE_LEAF_BUILD : PHASE_INDEX_BUILD);
+	int  b_length = file_->get_blocklength();
+	int  run_base = plan->base_[level] + from;
+	int  run_num  = 0;
+	bool ok       = true;
+
+	int64_t span = 1;				// leaves under a son of this level
+	for (int l = 1; l < level; ++l) span *= plan->fanout_;
+
+	const Result *table = plan->table_;
+	int last = plan->num_[level] - 1;
+	for (int i = from; i < to; ++i) {
+		int  block = plan->base_[level] + i;
+		BNode *node = NULL;
+		if (level == 0) {
+			BLeafNode *leaf = new BLeafNode();
+			leaf->init_at(0, this, block);
+			for (int e = plan->start_[i]; e < plan->start_[i + 1]; ++e) {
+				leaf->add_new_child(table[e].id_, table[e].key_);
+			}
+			node = leaf;
+		}
+		else {
+			BIndexNode *index = new BIndexNode();
+			index->init_at(level, this, block);
+			int first = i * plan->fanout_;
+			int end   = MIN(first + plan->fanout_, plan->num_[level - 1]);
+			for (int son = first; son < end; ++son) {
+				float key = table[plan->start_[son * span]].key_;
+				index->add_new_child(key, plan->base_[level - 1] + son);
+			}
+			node = index;
+		}
+		node->set_left_sibling(i > 0 ? block - 1 : -1);
+		node->set_right_sibling(i < last ? block + 1 : -1);
+
+		char *blk = &run[(size_t) run_num * b_length];
+		memset(blk, 0, b_length);
+		node->write_to_buffer(blk);
+		node->set_clean();
+		delete node; node = NULL;
+
+		if (++run_num == run_cap || i == to - 1) {
+			if (!file_->write_run(run, run_base, run_num)) ok = false;
+			run_base += run_num;
+			run_num   = 0;
+		}
+	}
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+struct LoadTask {					// a task of bulkload_parallel()
+	int   level_;						// level (0: leaves)
+	int   from_;						// first node of the level
+	int   to_;							// end node of the level
+};
+
+// -----------------------------------------------------------------------------
+struct LoadJob {					// context of tasks of bulkload_parallel()
+	BTree *tree_;						// b-tree
+	LoadPlan *plan_;					// layout of the new tree
+	int   n_;							// number of entries
+	std::vector<std::vector<int> > start_; // leaves of each count task
+	std::vector<LoadTask> tasks_;		// build tasks
+	std::vector<char*> run_;			// run buffer of each thread
+};
+
+// -----------------------------------------------------------------------------
+static bool order_task(				// check the key order of a slice
+	void *ctx,							// the job (LoadJob)
+	int   task,							// slice of LOAD_TASK_ENTRIES entries
+	int   /* tid */)					// thread id
+{
+	LoadJob *job = (LoadJob *) ctx;
+	const Result *table = job->plan_->table_;
+	int from = (int) MAX((int64_t) task * LOAD_TASK_ENTRIES, (int64_t) 1);
+	int to   = (int) MIN((int64_t) (task + 1) * LOAD_TASK_ENTRIES,
+		(int64_t) job->n_);
+	for (int i = from; i < to; ++i) {	// [from - 1] ends the slice before
+		if (table[i].key_ < table[i - 1].key_) {
+			printf("bulkload: key %f after %f is not in order\n",
+				table[i].key_, table[i - 1].key_);
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool count_task(				// count the leaves of a slice of entries
+	void *ctx,							// the job (LoadJob)
+	int   task,							// slice of LOAD_TASK_ENTRIES entries
+	int   /* tid */)					// thread id
+{
+	LoadJob *job = (LoadJob *) ctx;
+	int from = (int) ((int64_t) task * LOAD_TASK_ENTRIES);
+	int to   = (int) MIN((int64_t) from + LOAD_TASK_ENTRIES, (int64_t) job->n_);
+	job->tree_->count_leaves(job->plan_->table_, from, to, job->start_[task]);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+static bool build_task(				// build a range of nodes of a level
+	void *ctx,							// the job (LoadJob)
+	int   task,							// index of <tasks_>
+	int   tid)							// thread id
+{
+	LoadJob  *job = (LoadJob *) ctx;
+	LoadTask &lt  = job->tasks_[task];
+	char *&run = job->run_[tid];	// by the thread: memory of its node
+	if (run == NULL) {
+		run = new_block(LOAD_TASK_NODES * job->tree_->file_->get_blocklength());
+	}
+	return job->tree_->build_nodes(job->plan_, lt.level_, lt.from_, lt.to_,
+		run, LOAD_TASK_NODES);
+}
+
+// -----------------------------------------------------------------------------
+//  the layout is planned before any node is built: plain leaves are full
+//  (the last one takes the rest), so leaf i starts at entry i * capacity
+//  and the levels are the same as those of bulkload(). compressed leaves
+//  are counted first by tasks of LOAD_TASK_ENTRIES entries, and a leaf does
+//  not span two tasks, so there may be a leaf per task more than in
+//  bulkload() (but the same for any num of threads). then the tree gets an
+//  extent of blocks, leaves first and level by level, and every level is
+//  split into tasks of LOAD_TASK_NODES nodes. the tasks are independent,
+//  since sons, keys and siblings of a node are known from the plan, so
+//  they run by work stealing (see run_tasks()) in any order, and the leaf
+//  chain is still one run of consecutive blocks. every thread encodes the
+//  nodes into a run buffer of its own, allocated by itself, so that it is
+//  memory of its node once it is pinned (see enable_numa()).
+//
+//  the key order is checked first, also by tasks of LOAD_TASK_ENTRIES
+//  entries: as in bulkload(), an unsorted table keeps the old tree.
+// -----------------------------------------------------------------------------
+int BTree::bulkload_parallel(		// bulkload b-tree by many threads
+	int   n,							// number of entries
+	const Result *table,				// hash table
+	int   num_workers)					// number of threads
+{
+	int old_root = committed_root_;	// rebuild: replaced by the new tree
+	int t = MAX(num_workers, 1);
+
+	LoadPlan *plan = new LoadPlan();
+	plan->table_  = table;
+	plan->fanout_ = BIndexNode::get_capacity(file_->get_payload_length(),
+		format_);
+
+	LoadJob *job = new LoadJob();
+	job->tree_ = this;
+	job->plan_ = plan;
+	job->n_    = n;
+
+	int num_slices = (int) (((int64_t) n + LOAD_TASK_ENTRIES - 1) /
+		LOAD_TASK_ENTRIES);
+	if (!run_tasks(num_slices, t, order_task, job, numa_)) {
+		delete job;  job  = NULL;
+		delete plan; plan = NULL;
+		return 1;					// keep the old tree
+	}
+
+	// -------------------------------------------------------------------------
+	//  the leaves: first entry of each one
+	// -------------------------------------------------------------------------
+	if (compress_) {
+		PerfScope scope(PHASE_LEAF_BUILD);
+		job->start_.resize(num_slices);
+		run_tasks(num_slices, t, count_task, job, numa_);
+
+		for (int i = 0; i < num_slices; ++i) {
+			plan->start_.insert(plan->start_.end(), job->start_[i].begin(),
+				job->start_[i].end());
+		}
+		std::vector<std::vector<int> >().swap(job->start_);
+	}
+	else {
+		BLeafNode *leaf = new BLeafNode();
+		leaf->init_at(0, this, -1);
+		int capacity = leaf->get_capacity_of_node();
+		leaf->set_clean();
+		delete leaf; leaf = NULL;
+
+		for (int i = 0; i < n; i += capacity) plan->start_.push_back(i);
+	}
+	if (plan->start_.empty()) plan->start_.push_back(0); // one empty leaf
+	plan->start_.push_back(n);
+
+	// -------------------------------------------------------------------------
+	//  the index levels: one extent of blocks for the whole tree
+	// -------------------------------------------------------------------------
+	int total = 0;
+	plan->height_ = 0;
+	plan->num_[0] = (int) plan->start_.size() - 1;
+	while (true) {
+		int l = plan->height_++;
+		total += plan->num_[l];
+		if (plan->num_[l] == 1) break;
+		if (plan->height_ == MAX_LEVELS) {
+			printf("bulkload: more than %d levels\n", MAX_LEVELS);
+			exit(1);
+		}
+		plan->num_[l + 1] = (plan->num_[l] + plan->fanout_ - 1) /
+			plan->fanout_;
+	}
+	plan->base_[0] = file_->alloc_blocks(total);
+	for (int l = 1; l < plan->height_; ++l) {
+		plan->base_[l] = plan->base_[l - 1] + plan->num_[l - 1];
+	}
+
+	for (int l = 0; l < plan->height_; ++l) {
+		for (int i = 0; i < plan->num_[l]; i += LOAD_TASK_NODES) {
+			LoadTask lt = { l, i, MIN(i + LOAD_TASK_NODES, plan->num_[l]) };
+			job->tasks_.push_back(lt);
+		}
+	}
+	job->run_.assign(t, NULL);
+	bool ok = run_tasks((int) job->tasks_.size(), t, build_task, job, numa_);
+	int  root = plan->base_[plan->height_ - 1];
+	int  base = plan->base_[0];
+
+	for (int j = 0; j < t; ++j) {
+		if (job->run_[j] != NULL) delete_block(job->run_[j]);
+	}
+	delete job;  job  = NULL;
+	delete plan; plan = NULL;
+
+	if (!ok) {						// keep the old tree
+		printf("could not write the nodes of bulkload\n");
+		file_->free_blocks(base, total);
+		return 1;
+	}
+	root_ = root;
+	return replace_tree(old_root);
+}
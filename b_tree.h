@@ -1,93 +1,306 @@
-#ifndef __B_TREE_H
-#define __B_TREE_H
-
-#include <iostream>
-#include <algorithm>
-#include <cassert>
-#include <cmath>
-#include <cstring>
-#include <stdlib.h>
-#include <pthread.h>
-#include <set>
-
-#include "def.h"
-#include "util.h"
-#include "block_file.h"
-#include "b_node.h"
-
-class  BlockFile;
-class  BNode;
-struct Result;
-
-// -----------------------------------------------------------------------------
-//  BTree: b-tree to index hash tables produced by qalsh
-// -----------------------------------------------------------------------------
-class BTree {
-public:
-	int root_;						// address of disk for root
-	BNode *root_ptr_;				// pointer of root
-	BlockFile *file_;				// file in disk to store
-	
-	// -------------------------------------------------------------------------
-	BTree();						// default constructor
-	~BTree();						// destructor
-
-	// -------------------------------------------------------------------------
-	void init(						// init a new b-tree
-		int   b_length,					// block length
-		const char *fname);				// file name	
-
-	// -------------------------------------------------------------------------
-	void init_restore(				// load an exist b-tree
-		const char *fname);				// file name
-
-	// -------------------------------------------------------------------------
-	int bulkload(					// bulkload b-tree from hash table in mem
-		int   n,						// number of entries
-		const Result *table);			// hash table
-	
-	int bulkload_parallel(
-    	int n,
-    	const Result *table,
-    	int num_workers);
-
-
-protected:
-	// -------------------------------------------------------------------------
-	inline int read_header(const char *buf) { // read <root> from buffer
-		memcpy(&root_, buf, SIZEINT);
-		return SIZEINT;
-	}
-
-	// -------------------------------------------------------------------------
-	inline int write_header(char *buf) { // write <root> into buffer
-		memcpy(buf, &root_, SIZEINT);
-		return SIZEINT;
-	}
-
-	// -------------------------------------------------------------------------
-	void load_root(); 				// load root of b-tree
-
-	// -------------------------------------------------------------------------
-	void delete_root(); 			// delete root of b-tree
-};
-
-// input argument
-typedef struct{
-	int num_entries;	//number of entries that this worker should deal with
-	int start_entry;	//the first entry 
-	const Result* table;
-	BTree * tree;
-	pthread_mutex_t* lock; //mutex lock
-}thread_arg;
-
-// output argument
-typedef struct{
-	int root;	//root block of subtree
-	int start[10];  //leftmost nodes in each layers
-	int end[10];	//rightmost nodes in each layers
-	int levels;				//level of root node
-}ret_arg;
-
-#endif // __B_TREE_H
-
+#ifndef __B_TREE_H
+#define __B_TREE_H
+
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdlib.h>
+#include <pthread.h>
+#include <set>
+
+#include "def.h"
+#include "util.h"
+#include "block_file.h"
+#include "wal.h"
+#include "b_node.h"
+#include "ext_sort.h"
+#include "numa_topo.h"
+
+class  BlockFile;
+class  BNode;
+class  BIndexNode;
+class  ExtSort;
+struct Result;
+
+// -----------------------------------------------------------------------------
+//  Snapshot: a committed tree pinned by a reader. its blocks are not reused
+//  and their images are kept (see BlockFile::write_image()) until released.
+// -----------------------------------------------------------------------------
+struct Snapshot {
+	int root_;						// root of the committed tree
+	int epoch_;						// epoch (seq) of the committed tree
+};
+
+// -----------------------------------------------------------------------------
+//  LoadPlan: layout of the tree built by BTree::bulkload_parallel(). leaf i
+//  holds the entries [start_[i], start_[i + 1]), node j of an index level
+//  has the sons [j * fanout_, (j + 1) * fanout_) of the level below, and
+//  the nodes of level l are the blocks [base_[l], base_[l] + num_[l]).
+// -----------------------------------------------------------------------------
+struct LoadPlan {
+	const Result *table_;			// entries
+	int   height_;					// num of levels
+	int   fanout_;					// max num of sons of an index node
+	int   num_[MAX_LEVELS];			// num of nodes of each level
+	int   base_[MAX_LEVELS];		// first block of each level
+	std::vector<int> start_;		// first entry of each leaf, then n
+};
+
+// -----------------------------------------------------------------------------
+//  BTree: b-tree to index hash tables produced by qalsh
+// -----------------------------------------------------------------------------
+class BTree {
+	friend class BulkLoader;		// publishes the tree it builds
+
+public:
+	int root_;						// address of disk for root
+	BNode *root_ptr_;				// pointer of root
+	BlockFile *file_;				// file in disk to store
+	int format_;					// format of index nodes (NODE_FORMAT_*)
+	bool compress_;					// build compressed leaves in bulkload
+	int key_stride_;				// num of ids per key in leaves
+	NumaTopo *numa_;				// numa nodes of threads (NULL: not pinned)
+
+	int seq_;						// seq of the committed header slot
+	int slot_;						// header slot of the committed tree
+	int committed_root_;			// <root_> of the committed tree
+	int num_copied_;				// leaves copied as blocks by merge()
+
+	Wal *wal_;						// redo log of updates (NULL: no updates)
+	pthread_mutex_t update_lock_;	// serialize updates and checkpoints
+
+	std::multiset<int> pinned_;		// epochs pinned by snapshots
+	bool checkpointing_;			// committed blocks being overwritten
+	pthread_mutex_t snap_lock_;		// protect snapshots and the publish
+	pthread_cond_t  snap_cond_;		// end of checkpoint (wakes pins)
+	
+	// -------------------------------------------------------------------------
+	BTree();						// default constructor
+	~BTree();						// destructor
+
+	// -------------------------------------------------------------------------
+	void init(						// init a new b-tree
+		int   b_length,					// block length
+		const char *fname,				// file name
+		int   format = NODE_FORMAT_PACKED, // format of index nodes
+		int   key_stride = LEAF_NODE_SIZE / SIZEINT); // ids per leaf key
+
+	// -------------------------------------------------------------------------
+	void init_restore(				// load an exist b-tree
+		const char *fname);				// file name
+
+	// -------------------------------------------------------------------------
+	void enable_numa();				// numa-local threads of bulkload_parallel
+
+	// -------------------------------------------------------------------------
+	int bulkload(					// bulkload b-tree from hash table in mem
+		int   n,						// number of entries
+		const Result *table);			// hash table
+	
+	int bulkload(					// bulkload b-tree from sorted runs
+		ExtSort *input);				// runs of an external sort (open)
+
+	int bulkload_parallel(			// bulkload b-tree by many threads
+		int   n,						// number of entries
+		const Result *table,			// hash table
+		int   num_workers);				// number of threads
+
+	// -------------------------------------------------------------------------
+	void count_leaves(				// greedy compressed leaves of entries
+		const Result *table,			// hash table
+		int   from,						// first entry
+		int   to,						// end entry
+		std::vector<int> &start);		// first entry of each leaf (return)
+
+	// -------------------------------------------------------------------------
+	bool build_nodes(				// build nodes [from, to) of a level
+		const LoadPlan *plan,			// layout of the new tree
+		int   level,					// level (0: leaves)
+		int   from,						// first node of the level
+		int   to,						// end node of the level
+		char  *run,						// buffer of <run_cap> blocks
+		int   run_cap);					// num of blocks of <run>
+
+	// -------------------------------------------------------------------------
+	int rebuild(					// packed copy of this tree in a new file
+		const char *new_fname,			// file name of the copy
+		float fill_factor = 1.0f);		// fill of leaves, in (0, 1]
+
+	// -------------------------------------------------------------------------
+	int merge(						// merge a sorted delta into a new file
+		const char *new_fname,			// file name of the merged tree
+		int   n,						// number of delta entries
+		const Result *delta);			// delta entries, sorted by key
+
+	int merge(						// merge a sorted delta file
+		const char *new_fname,			// file name of the merged tree
+		const char *delta_fname);		// file of delta, sorted by key
+
+	// -------------------------------------------------------------------------
+	int commit();					// publish <root_> atomically
+
+	// -------------------------------------------------------------------------
+	bool enable_wal();				// log updates in <fname>.wal
+
+	// -------------------------------------------------------------------------
+	int insert(						// insert an entry (durable on return)
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	int remove(						// remove an entry (durable on return)
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	int checkpoint();				// write back updates, reset the log
+
+	// -------------------------------------------------------------------------
+	int compact();					// rewrite leaves in key order
+
+	// -------------------------------------------------------------------------
+	Snapshot* pin_snapshot();		// pin the committed tree for reads
+
+	// -------------------------------------------------------------------------
+	void release_snapshot(			// unpin a snapshot (and reclaim blocks)
+		Snapshot *snap);				// snapshot of pin_snapshot()
+
+	// -------------------------------------------------------------------------
+	int range_scan(					// ids of keys in [lo, hi] of a snapshot
+		const Snapshot *snap,			// snapshot
+		float lo,						// lower bound of keys
+		float hi,						// upper bound of keys
+		std::vector<int> &ids,			// ids in key order (return)
+		std::vector<float> *keys = NULL); // keys of <ids> (return)
+
+	// -------------------------------------------------------------------------
+	int search(						// find the leaf entries of a key
+		float key,						// input key
+		int   *pos);					// pos of first candidate entry (return)
+
+	// -------------------------------------------------------------------------
+	void search_batch(				// find the leaf entries of many keys
+		int   n,						// number of keys
+		const float *keys,				// input keys
+		int   *blocks,					// leaf block of each key (return)
+		int   *pos);					// pos of first candidate (return)
+
+
+protected:
+	// -------------------------------------------------------------------------
+	//  <root>, <format> and <key_stride>: SIZEINT. the header of an old tree
+	//  file is 0 after <root>, so its <format> is NODE_FORMAT_PACKED and its
+	//  <key_stride> is the default one. the header is now kept in one of two
+	//  slots (see commit()), and the fields are the payload of a slot.
+	// -------------------------------------------------------------------------
+	inline int read_header(const char *buf) { // read <root> from buffer
+		memcpy(&root_,       buf,               SIZEINT);
+		memcpy(&format_,     &buf[SIZEINT],     SIZEINT);
+		memcpy(&key_stride_, &buf[SIZEINT * 2], SIZEINT);
+		if (key_stride_ <= 0) key_stride_ = LEAF_NODE_SIZE / SIZEINT;
+		return SIZEINT * 3;
+	}
+
+	// -------------------------------------------------------------------------
+	inline int write_header(char *buf) { // write <root> into buffer
+		memcpy(buf,               &root_,       SIZEINT);
+		memcpy(&buf[SIZEINT],     &format_,     SIZEINT);
+		memcpy(&buf[SIZEINT * 2], &key_stride_, SIZEINT);
+		return SIZEINT * 3;
+	}
+
+	// -------------------------------------------------------------------------
+	int first_leaf(					// descend to the leftmost leaf
+		const Snapshot *snap,			// snapshot
+		char  *blk);					// block of the leaf (return)
+
+	// -------------------------------------------------------------------------
+	BTree* create_copy(				// new tree file with the same layout
+		const char *fname,				// file name
+		bool  compressed);				// build compressed leaves?
+
+	// -------------------------------------------------------------------------
+	int build_index(				// build index levels on a run of leaves
+		int start_block,				// first leaf (of bulk stream)
+		int end_block);					// last leaf (of bulk stream)
+
+	// -------------------------------------------------------------------------
+	bool read_slots(				// load the newest valid header slot
+		const char *header);			// header of tree file
+
+	// -------------------------------------------------------------------------
+	void find_free_blocks();		// rebuild free map from the tree
+
+	// -------------------------------------------------------------------------
+	inline int oldest_pinned() {	// oldest pinned epoch (hold snap_lock_)
+		return pinned_.empty() ? MAXINT : *pinned_.begin();
+	}
+
+	// -------------------------------------------------------------------------
+	int replace_tree(				// commit a new tree, free the old one
+		int old_root);					// root of the replaced tree
+
+	// -------------------------------------------------------------------------
+	void collect_blocks(			// all blocks of a tree
+		int   root,						// root of the tree
+		std::vector<int> &blocks);		// blocks (return)
+
+	// -------------------------------------------------------------------------
+	inline void wal_name(char *fname) { // name of the log of tree file
+		sprintf(fname, "%s.wal", file_->fname_);
+	}
+
+	// -------------------------------------------------------------------------
+	void recover();					// redo the log after init_restore
+
+	// -------------------------------------------------------------------------
+	int write_checkpoint();			// checkpoint (hold update_lock_)
+
+	// -------------------------------------------------------------------------
+	bool open_wal();				// enable_wal (hold update_lock_)
+
+	// -------------------------------------------------------------------------
+	int find_path(					// descend to the leaf of a key
+		float key,						// input key
+		bool  strict,					// follow key < input (not <=)?
+		int   *path,					// blocks of path, leaf last (return)
+		int   *pos);					// son taken at each level (return)
+
+	// -------------------------------------------------------------------------
+	int update(						// insert or remove an entry
+		int   type,						// WAL_INSERT or WAL_DELETE
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	bool apply_update(				// apply an update, undo it on error
+		int   type,						// WAL_INSERT or WAL_DELETE
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	bool apply_insert(				// insert an entry into the nodes
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	bool apply_remove(				// remove an entry from the nodes
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	void link_right(				// link <node> -> <right> -> old right
+		BNode *node,					// node which is split
+		BNode *right);					// new right sibling of <node>
+
+	// -------------------------------------------------------------------------
+	void load_root(); 				// load root of b-tree
+
+	// -------------------------------------------------------------------------
+	void delete_root(); 			// delete root of b-tree
+};
+
+#endif // __B_TREE_H
+
@@ -0,0 +1,93 @@
+#include "bit_pack.h"
+
+#include <immintrin.h>
+
+// -----------------------------------------------------------------------------
+void bitpack_encode(				// pack values with frame-of-reference
+	const uint32_t *vals,				// values (each >= base)
+	int   num,							// num of values
+	uint32_t base,						// frame of reference
+	int   bits,							// bits per value
+	char  *out)							// packed values (return)
+{
+	memset(out, 0, bitpack_size(num, bits) + BITPACK_SLACK);
+	if (bits == 0) return;
+
+	for (int i = 0; i < num; ++i) {
+		int64_t  bit = (int64_t) i * bits;
+		uint64_t word = 0;
+		memcpy(&word, &out[bit >> 3], sizeof(word));
+		word |= (uint64_t) (vals[i] - base) << (bit & 7);
+		memcpy(&out[bit >> 3], &word, sizeof(word));
+	}
+}
+
+// -----------------------------------------------------------------------------
+static void decode_scalar(			// unpack values one by one
+	const char *in,						// packed values
+	int   from,							// first value to unpack
+	int   num,							// num of values
+	uint32_t base,						// frame of reference
+	int   bits,							// bits per value
+	uint32_t *vals)						// values (return)
+{
+	uint64_t mask = (bits == 32) ? 0xffffffffull : ((1ull << bits) - 1);
+	for (int i = from; i < num; ++i) {
+		int64_t  bit = (int64_t) i * bits;
+		uint64_t word = 0;
+		memcpy(&word, &in[bit >> 3], sizeof(word));
+		vals[i] = base + (uint32_t) ((word >> (bit & 7)) & mask);
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  8 values per step: gather the 32-bit word starting at the byte of each
+//  value, then shift, mask and add <base> in one register. a value must fit
+//  in the gathered word with its bit shift, i.e., <bits> <= 25.
+// -----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static int decode_avx2(				// unpack values by avx2
+	const char *in,						// packed values
+	int   num,							// num of values
+	uint32_t base,						// frame of reference
+	int   bits,							// bits per value
+	uint32_t *vals)						// values (return)
+{
+	const __m256i lane  = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i vbits = _mm256_set1_epi32(bits);
+	const __m256i vmask = _mm256_set1_epi32((int) ((1u << bits) - 1));
+	const __m256i vbase = _mm256_set1_epi32((int) base);
+	const __m256i seven = _mm256_set1_epi32(7);
+
+	int i = 0;
+	for (; i + 8 <= num; i += 8) {
+		__m256i idx   = _mm256_add_epi32(_mm256_set1_epi32(i), lane);
+		__m256i bit   = _mm256_mullo_epi32(idx, vbits);
+		__m256i byte  = _mm256_srli_epi32(bit, 3);
+		__m256i shift = _mm256_and_si256(bit, seven);
+
+		__m256i w = _mm256_i32gather_epi32((const int *) in, byte, 1);
+		w = _mm256_and_si256(_mm256_srlv_epi32(w, shift), vmask);
+		_mm256_storeu_si256((__m256i *) &vals[i], _mm256_add_epi32(w, vbase));
+	}
+	return i;
+}
+
+// -----------------------------------------------------------------------------
+void bitpack_decode(				// unpack values (avx2 if available)
+	const char *in,						// packed values
+	int   num,							// num of values
+	uint32_t base,						// frame of reference
+	int   bits,							// bits per value
+	uint32_t *vals)						// values (return)
+{
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+
+	if (bits == 0) {
+		for (int i = 0; i < num; ++i) vals[i] = base;
+		return;
+	}
+	int done = 0;
+	if (has_avx2 && bits <= 25) done = decode_avx2(in, num, base, bits, vals);
+	decode_scalar(in, done, num, base, bits, vals);
+}
@@ -0,0 +1,80 @@
+#ifndef __BIT_PACK_H
+#define __BIT_PACK_H
+
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  frame-of-reference + bit-packing of unsigned values: value i is stored as
+//  (v[i] - base) with <bits> bits, starting from bit i * <bits>. encoding and
+//  decoding may touch up to <BITPACK_SLACK> bytes after the packed values.
+// -----------------------------------------------------------------------------
+const int BITPACK_SLACK = 8;		// bytes reserved after packed values
+
+// -----------------------------------------------------------------------------
+inline int bitpack_width(			// num of bits to store values in [0, range]
+	uint32_t range)						// max value - base
+{
+	return range == 0 ? 0 : 32 - __builtin_clz(range);
+}
+
+// -----------------------------------------------------------------------------
+inline int bitpack_size(			// num of bytes of <num> packed values
+	int num,							// num of values
+	int bits)							// bits per value
+{
+	return (int) (((int64_t) num * bits + 7) / 8);
+}
+
+// -----------------------------------------------------------------------------
+//  order-preserving map between float and uint32_t, so that sorted keys can
+//  use frame-of-reference as well
+// -----------------------------------------------------------------------------
+inline uint32_t float_to_ordered(float key)
+{
+	uint32_t u = 0; memcpy(&u, &key, SIZEFLOAT);
+	return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+inline float ordered_to_float(uint32_t u)
+{
+	u = (u & 0x80000000u) ? (u & 0x7fffffffu) : ~u;
+	float key = 0.0f; memcpy(&key, &u, SIZEFLOAT);
+	return key;
+}
+
+// -----------------------------------------------------------------------------
+inline uint32_t bitpack_get(		// unpack value <i> only
+	const char *in,						// packed values
+	int   i,							// index of value
+	uint32_t base,						// frame of reference
+	int   bits)							// bits per value
+{
+	if (bits == 0) return base;
+	uint64_t mask = (bits == 32) ? 0xffffffffull : ((1ull << bits) - 1);
+	int64_t  bit  = (int64_t) i * bits;
+	uint64_t word = 0;
+	memcpy(&word, &in[bit >> 3], sizeof(word));
+	return base + (uint32_t) ((word >> (bit & 7)) & mask);
+}
+
+// -----------------------------------------------------------------------------
+void bitpack_encode(				// pack values with frame-of-reference
+	const uint32_t *vals,				// values (each >= base)
+	int   num,							// num of values
+	uint32_t base,						// frame of reference
+	int   bits,							// bits per value
+	char  *out);						// packed values (return)
+
+// -----------------------------------------------------------------------------
+void bitpack_decode(				// unpack values (avx2 if available)
+	const char *in,						// packed values
+	int   num,							// num of values
+	uint32_t base,						// frame of reference
+	int   bits,							// bits per value
+	uint32_t *vals);					// values (return)
+
+#endif // __BIT_PACK_H
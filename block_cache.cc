@@ -0,0 +1,128 @@
+#include "block_cache.h"
+
+// -----------------------------------------------------------------------------
+BlockCache::BlockCache(				// constructor
+	int capacity,						// max num of blocks in cache
+	int block_length)					// length of a block
+{
+	capacity_     = MAX(capacity, 1);
+	block_length_ = block_length;
+	num_          = 0;
+	head_         = -1;
+	tail_         = -1;
+
+	if (posix_memalign((void **) &data_, DIRECT_ALIGN,
+			(size_t) capacity_ * block_length_) != 0) {
+		printf("could not allocate cache of %d blocks\n", capacity_);
+		exit(1);
+	}
+	index_ = new int[capacity_];
+	prev_  = new int[capacity_];
+	next_  = new int[capacity_];
+	map_.reserve(capacity_);
+	pthread_mutex_init(&lock_, NULL);
+}
+
+// -----------------------------------------------------------------------------
+BlockCache::~BlockCache()			// destructor
+{
+	pthread_mutex_destroy(&lock_);
+	free(data_); data_ = NULL;
+	delete[] index_; index_ = NULL;
+	delete[] prev_;  prev_  = NULL;
+	delete[] next_;  next_  = NULL;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockCache::get(				// copy a block if it is cached
+	int  index,							// pos of the block
+	char *block)						// the block (return)
+{
+	pthread_mutex_lock(&lock_);
+	std::unordered_map<int, int>::iterator it = map_.find(index);
+	bool hit = (it != map_.end());
+	if (hit) {
+		int slot = it->second;
+		memcpy(block, &data_[(size_t) slot * block_length_], block_length_);
+		unlink(slot);
+		push_front(slot);
+	}
+	pthread_mutex_unlock(&lock_);
+	return hit;
+}
+
+// -----------------------------------------------------------------------------
+void BlockCache::put(				// cache a block (evict lru if full)
+	int  index,							// pos of the block
+	const char *block)					// the block
+{
+	pthread_mutex_lock(&lock_);
+	int slot = -1;
+	std::unordered_map<int, int>::iterator it = map_.find(index);
+	if (it != map_.end()) {			// update a cached block
+		slot = it->second;
+		unlink(slot);
+	}
+	else if (num_ < capacity_) {	// use a free slot
+		slot = num_++;
+		map_[index] = slot;
+	}
+	else {							// evict the lru block
+		slot = tail_;
+		unlink(slot);
+		map_.erase(index_[slot]);
+		map_[index] = slot;
+	}
+	index_[slot] = index;
+	memcpy(&data_[(size_t) slot * block_length_], block, block_length_);
+	push_front(slot);
+	pthread_mutex_unlock(&lock_);
+}
+
+// -----------------------------------------------------------------------------
+//  used when the last blocks of file are deleted. the freed slots are moved
+//  to the end of the lru list, so that they are reused first.
+// -----------------------------------------------------------------------------
+void BlockCache::erase_from(		// drop all blocks with pos >= <index>
+	int index)							// first pos to be dropped
+{
+	pthread_mutex_lock(&lock_);
+	int slot = head_;
+	while (slot != -1) {
+		int next = next_[slot];
+		if (index_[slot] >= index) {
+			map_.erase(index_[slot]);
+			index_[slot] = -1;
+			unlink(slot);
+
+			prev_[slot] = tail_;	// append to the end of lru list
+			next_[slot] = -1;
+			if (tail_ != -1) next_[tail_] = slot;
+			else head_ = slot;
+			tail_ = slot;
+		}
+		slot = next;
+		if (slot != -1 && index_[slot] == -1) break; // reached moved slots
+	}
+	pthread_mutex_unlock(&lock_);
+}
+
+// -----------------------------------------------------------------------------
+void BlockCache::unlink(int slot)	// remove <slot> from lru list
+{
+	if (prev_[slot] != -1) next_[prev_[slot]] = next_[slot];
+	else head_ = next_[slot];
+
+	if (next_[slot] != -1) prev_[next_[slot]] = prev_[slot];
+	else tail_ = prev_[slot];
+}
+
+// -----------------------------------------------------------------------------
+void BlockCache::push_front(int slot) // add <slot> as most recently used
+{
+	prev_[slot] = -1;
+	next_[slot] = head_;
+	if (head_ != -1) prev_[head_] = slot;
+	head_ = slot;
+	if (tail_ == -1) tail_ = slot;
+}
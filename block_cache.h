@@ -0,0 +1,65 @@
+#ifndef __BLOCK_CACHE_H
+#define __BLOCK_CACHE_H
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <pthread.h>
+#include <unordered_map>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  BlockCache: application-level LRU cache of blocks of a BlockFile. it keeps
+//  the blocks which are read from or written to the file (write-through), so
+//  that a file opened with O_DIRECT still has its hot nodes in memory
+//  without double-buffering them in the kernel page cache.
+// -----------------------------------------------------------------------------
+class BlockCache {
+public:
+	BlockCache(						// constructor
+		int capacity,					// max num of blocks in cache
+		int block_length);				// length of a block
+
+	// -------------------------------------------------------------------------
+	~BlockCache();					// destructor
+
+	// -------------------------------------------------------------------------
+	bool get(						// copy a block if it is cached
+		int  index,						// pos of the block
+		char *block);					// the block (return)
+
+	// -------------------------------------------------------------------------
+	void put(						// cache a block (evict lru if full)
+		int  index,						// pos of the block
+		const char *block);				// the block
+
+	// -------------------------------------------------------------------------
+	void erase_from(				// drop all blocks with pos >= <index>
+		int index);						// first pos to be dropped
+
+	// -------------------------------------------------------------------------
+	inline int get_capacity() { return capacity_; }
+
+protected:
+	int  capacity_;					// max num of blocks
+	int  block_length_;				// length of a block
+	int  num_;						// num of slots in use
+	char *data_;					// <capacity_> blocks (aligned)
+	int  *index_;					// pos of block in each slot
+	int  *prev_;					// lru list: more recently used slot
+	int  *next_;					// lru list: less recently used slot
+	int  head_;						// most  recently used slot
+	int  tail_;						// least recently used slot
+
+	std::unordered_map<int, int> map_; // pos of block -> slot
+	pthread_mutex_t lock_;			// protect all of the above
+
+	// -------------------------------------------------------------------------
+	void unlink(int slot);			// remove <slot> from lru list
+
+	// -------------------------------------------------------------------------
+	void push_front(int slot);		// add <slot> as most recently used
+};
+
+#endif // __BLOCK_CACHE_H
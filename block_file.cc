@@ -1,249 +1,1665 @@
-#include "block_file.h"
-
-// -----------------------------------------------------------------------------
-//  some points to NOTE:
-//  1) 2 types of block # are used (i.e. the internal # (e.g. act_block) 
-//     and external # (e.g. pos)). internal # is one larger than external #
-//     because the first block of the file is used to store header info. 
-//     data info is stored starting from the 2nd block (excluding the header
-//     block).both types of # start from 0.
-//
-//  2) "act_block" is internal block #. "number" is the # of data block (i.e. 
-//     excluding the header block). maximum actblock equals to number. Maximum 
-//     external block # equals to number - 1 
-//
-//  3) cache_cont records the internal numbers. 
-// -----------------------------------------------------------------------------
-BlockFile::BlockFile(				// constructor
-	int   b_length,						// block length
-	const char *name)					// file name
-{
-	strcpy(fname_, name);
-	//page size B
-	block_length_ = b_length;
-
-	num_blocks_ = 0;				// num of blocks, init to 0
-	// -------------------------------------------------------------------------
-	//  init <fp> and open <file_name_>. if <file_name_> exists, then fp != 0,
-	//  and we excute if-clause program. otherwise, we excute else-clause 
-	//  program.
-	//
-	//  "rb+": read or write data from or into binary doc. if the file not 
-	//  exist, it will return NULL.
-	// -------------------------------------------------------------------------
-	if ((fp_ = fopen(fname_, "rb+")) != 0) {
-		// ---------------------------------------------------------------------
-		//  init <new_flag_> (since the file exists, <new_flag_> is false).
-		//  reinit <block_length_> (determined by the doc itself).
-		//  reinit <num_blocks_> (number of blocks in doc itself).
-		// ---------------------------------------------------------------------
-		new_flag_ = false;			// reinit <block_length_> by file
-		block_length_ = fread_number();
-		num_blocks_ = fread_number();
-	}
-	else {
-		// ---------------------------------------------------------------------
-		//  init <new_flag_>: as file is just constructed (new), it is true.
-		//  write <block_length_> and <num_blocks_> to the header of file.
-		//  since the file is empty (new), <num_blocks_> is 0 (no blocks in it)
-		//
-		//  "wb+": read or write data from or into binary doc. if file not
-		//  exist, we will construct a new file.
-		// ---------------------------------------------------------------------
-		assert(block_length_ >= BFHEAD_LENGTH);
-
-		fp_ = fopen(fname_, "wb+");
-		new_flag_ = true;
-		fwrite_number(block_length_);
-		fwrite_number(0);
-
-		// ---------------------------------------------------------------------
-		//  since <block_length_> >= 8 bytes, for the remain bytes, we will 
-		//  init 0 to them.
-		//
-		//  ftell() return number of bytes from current position to the 
-		//  beginning position of the file.
-		// ---------------------------------------------------------------------
-		int  length = block_length_ - (int) ftell(fp_);
-		char *buffer = new char[length];
-
-		memset(buffer, 0, sizeof(buffer));
-		put_bytes(buffer, length);
-
-		delete[] buffer; buffer = NULL;
-	}
-	// -------------------------------------------------------------------------
-	//  Redirect file pointer to the start position of the file
-	// -------------------------------------------------------------------------
-	fseek(fp_, 0, SEEK_SET);
-	act_block_ = 0;					// init <act_block_> (no blocks)
-}
-
-// -----------------------------------------------------------------------------
-BlockFile::~BlockFile()				// destructor
-{
-	if (fp_) fclose(fp_);
-}
-
-// -----------------------------------------------------------------------------
-//  note that this func does not read the header of blockfile. it fetches the 
-//  info in the first block excluding the header of blockfile.
-// -----------------------------------------------------------------------------
-void BlockFile::read_header(		// read remain bytes excluding header
-	char *buffer)						// contain remain bytes (return)
-{
-	fseek(fp_, BFHEAD_LENGTH, SEEK_SET); // jump out of first 8 bytes
-	get_bytes(buffer, block_length_ - BFHEAD_LENGTH); // read remaining bytes
-
-	if (num_blocks_ < 1) {			// no remain bytes
-		fseek(fp_, 0, SEEK_SET);	// fp return to beginning pos
-		act_block_ = 0;				// no act block
-	} 
-	else {
-		// ---------------------------------------------------------------------
-		//  since we have read the first block (header block) of block file,
-		//  thus <act_block_> = 1, and the file pointer point to the 2nd block
-		//  (first block to store real data).
-		// ---------------------------------------------------------------------
-		act_block_ = 1;
-	}
-}
-
-// -----------------------------------------------------------------------------
-//  note that this func does not write the header of blockfile. it writes the 
-//  info in the first block excluding the header of blockfile.
-// -----------------------------------------------------------------------------
-void BlockFile::set_header(			// set remain bytes excluding header
-	const char *buffer)					// contain remain bytes
-{
-	fseek(fp_, BFHEAD_LENGTH, SEEK_SET); // jump out of first 8 bytes
-	put_bytes(buffer, block_length_ - BFHEAD_LENGTH); // write remain bytes
-	
-	if (num_blocks_ < 1) {			// no remain bytes
-		fseek(fp_, 0, SEEK_SET);	// fp return to beginning pos
-		act_block_ = 0;				// no act block
-	}
-	else {
-		// ---------------------------------------------------------------------
-		//  since we have write the first block (header block) of block file,
-		//  thus <act_block_> = 1, and the file pointer point to the 2nd block 
-		//  (first block to store real data).
-		// ---------------------------------------------------------------------
-		act_block_ = 1;
-	}
-}
-
-// -----------------------------------------------------------------------------
-//  read a <block> from <index>
-//
-//  we point out the difference of counting among the <number>, <act_block> 
-//  and <pos>.
-//  (1) <num_blocks_>: record the number of blocks, excluding the block
-//      of header. start from 1. (internal block)
-//  (2) <act_block_>: record the number of blocks currently read or written,
-//      including the block of header, thus when we read or write file,
-//      current <act_block> equal to 1. <act_block> is corresponding to
-//      file pointer.
-//  (3) <index> : record position of block we want to read or write, excluding
-//      the block of header. start from 0. (external block), i.e., when 
-//      <index> = 0, the file pointer is pointed to next block after the 
-//      block of header, at this time, <act_block_> equals to 1.
-//
-//  i.e. if number = 3, there are 4 blocks in the file, 1 header block +
-//  3 data block.
-//
-//  when file is opened, <act_block_> = 1. if <index> = 1, it means that we 
-//  want to read or write the 3rd block (2nd data block), thus firstly index++,
-//  then <index> = 2, then fseek move to 2nd data block.
-//
-//  after reading or writing the 2nd data block, file pointer is pointed to 
-//  the 3rd data block. As we know it has read or written 3 blocks, thus 
-//  currently <act_block> = <index> + 1 = 2 + 1 = 3.
-// -----------------------------------------------------------------------------
-bool BlockFile::read_block(			// read a <block> from <index>
-	Block block,						// a <block> (return)
-	int index)							// pos of the block
-{
-	++index;						// extrnl block to intrnl block
-	// assert(index > 0 && index <= num_blocks_);
-	seek_block(index);
-
-	get_bytes(block, block_length_);
-	if (index + 1 > num_blocks_) {	// <fp_> reaches the end of file
-		fseek(fp_, 0, SEEK_SET);
-		act_block_ = 0;				// <act_block_> rewind to start pos
-	}
-	else {
-		act_block_ = index + 1;		// <act_block_> to next pos
-	}
-	return true;
-}
-
-// -----------------------------------------------------------------------------
-//  note that this function can ONLY write to an already "allocated" block (in 
-//  the range of <num_blocks>).
-//  if you allocate a new block, please use "append_block" instead.
-// -----------------------------------------------------------------------------
-bool BlockFile::write_block(		// write a <block> into <index>
-	Block block,						// a <block>
-	int index)							// position of the blocks
-{
-	++index;						// extrnl block to intrnl block
-	// assert(index > 0 && index <= num_blocks_);
-	seek_block(index);
-
-	put_bytes(block, block_length_);// write this block
-	if (index + 1 > num_blocks_) {	// update <act_block_>
-		fseek(fp_, 0, SEEK_SET);
-		act_block_ = 0;
-	}
-	else {
-		act_block_ = index + 1;
-	}
-	return true;
-}
-
-// -----------------------------------------------------------------------------
-//  append a new block at the end of file (out of the range of <num_blocks_>).
-//  the file pointer is pointed to the new appended block and return its pos.
-// -----------------------------------------------------------------------------
-int BlockFile::append_block(		// append new block at the end of file
-	Block block)						// the new block
-{
-	fseek(fp_, 0, SEEK_END);		// <fp_> point to the end of file
-	put_bytes(block, block_length_);// write a <block>
-	++num_blocks_;					// add 1 to <num_blocks_>
-	
-	fseek(fp_, SIZEINT, SEEK_SET);	// <fp_> point to pos of header
-	fwrite_number(num_blocks_);		// update <num_blocks_>
-
-	// -------------------------------------------------------------------------
-	//  <fp_> point to the pos of new added block. 
-	//  the equation <act_block_> = <num_blocks_> indicates the file pointer 
-	//  point to new added block.
-	//  return index of new added block
-	// -------------------------------------------------------------------------
-	fseek(fp_, -block_length_, SEEK_END);
-	return (act_block_ = num_blocks_) - 1;
-}
-
-// -----------------------------------------------------------------------------
-//  delete last <num> block in the file.
-//
-//  NOTE: we just logically delete the data (only modifying the total number
-//  of blcoks), the real data is still stored in file and the size of file is 
-//  not changed.
-// -----------------------------------------------------------------------------
-bool BlockFile::delete_last_blocks(	// delete last <num> blocks
-	int num)							// number of blocks to be deleted
-{
-	if (num > num_blocks_) return false;
-
-	num_blocks_ -= num;				// update <num_blocks_>
-	fseek(fp_, SIZEINT, SEEK_SET);
-	fwrite_number(num_blocks_);
-
-	fseek(fp_, 0, SEEK_SET);		// <fp> point to beginning of file
-	act_block_ = 0;					// <act_block> = 0
-	return true;
-}
+#include "block_file.h"
+
+// -----------------------------------------------------------------------------
+//  some points to NOTE:
+//  1) 2 types of block # are used (i.e. the internal # and external # (e.g.
+//     index)). internal # is one larger than external # because the first
+//     block of the file is used to store header info. data info is stored
+//     starting from the 2nd block (excluding the header block). both types
+//     of # start from 0.
+//
+//  2) "number" is the # of data block (i.e. excluding the header block).
+//     maximum internal # equals to number. Maximum external block # equals
+//     to number - 1
+//
+//  3) all reads and writes are positional (pread/pwrite), so there is no
+//     file pointer to be maintained between two calls.
+// -----------------------------------------------------------------------------
+BlockFile::BlockFile(				// constructor
+	int   b_length,						// block length
+	const char *name)					// file name
+{
+	strcpy(fname_, name);
+	//page size B
+	block_length_ = b_length;
+
+	num_blocks_ = 0;				// num of blocks, init to 0
+	bulk_       = false;
+	async_      = false;
+	stage_      = NULL;
+	ring_       = NULL;
+	direct_     = false;
+	cache_      = NULL;
+	lz4_        = false;
+	extent_end_ = 0;
+	ext_        = NULL;
+	table_.pos_ = 0;
+	table_.len_ = 0;
+	pack_buf_   = NULL;
+	crc_        = false;
+	verify_     = false;
+	committed_  = 0;
+	writeback_  = false;
+	write_errors_.store(0);
+	undo_on_    = false;
+	pthread_mutex_init(&dirty_lock_, NULL);
+	epoch_      = 0;
+	oldest_     = MAXINT;
+	pthread_rwlock_init(&version_lock_, NULL);
+	num_free_   = 0;
+	map_block_  = -1;
+	map_num_    = 0;
+	pthread_mutex_init(&ext_lock_, NULL);
+	stage_cap_  = 0;
+	stage_base_ = 0;
+	stage_num_  = 0;
+	// -------------------------------------------------------------------------
+	//  init <fd_> and open <file_name_>. if <file_name_> exists, then fd >= 0,
+	//  and we excute if-clause program. otherwise, we excute else-clause
+	//  program.
+	// -------------------------------------------------------------------------
+	if ((fd_ = open(fname_, O_RDWR)) >= 0) {
+		// ---------------------------------------------------------------------
+		//  init <new_flag_> (since the file exists, <new_flag_> is false).
+		//  reinit <block_length_> (determined by the doc itself).
+		//  reinit <num_blocks_> (number of blocks in doc itself).
+		// ---------------------------------------------------------------------
+		new_flag_ = false;			// reinit <block_length_> by file
+		block_length_ = fread_number(0);
+		num_blocks_ = fread_number(SIZEINT);
+		read_tail();				// extended header (if any)
+	}
+	else {
+		// ---------------------------------------------------------------------
+		//  init <new_flag_>: as file is just constructed (new), it is true.
+		//  write <block_length_> and <num_blocks_> to the header of file.
+		//  since the file is empty (new), <num_blocks_> is 0 (no blocks in it)
+		// ---------------------------------------------------------------------
+		assert(block_length_ >= BFHEAD_LENGTH);
+
+		fd_ = open(fname_, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		new_flag_ = true;
+
+		// ---------------------------------------------------------------------
+		//  since <block_length_> >= 8 bytes, for the remain bytes, we will
+		//  init 0 to them.
+		// ---------------------------------------------------------------------
+		char *buffer = new_block(block_length_);
+		memset(buffer, 0, block_length_);
+		memcpy(buffer, &block_length_, SIZEINT);
+		memcpy(&buffer[SIZEINT], &num_blocks_, SIZEINT);
+		put_bytes(buffer, block_length_, 0);
+
+		delete_block(buffer); buffer = NULL;
+	}
+}
+
+// -----------------------------------------------------------------------------
+BlockFile::~BlockFile()				// destructor
+{
+	if (bulk_) end_bulk();
+	if (lz4_) save_extents();
+	if (ring_ != NULL) { delete ring_; ring_ = NULL; }
+	if (cache_ != NULL) { delete cache_; cache_ = NULL; }
+	if (ext_ != NULL) {
+		for (int i = 0; i < EXTENT_CHUNKS; ++i) delete[] ext_[i].load();
+		delete[] ext_; ext_ = NULL;
+	}
+	pthread_mutex_destroy(&ext_lock_);
+	clear_dirty();
+	pthread_mutex_destroy(&dirty_lock_);
+	pthread_rwlock_destroy(&version_lock_);
+	if (fd_ >= 0) close(fd_);
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::put_bytes(			// write <bytes> of length <num> at <pos>
+	const char *bytes,					// bytes
+	int   num,							// length of bytes
+	off_t pos)							// offset in file
+{
+	if (direct_ && !is_aligned(bytes, num, pos)) {
+		return direct_bytes(true, (char *) bytes, num, pos);
+	}
+	while (num > 0) {
+		ssize_t ret = pwrite(fd_, bytes, num, pos);
+		if (ret <= 0) return false;
+
+		bytes += ret; num -= (int) ret; pos += ret;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::get_bytes(			// read <bytes> of length <num> at <pos>
+	char  *bytes,						// bytes (return)
+	int   num,							// length of bytes
+	off_t pos)							// offset in file
+{
+	if (direct_ && !is_aligned(bytes, num, pos)) {
+		return direct_bytes(false, bytes, num, pos);
+	}
+	while (num > 0) {
+		ssize_t ret = pread(fd_, bytes, num, pos);
+		if (ret <= 0) return false;
+
+		bytes += ret; num -= (int) ret; pos += ret;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  O_DIRECT needs the buffer, the offset and the length to be aligned. the
+//  other requests (e.g. the header fields) go through an aligned bounce
+//  buffer covering the enclosing aligned range: read, patch, write back.
+//  bytes beyond the end of file are read as 0.
+// -----------------------------------------------------------------------------
+bool BlockFile::direct_bytes(		// unaligned i/o of O_DIRECT by a bounce
+	bool  write,						// write (true) or read (false)
+	char  *bytes,						// bytes
+	int   num,							// length of bytes
+	off_t pos)							// offset in file
+{
+	off_t first = pos / DIRECT_ALIGN * DIRECT_ALIGN;
+	off_t last  = (pos + num + DIRECT_ALIGN - 1) / DIRECT_ALIGN * DIRECT_ALIGN;
+	int   len   = (int) (last - first);
+	char  *bounce = new_block(len);
+
+	int got = 0;
+	while (got < len) {
+		ssize_t ret = pread(fd_, &bounce[got], len - got, first + got);
+		if (ret <= 0) break;
+		got += (int) ret;
+	}
+	memset(&bounce[got], 0, len - got);
+
+	bool ok = true;
+	if (write) {
+		memcpy(&bounce[pos - first], bytes, num);
+		for (int done = 0; done < len; ) {
+			ssize_t ret = pwrite(fd_, &bounce[done], len - done, first + done);
+			if (ret <= 0) { ok = false; break; }
+			done += (int) ret;
+		}
+	}
+	else {
+		memcpy(bytes, &bounce[pos - first], num);
+		ok = (got >= (int) (pos - first) + num);
+	}
+	delete_block(bounce); bounce = NULL;
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  note that this func does not read the header of blockfile. it fetches the
+//  info in the first block excluding the header of blockfile.
+// -----------------------------------------------------------------------------
+void BlockFile::read_header(		// read remain bytes excluding header
+	char *buffer)						// contain remain bytes (return)
+{
+	get_bytes(buffer, block_length_ - BFHEAD_LENGTH - BFTAIL_LENGTH,
+		BFHEAD_LENGTH);
+}
+
+// -----------------------------------------------------------------------------
+//  note that this func does not write the header of blockfile. it writes the
+//  info in the first block excluding the header of blockfile.
+// -----------------------------------------------------------------------------
+void BlockFile::set_header(			// set remain bytes excluding header
+	const char *buffer)					// contain remain bytes
+{
+	put_bytes(buffer, block_length_ - BFHEAD_LENGTH - BFTAIL_LENGTH,
+		BFHEAD_LENGTH);
+}
+
+// -----------------------------------------------------------------------------
+//  the last <BFTAIL_LENGTH> bytes of the header block are the extended
+//  header of BlockFile: <magic>, <flags>, <table_pos>, <extent_end> and
+//  <table_num>. old files have no <magic> there, i.e., no extensions. the
+//  trailers of blocks are checked on read if the file has them.
+// -----------------------------------------------------------------------------
+void BlockFile::read_tail()			// read the tail of header block
+{
+	char tail[BFTAIL_LENGTH];
+	get_bytes(tail, BFTAIL_LENGTH, block_length_ - BFTAIL_LENGTH);
+
+	int   magic = 0, flags = 0, table_num = 0;
+	off_t table_pos = 0;
+	int64_t pos = 0, end = 0;
+	memcpy(&magic,     &tail[0],  SIZEINT);
+	memcpy(&flags,     &tail[4],  SIZEINT);
+	memcpy(&pos,       &tail[8],  sizeof(int64_t));
+	memcpy(&end,       &tail[16], sizeof(int64_t));
+	memcpy(&table_num, &tail[24], SIZEINT);
+	if (magic != BFTAIL_MAGIC) return;
+
+	crc_ = verify_ = (flags & BF_FLAG_CRC) != 0;
+
+	if (flags & BF_FLAG_LZ4) {		// load table of extents
+		lz4_ = true;
+		extent_end_ = (off_t) end;
+		table_pos = (off_t) pos;
+		ext_ = new_extent_table();
+
+		int  entry = sizeof(int64_t) + SIZEINT;
+		char *table = new char[(size_t) table_num * entry + 1];
+		get_bytes(table, table_num * entry, table_pos);
+		for (int i = 0; i < table_num; ++i) {
+			int64_t p = 0; int len = 0;
+			memcpy(&p,   &table[(size_t) i * entry], sizeof(int64_t));
+			memcpy(&len, &table[(size_t) i * entry + sizeof(int64_t)], SIZEINT);
+			if (len > 0) set_extent(i, (off_t) p, len);
+		}
+		delete[] table; table = NULL;
+		table_.pos_ = table_pos;
+		table_.len_ = table_num * entry;
+		find_holes();
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::write_tail(			// write the tail of header block
+	off_t table_pos,					// offset of table of extents
+	int   table_num)					// num of entries of the table
+{
+	char tail[BFTAIL_LENGTH];
+	int  magic = BFTAIL_MAGIC;
+	int  flags = (lz4_ ? BF_FLAG_LZ4 : 0) | (crc_ ? BF_FLAG_CRC : 0);
+	int64_t pos = (int64_t) table_pos, end = (int64_t) extent_end_;
+	memset(tail, 0, BFTAIL_LENGTH);
+	memcpy(&tail[0],  &magic,     SIZEINT);
+	memcpy(&tail[4],  &flags,     SIZEINT);
+	memcpy(&tail[8],  &pos,       sizeof(int64_t));
+	memcpy(&tail[16], &end,       sizeof(int64_t));
+	memcpy(&tail[24], &table_num, SIZEINT);
+	put_bytes(tail, BFTAIL_LENGTH, block_length_ - BFTAIL_LENGTH);
+}
+
+// -----------------------------------------------------------------------------
+//  read a <block> from <index>
+//
+//  <index> records position of block we want to read or write, excluding the
+//  block of header. start from 0. (external block), i.e., when <index> = 0,
+//  we read the next block after the block of header.
+//
+//  i.e. if number = 3, there are 4 blocks in the file, 1 header block +
+//  3 data block.
+//
+//  in bulk mode, the blocks which are still in the staging buffer are copied
+//  from there instead of the file.
+// -----------------------------------------------------------------------------
+bool BlockFile::read_block(			// read a <block> from <index>
+	Block block,						// a <block> (return)
+	int index)							// pos of the block
+{
+	PerfScope scope(PHASE_FILE_READ);
+	// assert(index >= 0 && index < num_blocks_);
+	if (writeback_ && index < committed_) {
+		pthread_mutex_lock(&dirty_lock_);
+		std::unordered_map<int, char*>::iterator it = dirty_.find(index);
+		bool hit = (it != dirty_.end());
+		if (hit) memcpy(block, it->second, block_length_);
+		pthread_mutex_unlock(&dirty_lock_);
+		if (hit) return true;
+	}
+	if (bulk_ && index >= stage_base_ && index < stage_base_ + stage_num_) {
+		memcpy(block, &stage_[(index - stage_base_) * block_length_],
+			block_length_);
+		return true;
+	}
+	StageBuffer *buf = find_flushing(index);
+	if (buf != NULL) {				// not on disk yet, but <buf> is stable
+		memcpy(block, &buf->data_[(index - buf->base_) * block_length_],
+			block_length_);
+		return true;
+	}
+	if (cache_ != NULL && cache_->get(index, block)) return true;
+
+	off_t pos = block_offset(index);
+	bool  ok  = false;
+	if (lz4_) ok = read_extent(block, index);
+	else {
+		ok = (ring_ != NULL && ring_->read(1, &pos, &block)) ||
+			get_bytes(block, block_length_, pos);
+	}
+	if (ok && verify_) ok = check_block(block, index);
+	if (ok && cache_ != NULL) cache_->put(index, block);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  note that this function can ONLY write to an already "allocated" block (in
+//  the range of <num_blocks>).
+//  if you allocate a new block, please use "append_block" instead.
+// -----------------------------------------------------------------------------
+bool BlockFile::write_block(		// write a <block> into <index>
+	Block block,						// a <block>
+	int index)							// position of the blocks
+{
+	PerfScope scope(PHASE_FILE_WRITE);
+	// assert(index >= 0 && index < num_blocks_);
+	if (bulk_ && index >= stage_base_ && index < stage_base_ + stage_num_) {
+		memcpy(&stage_[(index - stage_base_) * block_length_], block,
+			block_length_);
+		return true;
+	}
+	StageBuffer *buf = find_flushing(index);
+	if (buf != NULL) {				// wait, or the stale copy would win
+		PerfScope wait_scope(PHASE_FLUSH_WAIT);
+		while (buf->state_.load(std::memory_order_acquire) == STAGE_FLUSHING) {
+			sched_yield();
+		}
+	}
+	if (crc_) seal_block(block);
+	bool shadowed = is_shadowed(index);
+	if (shadowed && !writeback_) {	// shadow paging: never in place
+		printf("block %d belongs to the committed tree\n", index);
+		write_errors_.fetch_add(1);
+		return false;
+	}
+	if (undo_on_ && undo_.find(index) == undo_.end()) {
+		char *img = new_block(block_length_);
+		read_block(img, index);
+		undo_[index] = img;
+	}
+	if (cache_ != NULL) cache_->put(index, block); // write-through
+	if (shadowed) {					// kept until the next checkpoint
+		pthread_mutex_lock(&dirty_lock_);
+		char *&img = dirty_[index];
+		if (img == NULL) img = new_block(block_length_);
+		memcpy(img, block, block_length_);
+		pthread_mutex_unlock(&dirty_lock_);
+		return true;
+	}
+	bool ok = false;
+	if (lz4_) ok = write_extent(block, index);
+	else {
+		off_t pos = block_offset(index);
+		ok = (ring_ != NULL && ring_->write(1, &pos, &block)) ||
+			put_bytes(block, block_length_, pos);
+	}
+	if (!ok) write_errors_.fetch_add(1);
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  read a batch of blocks. with io_uring, up to <URING_DEPTH> blocks are in
+//  flight at once; otherwise it is a loop of pread.
+// -----------------------------------------------------------------------------
+bool BlockFile::read_blocks(		// read a batch of blocks
+	int  num,							// num of blocks
+	const int *index,					// pos of the blocks
+	char **blocks)						// blocks (return)
+{
+	if (ring_ == NULL || bulk_ || lz4_ || writeback_) {
+		bool ok = true;
+		for (int i = 0; i < num; ++i) {
+			if (!read_block(blocks[i], index[i])) ok = false;
+		}
+		return ok;
+	}
+
+	PerfScope scope(PHASE_FILE_READ);
+	off_t *pos  = new off_t[num];
+	char  **bufs = new char*[num];
+	int   miss = 0;					// only the misses of <cache_> are read
+	for (int i = 0; i < num; ++i) {
+		if (cache_ != NULL && cache_->get(index[i], blocks[i])) continue;
+
+		pos[miss]  = block_offset(index[i]);
+		bufs[miss] = blocks[i];
+		++miss;
+	}
+
+	bool ok = (miss == 0) || ring_->read(miss, pos, bufs);
+	if (!ok) {						// fall back to pread
+		ok = true;
+		for (int i = 0; i < miss; ++i) {
+			if (!get_bytes(bufs[i], block_length_, pos[i])) ok = false;
+		}
+	}
+	for (int i = 0; ok && verify_ && i < miss; ++i) {
+		ok = check_block(bufs[i], (int) (pos[i] / block_length_) - 1);
+	}
+	if (ok && cache_ != NULL) {
+		for (int i = 0; i < miss; ++i) {
+			cache_->put((int) (pos[i] / block_length_) - 1, bufs[i]);
+		}
+	}
+	delete[] pos;  pos  = NULL;
+	delete[] bufs; bufs = NULL;
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::write_blocks(		// write a batch of blocks
+	int  num,							// num of blocks
+	const int *index,					// pos of the blocks
+	char **blocks)						// blocks
+{
+	if (ring_ == NULL || bulk_ || lz4_ || writeback_) {
+		bool ok = true;
+		for (int i = 0; i < num; ++i) {
+			if (!write_block(blocks[i], index[i])) ok = false;
+		}
+		return ok;
+	}
+
+	for (int i = 0; i < num; ++i) {
+		if (is_shadowed(index[i])) {
+			printf("block %d belongs to the committed tree\n", index[i]);
+			return false;
+		}
+	}
+	PerfScope scope(PHASE_FILE_WRITE);
+	off_t *pos = new off_t[num];
+	for (int i = 0; i < num; ++i) {
+		pos[i] = block_offset(index[i]);
+		if (crc_) seal_block(blocks[i]);
+		if (cache_ != NULL) cache_->put(index[i], blocks[i]);
+	}
+
+	bool ok = ring_->write(num, pos, blocks);
+	if (!ok) {						// fall back to pwrite
+		ok = true;
+		for (int i = 0; i < num; ++i) {
+			if (!put_bytes(blocks[i], block_length_, pos[i])) ok = false;
+		}
+	}
+	delete[] pos; pos = NULL;
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  append a new block at the end of file (out of the range of <num_blocks_>)
+//  and return its pos. out of bulk mode, a free block is taken first, the
+//  one closest after <near> (e.g., the left sibling) if there is one.
+//
+//  in bulk mode, the new block is only copied into the staging buffer and
+//  <num_blocks_> is written into the header by end_bulk().
+// -----------------------------------------------------------------------------
+int BlockFile::append_block(		// append new block at the end of file
+	Block block,						// the new block
+	int   near)							// place after this block if free
+{
+	PerfScope scope(PHASE_FILE_APPEND);
+	if (bulk_) {
+		if (stage_num_ == stage_cap_) flush_stage(stage_cap_ / 8);
+
+		memcpy(&stage_[stage_num_ * block_length_], block, block_length_);
+		++stage_num_;
+		return num_blocks_++;
+	}
+
+	pthread_rwlock_wrlock(&version_lock_);
+	int index = alloc_block(near);	// may add 1 to <num_blocks_>
+	pthread_rwlock_unlock(&version_lock_);
+
+	off_t pos = block_offset(index);
+	if (undo_on_) undo_[index] = NULL;
+	if (crc_) seal_block(block);
+	bool ok = false;
+	if (lz4_) ok = write_extent(block, index);
+	else {
+		ok = (ring_ != NULL && ring_->write(1, &pos, &block)) ||
+			put_bytes(block, block_length_, pos);
+	}
+	if (!ok) write_errors_.fetch_add(1);
+	else if (cache_ != NULL) cache_->put(index, block);
+	fwrite_number(num_blocks_, SIZEINT); // update <num_blocks_>
+
+	return index;					// return index of new added block
+}
+
+// -----------------------------------------------------------------------------
+//  undo of an update (see BTree::apply_update()): from begin_undo(), the
+//  first write of a block keeps its image, and a new block is noted. if the
+//  update fails, the images are written back (to <dirty_>, the cache or the
+//  file) and the new blocks are free again, so nothing of it is left.
+// -----------------------------------------------------------------------------
+bool BlockFile::end_undo(			// drop the images, or restore them
+	bool keep)							// keep the changes?
+{
+	undo_on_ = false;
+	bool ok = true;
+	std::unordered_map<int, char*>::iterator it;
+	for (it = undo_.begin(); it != undo_.end(); ++it) {
+		if (!keep && it->second != NULL) {
+			if (!write_block(it->second, it->first)) ok = false;
+		}
+		else if (!keep) {			// never in a committed tree
+			pthread_rwlock_wrlock(&version_lock_);
+			fresh_.erase(it->first);
+			set_free(it->first, true);
+			pthread_rwlock_unlock(&version_lock_);
+		}
+		if (it->second != NULL) delete_block(it->second);
+	}
+	undo_.clear();
+	if (!ok) printf("could not undo a failed update\n");
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  delete last <num> block in the file.
+//
+//  NOTE: we just logically delete the data (only modifying the total number
+//  of blcoks), the real data is still stored in file and the size of file is
+//  not changed.
+// -----------------------------------------------------------------------------
+bool BlockFile::delete_last_blocks(	// delete last <num> blocks
+	int num)							// number of blocks to be deleted
+{
+	if (num > num_blocks_ - committed_) return false;
+	if (bulk_) flush_stage(0);
+
+	num_blocks_ -= num;				// update <num_blocks_>
+	stage_base_ = num_blocks_;
+	pthread_rwlock_wrlock(&version_lock_);
+	for (int i = num_blocks_; i < num_blocks_ + num; ++i) set_free(i, false);
+	pthread_rwlock_unlock(&version_lock_);
+	if (cache_ != NULL) cache_->erase_from(num_blocks_);
+	if (!bulk_) fwrite_number(num_blocks_, SIZEINT);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  write <num_blocks_> (and the table of extents) and wait until all blocks
+//  written so far are on the device. it is a barrier of BTree::commit(), so
+//  it is not allowed in bulk mode, where blocks are still staged.
+// -----------------------------------------------------------------------------
+bool BlockFile::sync()				// make all written blocks durable
+{
+	if (bulk_) {
+		printf("sync is not allowed in bulk mode\n");
+		return false;
+	}
+	fwrite_number(num_blocks_, SIZEINT);
+	if (lz4_) save_extents();
+
+	return fdatasync(fd_) == 0;
+}
+
+// -----------------------------------------------------------------------------
+//  write-back mode (for the updates logged by BTree): the blocks of the
+//  committed tree are not written in place, their new content is kept in
+//  <dirty_> and read from there, until a checkpoint protected by the log
+//  writes them by write_image() and drops them by clear_dirty(). the new
+//  blocks (not committed yet) are written as usual.
+// -----------------------------------------------------------------------------
+void BlockFile::get_dirty(			// dirty blocks of committed tree
+	std::vector<int> &index,			// pos of blocks (return)
+	std::vector<char*> &blocks)			// blocks (return)
+{
+	pthread_mutex_lock(&dirty_lock_);
+	index.clear(); blocks.clear();
+	std::unordered_map<int, char*>::iterator it;
+	for (it = dirty_.begin(); it != dirty_.end(); ++it) {
+		index.push_back(it->first);
+		blocks.push_back(it->second);
+	}
+	pthread_mutex_unlock(&dirty_lock_);
+}
+
+// -----------------------------------------------------------------------------
+//  if a reader has pinned a committed tree, the image on disk is first
+//  copied to a free block (or a new one), which is read instead by the
+//  readers of epochs <= <epoch_>.
+// -----------------------------------------------------------------------------
+bool BlockFile::write_image(		// write a block in place (checkpoint)
+	const char *block,					// a block (sealed)
+	int   index)						// pos of the block
+{
+	bool ok = true;
+	pthread_rwlock_wrlock(&version_lock_);
+	if (oldest_ <= epoch_) {		// keep the image of the readers
+		char *old = new_block(block_length_);
+		int  copy = alloc_block(-1);
+		ok = read_raw(old, index) && write_raw(old, copy);
+		if (ok) {
+			Version v = { copy, epoch_ + 1 };
+			versions_[index].push_back(v);
+		}
+		delete_block(old); old = NULL;
+	}
+	if (ok) {
+		if (cache_ != NULL) cache_->put(index, block);
+		ok = write_raw(block, index);
+	}
+	pthread_rwlock_unlock(&version_lock_);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::clear_dirty()		// drop dirty blocks (written back)
+{
+	pthread_mutex_lock(&dirty_lock_);
+	std::unordered_map<int, char*>::iterator it;
+	for (it = dirty_.begin(); it != dirty_.end(); ++it) {
+		delete_block(it->second);
+	}
+	dirty_.clear();
+	pthread_mutex_unlock(&dirty_lock_);
+}
+
+// -----------------------------------------------------------------------------
+//  readers of snapshots: the blocks of a committed tree are read from the
+//  file (not from <dirty_> or the cache, which hold the updated blocks), or
+//  from the oldest image kept for epoch <epoch> if the block was overwritten
+//  since. a block and its versions are read under <version_lock_>, so a
+//  checkpoint cannot overwrite it meanwhile.
+// -----------------------------------------------------------------------------
+bool BlockFile::read_version(		// read a block as of a committed tree
+	Block block,						// a block (return)
+	int   index,						// pos of the block
+	int   epoch)						// epoch of the committed tree
+{
+	PerfScope scope(PHASE_FILE_READ);
+	pthread_rwlock_rdlock(&version_lock_);
+	int src = index;
+	std::unordered_map<int, std::vector<Version> >::iterator it =
+		versions_.find(index);
+	if (it != versions_.end()) {	// versions in order of <until_>
+		for (size_t i = 0; i < it->second.size(); ++i) {
+			if (it->second[i].until_ > epoch) {
+				src = it->second[i].block_;
+				break;
+			}
+		}
+	}
+	bool ok = read_raw(block, src);
+	pthread_rwlock_unlock(&version_lock_);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  epoch-based reclamation: a freed block waits in <limbo_> (and an old image
+//  in <versions_>) until the tree which does not use it is committed and no
+//  reader has pinned an older tree. then it is reused by append_block() in
+//  write-back mode and by the copies of write_image().
+// -----------------------------------------------------------------------------
+void BlockFile::free_block(			// free a block once no reader sees it
+	int index,							// pos of the block
+	int until)							// visible to epochs < <until>
+{
+	Version v = { index, until };
+	pthread_rwlock_wrlock(&version_lock_);
+	limbo_.push_back(v);
+	pthread_rwlock_unlock(&version_lock_);
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::reclaim(			// free blocks which no reader sees
+	int oldest)							// oldest epoch pinned (MAXINT: none)
+{
+	pthread_rwlock_wrlock(&version_lock_);
+	oldest_ = oldest;
+	int bound = MIN(oldest, epoch_);
+
+	std::unordered_map<int, std::vector<Version> >::iterator it;
+	for (it = versions_.begin(); it != versions_.end(); ) {
+		std::vector<Version> &v = it->second;
+		size_t keep = 0;
+		for (size_t i = 0; i < v.size(); ++i) {
+			if (v[i].until_ > bound) v[keep++] = v[i];
+			else set_free(v[i].block_, true);
+		}
+		v.resize(keep);
+		if (keep == 0) it = versions_.erase(it);
+		else ++it;
+	}
+	size_t keep = 0;
+	for (size_t i = 0; i < limbo_.size(); ++i) {
+		if (limbo_[i].until_ > bound) limbo_[keep++] = limbo_[i];
+		else set_free(limbo_[i].block_, true);
+	}
+	limbo_.resize(keep);
+	pthread_rwlock_unlock(&version_lock_);
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::read_raw(			// read a block from file (no cache)
+	Block block,						// a block (return)
+	int   index)						// pos of the block
+{
+	bool ok = false;
+	if (lz4_) ok = read_extent(block, index);
+	else ok = get_bytes(block, block_length_, block_offset(index));
+	if (ok && verify_) ok = check_block(block, index);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::write_raw(			// write a sealed block to file
+	const char *block,					// a block
+	int   index)						// pos of the block
+{
+	if (lz4_) return write_extent(block, index);
+
+	return put_bytes(block, block_length_, block_offset(index));
+}
+
+// -----------------------------------------------------------------------------
+//  free space: <free_map_> has a bit per block, set if the block is not
+//  used by the committed tree, nor by a new one, nor by a reader (see
+//  reclaim()). a free block of the committed tree which is allocated is
+//  <fresh_> until the next commit, so it can be written in place. the
+//  functions below hold <version_lock_>.
+// -----------------------------------------------------------------------------
+int BlockFile::alloc_block(			// a free block or a new one at the end
+	int near)							// prefer a block after <near>
+{
+	int index = -1;
+	if (num_free_ > 0 && near >= 0) {
+		index = find_free(near + 1, MIN(near + 1 + ALLOC_WINDOW, num_blocks_));
+	}
+	if (num_free_ > 0 && index < 0) index = find_free(0, num_blocks_);
+	if (index < 0) return num_blocks_++; // written to file by sync()
+
+	set_free(index, false);
+	if (index < committed_) fresh_.insert(index);
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::set_free(			// mark a block free or used
+	int  index,							// pos of the block
+	bool free)							// free?
+{
+	size_t w = (size_t) index >> 6;
+	if (w >= free_map_.size()) {
+		if (!free) return;
+		free_map_.resize(w + 1, 0);
+	}
+	uint64_t bit = 1ull << (index & 63);
+	if (((free_map_[w] & bit) != 0) == free) return;
+
+	free_map_[w] ^= bit;
+	num_free_ += free ? 1 : -1;
+}
+
+// -----------------------------------------------------------------------------
+int BlockFile::find_free(			// first free block in [from, to)
+	int from,							// first pos
+	int to)								// end pos
+{
+	int end = MIN(to, (int) free_map_.size() * 64);
+	for (int i = from; i < end; ) {
+		uint64_t word = free_map_[i >> 6] >> (i & 63);
+		if (word != 0) {
+			i += __builtin_ctzll(word);
+			return i < end ? i : -1;
+		}
+		i = (i | 63) + 1;			// next word
+	}
+	return -1;
+}
+
+// -----------------------------------------------------------------------------
+//  extents keep nodes which are read in order (e.g., the leaves rewritten by
+//  BTree::compact()) next to each other: the first run of <num> free blocks
+//  is taken, or else the free blocks at the end of file and new ones.
+// -----------------------------------------------------------------------------
+int BlockFile::alloc_blocks(		// allocate an extent of free blocks
+	int num)							// num of blocks
+{
+	pthread_rwlock_wrlock(&version_lock_);
+	int start = -1;
+	int run   = 0;
+	for (int i = 0; i < num_blocks_ && num_free_ >= num; ) {
+		size_t w = (size_t) i >> 6;
+		if ((i & 63) == 0 && (w >= free_map_.size() || free_map_[w] == 0)) {
+			run = 0; i += 64;		// no free block in this word
+			continue;
+		}
+		if (!is_free(i)) run = 0;
+		else if (++run == num) { start = i - num + 1; break; }
+		++i;
+	}
+	if (start < 0) {
+		start = num_blocks_;
+		while (start > 0 && is_free(start - 1)) --start;
+		num_blocks_ = MAX(num_blocks_, start + num);
+	}
+	for (int i = start; i < start + num; ++i) {
+		set_free(i, false);
+		if (i < committed_) fresh_.insert(i);
+	}
+	pthread_rwlock_unlock(&version_lock_);
+
+	return start;
+}
+
+// -----------------------------------------------------------------------------
+//  the blocks were never part of a committed tree, so no reader sees them
+//  and they are free at once (not through <limbo_>).
+// -----------------------------------------------------------------------------
+void BlockFile::free_blocks(		// free an extent of alloc_blocks()
+	int start,							// first block
+	int num)							// num of blocks
+{
+	pthread_rwlock_wrlock(&version_lock_);
+	for (int i = start; i < start + num; ++i) {
+		fresh_.erase(i);
+		set_free(i, true);
+	}
+	pthread_rwlock_unlock(&version_lock_);
+}
+
+// -----------------------------------------------------------------------------
+//  the free map of a commit is written to new blocks (an extent), and the
+//  header slot of the commit points to them, so it is as durable as the
+//  tree. the map of the previous commit is freed by this one. the blocks
+//  which only readers use (<limbo_>, <versions_>) are free in the map, since
+//  there are no readers after a restart.
+// -----------------------------------------------------------------------------
+bool BlockFile::save_free_map()		// write free map (before a commit)
+{
+	int until = epoch_ + 1;			// epoch of the commit
+	if (map_block_ >= 0) {
+		pthread_rwlock_wrlock(&version_lock_);
+		for (int i = 0; i < map_num_; ++i) {
+			Version v = { map_block_ + i, until };
+			limbo_.push_back(v);
+		}
+		pthread_rwlock_unlock(&version_lock_);
+	}
+	int payload = get_payload_length();
+	int num = 1;					// the map may be at the end of file
+	while ((num_blocks_ + num + 7) / 8 > num * payload) ++num;
+	int first = alloc_blocks(num);
+
+	pthread_rwlock_rdlock(&version_lock_);
+	std::vector<uint64_t> bits(free_map_);
+	bits.resize(((size_t) num_blocks_ + 63) / 64 + 1, 0);
+	for (size_t i = 0; i < limbo_.size(); ++i) {
+		int b = limbo_[i].block_;
+		if (limbo_[i].until_ <= until) bits[b >> 6] |= 1ull << (b & 63);
+	}
+	std::unordered_map<int, std::vector<Version> >::iterator it;
+	for (it = versions_.begin(); it != versions_.end(); ++it) {
+		for (size_t i = 0; i < it->second.size(); ++i) {
+			int b = it->second[i].block_;
+			bits[b >> 6] |= 1ull << (b & 63);
+		}
+	}
+	pthread_rwlock_unlock(&version_lock_);
+
+	const char *bytes = (const char *) &bits[0];
+	int  len = (num_blocks_ + 7) / 8;
+	char *blk = new_block(block_length_);
+	bool ok = true;
+	for (int i = 0; i < num && ok; ++i) {
+		int from = i * payload;
+		memset(blk, 0, block_length_);
+		if (from < len) memcpy(blk, &bytes[from], MIN(payload, len - from));
+		if (crc_) seal_block(blk);
+		ok = write_raw(blk, first + i);
+	}
+	delete_block(blk); blk = NULL;
+
+	map_block_ = first;
+	map_num_   = num;
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::load_free_map(		// read free map of committed tree
+	int block,							// first block of free map
+	int num)							// num of blocks of free map
+{
+	int  payload = get_payload_length();
+	int  len = (num_blocks_ + 7) / 8;
+	std::vector<uint64_t> bits(((size_t) num_blocks_ + 63) / 64 + 1, 0);
+	char *bytes = (char *) &bits[0];
+	char *blk = new_block(block_length_);
+	bool ok = true;
+	for (int i = 0; i < num && ok; ++i) {
+		int from = i * payload;
+		ok = read_raw(blk, block + i);
+		if (ok && from < len) memcpy(&bytes[from], blk, MIN(payload, len - from));
+	}
+	delete_block(blk); blk = NULL;
+	if (!ok) return false;
+
+	pthread_rwlock_wrlock(&version_lock_);
+	free_map_.clear();
+	num_free_ = 0;
+	for (int i = 0; i < num_blocks_; ++i) {
+		if (bits[i >> 6] >> (i & 63) & 1) set_free(i, true);
+	}
+	map_block_ = block;
+	map_num_   = num;
+	pthread_rwlock_unlock(&version_lock_);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::init_free_map(		// all blocks but <used> are free
+	const std::vector<int> &used)		// blocks of committed tree
+{
+	pthread_rwlock_wrlock(&version_lock_);
+	free_map_.clear();
+	num_free_ = 0;
+	for (int i = 0; i < num_blocks_; ++i) set_free(i, true);
+	for (size_t i = 0; i < used.size(); ++i) set_free(used[i], false);
+	map_block_ = -1;
+	map_num_   = 0;
+	pthread_rwlock_unlock(&version_lock_);
+}
+
+// -----------------------------------------------------------------------------
+//  io_uring is optional: if it cannot be set up at runtime, <ring_> stays NULL
+//  and all calls keep using pread/pwrite.
+// -----------------------------------------------------------------------------
+bool BlockFile::enable_uring(		// use io_uring instead of pread/pwrite
+	int depth)							// max num of requests in flight
+{
+	if (ring_ != NULL) return true;
+
+	ring_ = new IoRing();
+	if (!ring_->init(fd_, depth, block_length_)) {
+		delete ring_; ring_ = NULL;
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  O_DIRECT bypasses the page cache of kernel, so that a large bulkload does
+//  not evict everything else and the reads of search hit the device (or the
+//  own <cache_> of BlockFile). the block length must be a multiple of
+//  <DIRECT_ALIGN>, so that every block is aligned in file; the buffers of
+//  blocks are aligned by new_block().
+// -----------------------------------------------------------------------------
+bool BlockFile::enable_direct()		// bypass the page cache by O_DIRECT
+{
+	if (direct_) return true;
+	if (block_length_ % DIRECT_ALIGN != 0) {
+		printf("block length %d is not a multiple of %d, O_DIRECT is off\n",
+			block_length_, DIRECT_ALIGN);
+		return false;
+	}
+	int flags = fcntl(fd_, F_GETFL);
+	if (flags < 0 || fcntl(fd_, F_SETFL, flags | O_DIRECT) < 0) {
+		printf("O_DIRECT is not supported by %s\n", fname_);
+		return false;
+	}
+	direct_ = true;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::enable_cache(		// keep recently used blocks in memory
+	int num_blocks)						// max num of blocks in cache
+{
+	if (cache_ != NULL) delete cache_;
+	cache_ = new BlockCache(num_blocks, block_length_);
+}
+
+// -----------------------------------------------------------------------------
+//  lz4 mode: every block is compressed and written to the file as an
+//  extent of variable size, and a table maps each block to its extent. a
+//  rewritten block gets a new extent, so nothing is updated in place. in
+//  bulk mode, the staged blocks of a flush are compressed (by the flush
+//  thread if async) and written as a run of extents with one pwrite. the
+//  table is written to a new extent by save_extents() and found by the tail
+//  of the header block.
+//
+//  the old extent of a rewritten block (and the old table) is dead, but the
+//  table on disk may still use it: it becomes a hole, which new extents
+//  fill (best fit), once the tail of a newer table is on the device. so
+//  does an extent written since the last table, since a reader (which does
+//  not lock the table) may have just taken it. a hole at the end of the
+//  file is cut off.
+//
+//  a block which does not shrink is stored as it is, but each block still
+//  costs 12 bytes in the table, and up to two tables are in the file while
+//  one is saved. so this mode only makes the file smaller when the blocks
+//  compress, e.g. leaves with full keys (-stride 1); the packed leaves of
+//  the default tree are nearly incompressible.
+//
+//  the blocks which are already in the file are converted, so it can be
+//  enabled right after BTree::init().
+// -----------------------------------------------------------------------------
+bool BlockFile::enable_lz4()		// store blocks as lz4 extents
+{
+	if (lz4_) return true;
+	if (bulk_) {
+		printf("lz4 cannot be enabled in bulk mode\n");
+		return false;
+	}
+	if (block_length_ >= (1 << EXTENT_LEN_BITS)) {
+		printf("lz4 needs blocks below %d bytes\n", 1 << EXTENT_LEN_BITS);
+		return false;
+	}
+	ext_ = new_extent_table();
+	extent_end_ = block_offset(num_blocks_);
+	lz4_ = true;
+
+	char *blk = new_block(block_length_);
+	for (int i = 0; i < num_blocks_; ++i) {
+		get_bytes(blk, block_length_, block_offset(i));
+		write_extent(blk, i);
+
+		Extent raw = { block_offset(i), block_length_ }; // dead once saved
+		dead_.push_back(raw);
+	}
+	delete_block(blk); blk = NULL;
+
+	save_extents();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  the table is on the device before the tail which points to it, and the
+//  tail before the extents it no longer uses become holes. <dead_> is taken
+//  before the table is built, so no extent of the new table is among them.
+// -----------------------------------------------------------------------------
+void BlockFile::save_extents()		// write table of extents and the tail
+{
+	if (!lz4_) return;
+
+	std::vector<Extent> dead;
+	pthread_mutex_lock(&ext_lock_);
+	dead.swap(dead_);
+	if (table_.len_ > 0) dead.push_back(table_);
+	pthread_mutex_unlock(&ext_lock_);
+
+	int  entry = sizeof(int64_t) + SIZEINT;
+	int  num   = num_blocks_;
+	char *table = new char[(size_t) num * entry + 1];
+	for (int i = 0; i < num; ++i) {	// extents set later are not in it
+		Extent  e = { 0, 0 };
+		get_extent(i, e);
+		int64_t p = (int64_t) e.pos_;
+		int   len = e.len_;
+		memcpy(&table[(size_t) i * entry], &p, sizeof(int64_t));
+		memcpy(&table[(size_t) i * entry + sizeof(int64_t)], &len, SIZEINT);
+	}
+
+	pthread_mutex_lock(&ext_lock_);	// keep the table until the next save
+	off_t table_pos = alloc_extent(num * entry);
+	pthread_mutex_unlock(&ext_lock_);
+	bool ok = put_bytes(table, num * entry, table_pos) && fdatasync(fd_) == 0;
+	delete[] table; table = NULL;
+
+	if (ok) {
+		write_tail(table_pos, num);
+		ok = fdatasync(fd_) == 0;
+	}
+	Extent saved = { table_pos, num * entry };
+	pthread_mutex_lock(&ext_lock_);
+	if (ok) {
+		for (size_t i = 0; i < dead.size(); ++i) {
+			add_hole(dead[i].pos_, dead[i].len_);
+		}
+		table_ = saved;
+		std::map<off_t, off_t>::iterator last = holes_.end();
+		if (!holes_.empty() && (--last)->first + last->second == extent_end_) {
+			extent_end_ = last->first;	// give back the hole at the end
+			hole_sizes_.erase(std::make_pair(last->second, last->first));
+			holes_.erase(last);
+			if (ftruncate(fd_, extent_end_) != 0) {
+				printf("could not truncate %s\n", fname_);
+			}
+		}
+	}
+	else {							// the old tail may still use them
+		dead_.insert(dead_.end(), dead.begin(), dead.end());
+		dead_.push_back(saved);
+	}
+	pthread_mutex_unlock(&ext_lock_);
+}
+
+// -----------------------------------------------------------------------------
+std::atomic<ExtentWord*>* BlockFile::new_extent_table() // no chunks yet
+{
+	std::atomic<ExtentWord*> *table =
+		new std::atomic<ExtentWord*>[EXTENT_CHUNKS];
+	for (int i = 0; i < EXTENT_CHUNKS; ++i) {
+		table[i].store(NULL, std::memory_order_relaxed);
+	}
+	return table;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::get_extent(			// extent of a block (false: none)
+	int   index,						// pos of the block
+	Extent &e)							// extent (return)
+{
+	ExtentWord *chunk =
+		ext_[index / EXTENT_CHUNK].load(std::memory_order_acquire);
+	if (chunk == NULL) return false;
+
+	uint64_t word = chunk[index % EXTENT_CHUNK].load(std::memory_order_acquire);
+	e.pos_ = (off_t) (word >> EXTENT_LEN_BITS);
+	e.len_ = (int) (word & ((1 << EXTENT_LEN_BITS) - 1));
+	return e.len_ > 0;
+}
+
+// -----------------------------------------------------------------------------
+//  the table is a fixed array of chunks, so an entry never moves, and an
+//  entry is one word: the readers do not need <ext_lock_>. an extent is set
+//  after its data is written, so a reader sees the old one or the new one.
+//  the old one is dead (see save_extents()).
+// -----------------------------------------------------------------------------
+void BlockFile::set_extent(			// set extent of a block (hold ext_lock_)
+	int   index,						// pos of the block
+	off_t pos,							// offset in file
+	int   len)							// length in file
+{
+	ExtentWord *chunk =
+		ext_[index / EXTENT_CHUNK].load(std::memory_order_relaxed);
+	if (chunk == NULL) {
+		chunk = new ExtentWord[EXTENT_CHUNK];
+		for (int i = 0; i < EXTENT_CHUNK; ++i) {
+			chunk[i].store(0, std::memory_order_relaxed);
+		}
+		ext_[index / EXTENT_CHUNK].store(chunk, std::memory_order_release);
+	}
+	uint64_t word = ((uint64_t) pos << EXTENT_LEN_BITS) | (uint64_t) len;
+	uint64_t old  = chunk[index % EXTENT_CHUNK].exchange(word,
+		std::memory_order_acq_rel);
+
+	int old_len = (int) (old & ((1 << EXTENT_LEN_BITS) - 1));
+	if (old_len > 0) {				// a hole after the next save
+		Extent e = { (off_t) (old >> EXTENT_LEN_BITS), old_len };
+		dead_.push_back(e);
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  an extent takes the smallest hole which is large enough, or is appended
+//  at the end. with O_DIRECT, extents are allocated in units of
+//  <DIRECT_ALIGN>, so that the bounce i/o of two extents never shares a page.
+// -----------------------------------------------------------------------------
+off_t BlockFile::alloc_extent(		// space for an extent (hold ext_lock_)
+	int len)							// length of extent
+{
+	off_t align = direct_ ? DIRECT_ALIGN : 1;
+	off_t space = (len + align - 1) / align * align;
+
+	std::set<std::pair<off_t, off_t> >::iterator it =
+		hole_sizes_.lower_bound(std::make_pair(space, (off_t) 0));
+	for (; it != hole_sizes_.end(); ++it) {
+		off_t hole = it->second, hole_len = it->first;
+		off_t pos  = (hole + align - 1) / align * align;
+		if (pos + space > hole + hole_len) continue;
+
+		hole_sizes_.erase(it);
+		holes_.erase(hole);
+		if (pos > hole) add_hole(hole, pos - hole);
+		if (pos + space < hole + hole_len) {
+			add_hole(pos + space, hole + hole_len - pos - space);
+		}
+		return pos;
+	}
+
+	extent_end_ = (extent_end_ + align - 1) / align * align;
+	off_t pos = extent_end_;
+	extent_end_ += space;
+	if ((uint64_t) extent_end_ >> (64 - EXTENT_LEN_BITS) != 0) {
+		printf("file of extents is too large\n");
+		exit(1);
+	}
+	return pos;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::add_hole(			// free space of extents (hold ext_lock_)
+	off_t pos,							// offset in file
+	off_t len)							// length of space
+{
+	std::map<off_t, off_t>::iterator next = holes_.lower_bound(pos);
+	if (next != holes_.end() && next->first == pos + len) { // merge next
+		len += next->second;
+		hole_sizes_.erase(std::make_pair(next->second, next->first));
+		next = holes_.erase(next);
+	}
+	if (next != holes_.begin()) {	// merge previous
+		std::map<off_t, off_t>::iterator prev = next; --prev;
+		if (prev->first + prev->second == pos) {
+			pos  = prev->first;
+			len += prev->second;
+			hole_sizes_.erase(std::make_pair(prev->second, prev->first));
+			holes_.erase(prev);
+		}
+	}
+	holes_[pos] = len;
+	hole_sizes_.insert(std::make_pair(len, pos));
+}
+
+// -----------------------------------------------------------------------------
+//  the holes are the gaps between the extents of the table on disk (and the
+//  table itself), from the first block to the end of extents.
+// -----------------------------------------------------------------------------
+void BlockFile::find_holes()		// the space no extent uses (on open)
+{
+	std::vector<std::pair<off_t, off_t> > used;
+	used.push_back(std::make_pair(table_.pos_, (off_t) table_.len_));
+	for (int i = 0; i < num_blocks_; ++i) {
+		Extent e = { 0, 0 };
+		if (!get_extent(i, e)) continue;
+		used.push_back(std::make_pair(e.pos_, (off_t) e.len_));
+	}
+	std::sort(used.begin(), used.end());
+
+	off_t from = block_offset(0);
+	for (size_t i = 0; i < used.size(); ++i) {
+		if (used[i].first > from) add_hole(from, used[i].first - from);
+		from = MAX(from, used[i].first + used[i].second);
+	}
+	if (extent_end_ > from) add_hole(from, extent_end_ - from);
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::read_extent(		// read and decompress a block
+	Block block,						// a block (return)
+	int   index)						// pos of the block
+{
+	Extent e = { 0, 0 };
+	if (!get_extent(index, e)) {	// never written
+		memset(block, 0, block_length_);
+		return false;
+	}
+	off_t pos = e.pos_;
+	int   len = e.len_;
+	if (len == block_length_) return get_bytes(block, block_length_, pos);
+
+	char *buf = new char[len];
+	bool ok = get_bytes(buf, len, pos) &&
+		lz4_decompress(buf, len, block, block_length_) == block_length_;
+	delete[] buf; buf = NULL;
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::write_extent(		// compress and write a block
+	const char *block,					// a block
+	int   index)						// pos of the block
+{
+	char *buf = new char[lz4_bound(block_length_)];
+	int  len  = lz4_compress(block, block_length_, buf, block_length_ - 1);
+	const char *out = buf;
+	if (len == 0) {					// does not shrink, store as it is
+		out = block;
+		len = block_length_;
+	}
+	pthread_mutex_lock(&ext_lock_);
+	off_t pos = alloc_extent(len);
+	pthread_mutex_unlock(&ext_lock_);
+
+	bool ok = put_bytes(out, len, pos);
+	delete[] buf; buf = NULL;
+
+	pthread_mutex_lock(&ext_lock_);	// publish once the data is there
+	if (ok) set_extent(index, pos, len);
+	else add_hole(pos, len);		// no table uses it
+	pthread_mutex_unlock(&ext_lock_);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::write_staged(		// write staged blocks (maybe compressed)
+	char  *data,						// staged blocks
+	int   base,							// pos of the first block
+	int   num,							// num of blocks
+	char  *pack)						// <num> blocks for extents (lz4)
+{
+	if (crc_) {						// trailers are set by the flush
+		for (int i = 0; i < num; ++i) {
+			seal_block(&data[(size_t) i * block_length_]);
+		}
+	}
+	if (!lz4_) {
+		return put_bytes(data, num * block_length_, block_offset(base));
+	}
+	int *len = new int[num];
+	int total = 0;
+	for (int i = 0; i < num; ++i) {
+		const char *block = &data[(size_t) i * block_length_];
+		char *out = &pack[total];
+		len[i] = lz4_compress(block, block_length_, out, block_length_ - 1);
+		if (len[i] == 0) {
+			memcpy(out, block, block_length_);
+			len[i] = block_length_;
+		}
+		total += len[i];
+	}
+
+	pthread_mutex_lock(&ext_lock_);
+	off_t pos = alloc_extent(total);
+	pthread_mutex_unlock(&ext_lock_);
+
+	bool ok = put_bytes(pack, total, pos);
+
+	pthread_mutex_lock(&ext_lock_);	// publish once the data is there
+	for (int i = 0, off = 0; ok && i < num; off += len[i], ++i) {
+		set_extent(base + i, pos + off, len[i]);
+	}
+	if (!ok) add_hole(pos, total);	// no table uses it
+	pthread_mutex_unlock(&ext_lock_);
+	delete[] len; len = NULL;
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  the blocks are new ones of alloc_blocks(), so they are neither staged
+//  nor shadowed. it uses neither io_uring nor <pack_buf_>, so that many
+//  threads can write their runs at once (see BTree::bulkload_parallel()).
+// -----------------------------------------------------------------------------
+bool BlockFile::write_run(			// write a run of new blocks
+	char  *data,						// blocks (sealed here)
+	int   base,							// pos of the first block
+	int   num)							// num of blocks
+{
+	PerfScope scope(PHASE_FILE_WRITE);
+	char *pack = lz4_ ? new_block(num * block_length_) : NULL;
+	bool ok = write_staged(data, base, num, pack);
+	if (pack != NULL) { delete_block(pack); pack = NULL; }
+
+	if (cache_ != NULL) {			// write-through
+		for (int i = 0; i < num; ++i) {
+			cache_->put(base + i, &data[(size_t) i * block_length_]);
+		}
+	}
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  crc mode: the last <BLOCK_CRC_LENGTH> bytes of every block are the crc32c
+//  of the rest, so nodes see get_payload_length() bytes. the trailer is set
+//  when the block is written (in bulk mode, by the flush of its staging
+//  buffer), and checked when it is read from file if <verify>. the blocks
+//  which are already in the file are sealed, so it must be enabled right
+//  after BTree::init(), before nodes larger than the payload exist.
+// -----------------------------------------------------------------------------
+bool BlockFile::enable_crc(			// end every block with a crc32c trailer
+	bool verify)						// check the trailer on read?
+{
+	if (bulk_) {
+		printf("crc cannot be enabled in bulk mode\n");
+		return false;
+	}
+	if (!crc_ && committed_ > 0) {
+		printf("crc can only be enabled for a new tree\n");
+		return false;
+	}
+	if (!crc_) {
+		crc_ = true;				// <verify_> is still off
+		char *blk = new_block(block_length_);
+		for (int i = 0; i < num_blocks_; ++i) {
+			read_block(blk, i);
+			write_block(blk, i);
+		}
+		delete_block(blk); blk = NULL;
+
+		if (lz4_) save_extents();
+		else write_tail(0, 0);
+	}
+	verify_ = verify;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool BlockFile::check_block(		// check the crc32c trailer of a block
+	const char *block,					// a block
+	int   index)						// pos of the block
+{
+	uint32_t crc = 0;
+	memcpy(&crc, &block[block_length_ - BLOCK_CRC_LENGTH], BLOCK_CRC_LENGTH);
+	if (crc == crc32c(block, block_length_ - BLOCK_CRC_LENGTH)) return true;
+
+	printf("checksum mismatch in block %d\n", index);
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+struct VerifyArgs {					// args of a verify thread
+	BlockFile *file_;					// file to be checked
+	std::atomic<int> *next_;			// next chunk to check
+	std::atomic<int> *bad_;				// num of bad blocks (return)
+};
+
+// -----------------------------------------------------------------------------
+static void* verify_thread(void *arg)
+{
+	VerifyArgs *a = (VerifyArgs *) arg;
+	a->file_->run_verify(a->next_, a->bad_);
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  the threads take chunks of <VERIFY_CHUNK> blocks from a shared counter;
+//  a chunk of raw blocks is read by one request, the extents one by one.
+// -----------------------------------------------------------------------------
+int BlockFile::verify(				// check all blocks, return num of bad
+	int num_threads)					// num of threads
+{
+	if (!crc_) {
+		printf("%s has no block checksums\n", fname_);
+		return 0;
+	}
+	if (bulk_) end_bulk();
+
+	std::atomic<int> next(0), bad(0);
+	num_threads = MAX(num_threads, 1);
+	pthread_t  *tid  = new pthread_t[num_threads];
+	VerifyArgs *args = new VerifyArgs[num_threads];
+	for (int i = 0; i < num_threads; ++i) {
+		args[i].file_ = this; args[i].next_ = &next; args[i].bad_ = &bad;
+		pthread_create(&tid[i], NULL, verify_thread, (void *) &args[i]);
+	}
+	for (int i = 0; i < num_threads; ++i) pthread_join(tid[i], NULL);
+
+	delete[] tid;  tid  = NULL;
+	delete[] args; args = NULL;
+	return bad.load();
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::run_verify(			// verify chunks of blocks (one thread)
+	std::atomic<int> *next,				// next chunk to check
+	std::atomic<int> *bad)				// num of bad blocks (return)
+{
+	char *buf = new_block(VERIFY_CHUNK * block_length_);
+	while (true) {
+		int first = next->fetch_add(VERIFY_CHUNK);
+		if (first >= num_blocks_) break;
+
+		int num = MIN(VERIFY_CHUNK, num_blocks_ - first);
+		if (!lz4_ && !get_bytes(buf, num * block_length_, block_offset(first))) {
+			printf("could not read blocks %d to %d\n", first, first + num - 1);
+			bad->fetch_add(num);
+			continue;
+		}
+		for (int i = 0; i < num; ++i) {
+			char *block = &buf[(size_t) i * block_length_];
+			bool ok = lz4_ ? read_extent(block, first + i) : true;
+			if (!ok) printf("could not read block %d\n", first + i);
+			if (!ok || !check_block(block, first + i)) bad->fetch_add(1);
+		}
+	}
+	delete_block(buf); buf = NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  bulk mode: appended blocks are numbered in memory and copied into a large
+//  staging buffer. they are overwritten in place while they are still in the
+//  buffer, and the full buffer is written with a single pwrite, so bulkload
+//  becomes one sequential stream. the header is updated once by end_bulk().
+//
+//  in async mode, a full buffer is pushed into a bounded lock-free queue and
+//  written by a background flush thread, while the builders go on with the
+//  next free buffer. they only wait if all <ASYNC_BUFFERS> are in flight.
+// -----------------------------------------------------------------------------
+static void* flush_thread(			// background flush thread
+	void *arg)							// the block file
+{
+	((BlockFile *) arg)->run_flusher();
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::begin_bulk(			// start bulk (write-combining) mode
+	int  buffer_size,					// size of staging buffer (bytes)
+	bool async)							// flush by a background thread?
+{
+	if (bulk_) return;
+
+	async_ = async;
+	stage_cap_ = MAX(buffer_size / block_length_, 1);
+	int num_bufs = async_ ? ASYNC_BUFFERS : 1;
+	for (int i = 0; i < num_bufs; ++i) {
+		if (posix_memalign((void **) &bufs_[i].data_, DIRECT_ALIGN,
+				(size_t) stage_cap_ * block_length_) != 0) {
+			printf("could not allocate staging buffer of %d bytes\n",
+				buffer_size);
+			exit(1);
+		}
+		bufs_[i].base_  = 0;
+		bufs_[i].num_   = 0;
+		bufs_[i].state_ = STAGE_FREE;
+	}
+	if (lz4_) pack_buf_ = new_block(stage_cap_ * block_length_);
+	cur_buf_ = 0;
+	bufs_[cur_buf_].state_ = STAGE_FILLING;
+
+	stage_      = bufs_[cur_buf_].data_;
+	stage_base_ = num_blocks_;
+	stage_num_  = 0;
+	bulk_       = true;
+
+	if (async_) {
+		queue_head_ = 0;
+		queue_tail_ = 0;
+		stop_      = false;
+		sem_init(&ready_sem_, 0, 0);
+		sem_init(&free_sem_,  0, ASYNC_BUFFERS - 1);
+		pthread_create(&flusher_, NULL, flush_thread, (void *) this);
+	}
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::end_bulk()			// flush staged blocks and stop bulk mode
+{
+	if (!bulk_) return;
+
+	flush_stage(0);
+	if (async_) {					// the queue is drained before stop
+		stop_ = true;
+		sem_post(&ready_sem_);
+		pthread_join(flusher_, NULL);
+		sem_destroy(&ready_sem_);
+		sem_destroy(&free_sem_);
+	}
+	fwrite_number(num_blocks_, SIZEINT); // update <num_blocks_> once
+	if (lz4_) {
+		save_extents();
+		delete_block(pack_buf_); pack_buf_ = NULL;
+	}
+
+	int num_bufs = async_ ? ASYNC_BUFFERS : 1;
+	for (int i = 0; i < num_bufs; ++i) {
+		free(bufs_[i].data_); bufs_[i].data_ = NULL;
+	}
+	stage_     = NULL;
+	stage_cap_ = 0;
+	bulk_      = false;
+	async_     = false;
+}
+
+// -----------------------------------------------------------------------------
+//  write all staged blocks except the last <lag> ones, which are moved to the
+//  front of the next buffer. the nodes which are still being filled are the
+//  last appended ones, so they are usually rewritten in memory rather than
+//  by a late pwrite.
+// -----------------------------------------------------------------------------
+void BlockFile::flush_stage(		// write staged blocks with one pwrite
+	int lag)							// num of last blocks kept in stage
+{
+	int num = stage_num_ - lag;
+	if (num <= 0) return;
+
+	char *tail = &stage_[num * block_length_];
+	if (!async_) {
+		write_staged(stage_, stage_base_, num, pack_buf_);
+		memmove(stage_, tail, lag * block_length_);
+	}
+	else {
+		// ---------------------------------------------------------------------
+		//  get a free buffer, then hand the full one to the flush thread
+		// ---------------------------------------------------------------------
+		PerfScope *wait_scope = new PerfScope(PHASE_FLUSH_WAIT);
+		sem_wait(&free_sem_);
+		delete wait_scope; wait_scope = NULL;
+
+		int next = 0;
+		while (bufs_[next].state_.load(std::memory_order_acquire) != STAGE_FREE) {
+			++next;
+		}
+		bufs_[next].state_ = STAGE_FILLING;
+		memcpy(bufs_[next].data_, tail, lag * block_length_);
+
+		StageBuffer &buf = bufs_[cur_buf_];
+		buf.base_ = stage_base_;
+		buf.num_  = num;
+		buf.state_.store(STAGE_FLUSHING, std::memory_order_release);
+
+		unsigned head = queue_head_.load(std::memory_order_relaxed);
+		queue_[head % ASYNC_BUFFERS] = cur_buf_;
+		queue_head_.store(head + 1, std::memory_order_release);
+		sem_post(&ready_sem_);
+
+		cur_buf_ = next;
+		stage_   = bufs_[next].data_;
+	}
+	stage_base_ += num;
+	stage_num_   = lag;
+}
+
+// -----------------------------------------------------------------------------
+void BlockFile::run_flusher()		// loop of the background flush thread
+{
+	while (true) {
+		sem_wait(&ready_sem_);
+
+		unsigned tail = queue_tail_.load(std::memory_order_relaxed);
+		if (tail == queue_head_.load(std::memory_order_acquire)) {
+			if (stop_) break;
+			continue;
+		}
+		StageBuffer &buf = bufs_[queue_[tail % ASYNC_BUFFERS]];
+		write_staged(buf.data_, buf.base_, buf.num_, pack_buf_);
+
+		queue_tail_.store(tail + 1, std::memory_order_release);
+		buf.state_.store(STAGE_FREE, std::memory_order_release);
+		sem_post(&free_sem_);
+	}
+}
+
+// -----------------------------------------------------------------------------
+StageBuffer* BlockFile::find_flushing(// find buffer being flushed with block
+	int index)							// pos of the block
+{
+	if (!async_) return NULL;
+
+	for (int i = 0; i < ASYNC_BUFFERS; ++i) {
+		StageBuffer &buf = bufs_[i];
+		if (buf.state_.load(std::memory_order_acquire) == STAGE_FLUSHING &&
+				index >= buf.base_ && index < buf.base_ + buf.num_) {
+			return &buf;
+		}
+	}
+	return NULL;
+}
@@ -1,96 +1,506 @@
-#ifndef __BLOCK_FILE_H
-#define __BLOCK_FILE_H
-
-#include <iostream>
-#include <cassert>
-#include <cmath>
-#include <cstring>
-
-#include "def.h"
-
-// -----------------------------------------------------------------------------
-//  NOTE: The author of the implementation of class BlockFile is Yufei Tao.
-//  Modified by Qiang HUANG
-// -----------------------------------------------------------------------------
-
-// -----------------------------------------------------------------------------
-//  BlockFile: structure of reading and writing file for b-tree
-// -----------------------------------------------------------------------------
-class BlockFile {
-public:
-	FILE *fp_;						// file pointer
-	char fname_[200];				// file name
-	bool new_flag_;					// specifies if this is a new file
-	
-	int block_length_;				// length of a block
-	int act_block_;					// block num of fp position
-	int num_blocks_;				// total num of blocks
-
-	// -------------------------------------------------------------------------
-	BlockFile(						// constructor
-		int  b_length,					// length of a block
-		const char *name);				// file name
-
-	// -------------------------------------------------------------------------
-	~BlockFile();					// destructor
-
-	// -------------------------------------------------------------------------
-	inline void put_bytes(const char *bytes, int num) // write <bytes> of length <num>
-	{ fwrite(bytes, num, 1, fp_); }
-
-	// -------------------------------------------------------------------------
-	inline void get_bytes(char *bytes, int num) // read <bytes> of length <num>
-	{ fread(bytes, num, 1, fp_); }
-
-	// -------------------------------------------------------------------------
-	inline void seek_block(int bnum) // move <fp_> to the right with <bnum>
-	{ fseek(fp_, (bnum-act_block_)*block_length_, SEEK_CUR); }
-
-	// -------------------------------------------------------------------------
-	inline bool file_new() 			// whether this block is modified?
-	{ return new_flag_; }
-
-	// -------------------------------------------------------------------------
-	inline int get_blocklength()	// get block length
-	{ return block_length_; }
-
-	// -------------------------------------------------------------------------
-	inline int get_num_of_blocks()	// get number of blocks
-	{ return num_blocks_; }
-
-	// -------------------------------------------------------------------------
-	inline void fwrite_number(int num) // write a value (type int)
-	{ put_bytes((char *) &num, SIZEINT); }
-
-	// -------------------------------------------------------------------------
-	inline int fread_number()		// read a value (type int)
-	{ char ca[SIZEINT]; get_bytes(ca, SIZEINT); return *((int *)ca); }
-
-	// -------------------------------------------------------------------------
-	void read_header(				// read remain bytes excluding header
-		char *buffer);					// contain remain bytes (return)
-
-	// -------------------------------------------------------------------------
-	void set_header(				// set remain bytes excluding header
-		const char *buffer);			// contain remain bytes
-
-	// -------------------------------------------------------------------------
-	bool read_block(				// read a block <b> in the <pos>
-		Block block,					// a block
-		int   index);					// pos of the block
-
-	// -------------------------------------------------------------------------
-	bool write_block(				// write a block <b> in the <pos>
-		Block block,					// a block
-		int   index);					// pos of the block
-
-	// -------------------------------------------------------------------------
-	int append_block(				// append a block at the end of file
-		Block block);					// a block
-
-	// -------------------------------------------------------------------------
-	bool delete_last_blocks(		// delete last <num> blocks
-		int num);						// num of blocks to be deleted
-};
-
-#endif // __BLOCK_FILE_H
+#ifndef __BLOCK_FILE_H
+#define __BLOCK_FILE_H
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "def.h"
+#include "perf_counter.h"
+#include "io_ring.h"
+#include "block_cache.h"
+#include "lz4.h"
+#include "crc32c.h"
+
+// -----------------------------------------------------------------------------
+//  NOTE: The author of the implementation of class BlockFile is Yufei Tao.
+//  Modified by Qiang HUANG
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//  aligned block buffers: required by O_DIRECT, so all the buffers of blocks
+//  which are passed to BlockFile should be allocated by new_block().
+// -----------------------------------------------------------------------------
+inline char* new_block(				// allocate an aligned block buffer
+	int length)							// length of the block
+{
+	char *blk = NULL;
+	if (posix_memalign((void **) &blk, DIRECT_ALIGN, length) != 0) {
+		printf("could not allocate block of %d bytes\n", length);
+		exit(1);
+	}
+	return blk;
+}
+
+// -----------------------------------------------------------------------------
+inline void delete_block(			// release a block buffer of new_block()
+	char *blk)							// the block
+{
+	free(blk);
+}
+
+// -----------------------------------------------------------------------------
+//  StageBuffer: staging buffer of bulk mode. once a buffer is handed to the
+//  flush thread (STAGE_FLUSHING), it is not modified until the flush thread
+//  marks it STAGE_FREE again.
+// -----------------------------------------------------------------------------
+enum StageState { STAGE_FREE = 0, STAGE_FILLING, STAGE_FLUSHING };
+
+struct StageBuffer {
+	char *data_;					// staged blocks
+	int  base_;						// first block of <data_> to be written
+	int  num_;						// num of blocks to be written
+	std::atomic<int> state_;		// state of this buffer (StageState)
+};
+
+// -----------------------------------------------------------------------------
+//  Extent: where a compressed block is stored. <len_> equal to the block
+//  length means that the block is stored as it is (it does not shrink).
+//  in the table, an extent is one word (<pos_> << EXTENT_LEN_BITS | <len_>),
+//  so a reader loads both at once.
+// -----------------------------------------------------------------------------
+struct Extent {
+	off_t pos_;						// offset in file
+	int   len_;						// length in file (0: not written)
+};
+typedef std::atomic<uint64_t> ExtentWord; // an extent in the table
+
+// -----------------------------------------------------------------------------
+//  Version: a block which the readers of the trees committed before epoch
+//  <until_> may still read, i.e., an old image of a block overwritten by a
+//  checkpoint, or a block of a tree replaced by a new one.
+// -----------------------------------------------------------------------------
+struct Version {
+	int block_;						// pos of the block (of the old image)
+	int until_;						// visible to epochs < <until_>
+};
+
+// -----------------------------------------------------------------------------
+//  BlockFile: structure of reading and writing file for b-tree
+// -----------------------------------------------------------------------------
+class BlockFile {
+public:
+	int  fd_;						// file descriptor
+	char fname_[200];				// file name
+	bool new_flag_;					// specifies if this is a new file
+
+	int block_length_;				// length of a block
+	int num_blocks_;				// total num of blocks
+
+	bool bulk_;						// whether in bulk (write-combining) mode
+	bool async_;					// whether flushed by background thread
+	char *stage_;					// staging buffer being filled
+	int  stage_cap_;				// max num of blocks in <stage_>
+	int  stage_base_;				// first block staged in <stage_>
+	int  stage_num_;				// num of blocks staged in <stage_>
+
+	int  cur_buf_;					// index of <stage_> in <bufs_>
+	StageBuffer bufs_[ASYNC_BUFFERS]; // staging buffers
+	int  queue_[ASYNC_BUFFERS];		// bounded queue of buffers to be flushed
+	std::atomic<unsigned> queue_head_; // next slot to push (builders)
+	std::atomic<unsigned> queue_tail_; // next slot to pop (flush thread)
+	std::atomic<bool> stop_;		// stop the flush thread
+	sem_t ready_sem_;				// num of buffers in <queue_>
+	sem_t free_sem_;				// num of free buffers
+	pthread_t flusher_;				// background flush thread
+
+	IoRing *ring_;					// io_uring backend (NULL: pread/pwrite)
+	bool direct_;					// whether opened with O_DIRECT
+	BlockCache *cache_;				// cache of blocks (NULL: no cache)
+
+	bool lz4_;						// whether blocks are lz4 extents
+	off_t extent_end_;				// end of extents (next extent)
+	std::atomic<ExtentWord*> *ext_;	// table of extents (chunks)
+	pthread_mutex_t ext_lock_;		// protect <extent_end_>, <ext_>, holes
+	std::vector<Extent> dead_;		// extents replaced since the last table
+	Extent table_;					// extent of the table in the file
+	std::map<off_t, off_t> holes_;	// free space of extents: pos -> length
+	std::set<std::pair<off_t, off_t> > hole_sizes_; // (length, pos) of holes
+	char *pack_buf_;				// compressed blocks of a flush
+
+	bool crc_;						// whether blocks end with crc32c
+	bool verify_;					// whether crc32c is checked on read
+
+	int  committed_;				// blocks of committed tree (read-only)
+	bool writeback_;				// keep writes of <committed_> in memory
+	std::atomic<int> write_errors_;	// num of failed write_block()
+	std::unordered_map<int, char*> dirty_; // dirty blocks of committed tree
+	pthread_mutex_t dirty_lock_;	// protect <dirty_>
+	bool undo_on_;					// keep images of changed blocks
+	std::unordered_map<int, char*> undo_; // image before change (NULL: new)
+
+	int  epoch_;					// epoch (seq) of the committed tree
+	int  oldest_;					// oldest epoch pinned (MAXINT: none)
+	std::unordered_map<int, std::vector<Version> > versions_; // old images
+	std::vector<Version> limbo_;	// freed blocks which may still be read
+	pthread_rwlock_t version_lock_;	// protect versions and free blocks
+
+	std::vector<uint64_t> free_map_; // bitmap of free blocks (1: free)
+	int  num_free_;					// num of free blocks
+	std::unordered_set<int> fresh_;	// free blocks of committed tree reused
+	int  map_block_;				// first block of saved free map
+	int  map_num_;					// num of blocks of saved free map
+
+	// -------------------------------------------------------------------------
+	BlockFile(						// constructor
+		int  b_length,					// length of a block
+		const char *name);				// file name
+
+	// -------------------------------------------------------------------------
+	~BlockFile();					// destructor
+
+	// -------------------------------------------------------------------------
+	bool put_bytes(					// write <bytes> of length <num> at <pos>
+		const char *bytes,				// bytes
+		int   num,						// length of bytes
+		off_t pos);						// offset in file
+
+	// -------------------------------------------------------------------------
+	bool get_bytes(					// read <bytes> of length <num> at <pos>
+		char  *bytes,					// bytes (return)
+		int   num,						// length of bytes
+		off_t pos);						// offset in file
+
+	// -------------------------------------------------------------------------
+	inline off_t block_offset(int index) // offset of external block <index>
+	{ return (off_t) (index + 1) * block_length_; }
+
+	// -------------------------------------------------------------------------
+	inline bool is_aligned(			// whether O_DIRECT can take the request
+		const char *bytes, int num, off_t pos)
+	{ return ((size_t) bytes | (size_t) num | (size_t) pos) % DIRECT_ALIGN == 0; }
+
+	// -------------------------------------------------------------------------
+	inline bool file_new() 			// whether this block is modified?
+	{ return new_flag_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_blocklength()	// get block length
+	{ return block_length_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_payload_length()	// bytes of a block usable by nodes
+	{ return crc_ ? block_length_ - BLOCK_CRC_LENGTH : block_length_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_num_of_blocks()	// get number of blocks
+	{ return num_blocks_; }
+
+	// -------------------------------------------------------------------------
+	inline void fwrite_number(int num, off_t pos) // write a value (type int)
+	{ put_bytes((char *) &num, SIZEINT, pos); }
+
+	// -------------------------------------------------------------------------
+	inline int fread_number(off_t pos) // read a value (type int)
+	{ int num = 0; get_bytes((char *) &num, SIZEINT, pos); return num; }
+
+	// -------------------------------------------------------------------------
+	void read_header(				// read remain bytes excluding header
+		char *buffer);					// contain remain bytes (return)
+
+	// -------------------------------------------------------------------------
+	void set_header(				// set remain bytes excluding header
+		const char *buffer);			// contain remain bytes
+
+	// -------------------------------------------------------------------------
+	bool read_block(				// read a block <b> in the <pos>
+		Block block,					// a block
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	bool write_block(				// write a block <b> in the <pos>
+		Block block,					// a block
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	bool read_blocks(				// read a batch of blocks
+		int  num,						// num of blocks
+		const int *index,				// pos of the blocks
+		char **blocks);					// blocks (return)
+
+	// -------------------------------------------------------------------------
+	bool write_blocks(				// write a batch of blocks
+		int  num,						// num of blocks
+		const int *index,				// pos of the blocks
+		char **blocks);					// blocks
+
+	// -------------------------------------------------------------------------
+	int append_block(				// append a block at the end of file
+		Block block,					// a block
+		int   near = -1);				// place after this block if free
+
+	// -------------------------------------------------------------------------
+	bool write_run(					// write a run of new blocks
+		char  *data,					// blocks (sealed here)
+		int   base,						// pos of the first block
+		int   num);						// num of blocks
+
+	// -------------------------------------------------------------------------
+	bool delete_last_blocks(		// delete last <num> blocks
+		int num);						// num of blocks to be deleted
+
+	// -------------------------------------------------------------------------
+	bool enable_uring(				// use io_uring instead of pread/pwrite
+		int depth);						// max num of requests in flight
+
+	// -------------------------------------------------------------------------
+	bool enable_direct();			// bypass the page cache by O_DIRECT
+
+	// -------------------------------------------------------------------------
+	void enable_cache(				// keep recently used blocks in memory
+		int num_blocks);				// max num of blocks in cache
+
+	// -------------------------------------------------------------------------
+	bool enable_lz4();				// store blocks as lz4 extents
+
+	inline bool is_lz4() { return lz4_; }
+
+	// -------------------------------------------------------------------------
+	void save_extents();			// write table of extents and the tail
+
+	// -------------------------------------------------------------------------
+	bool sync();					// make all written blocks durable
+
+	// -------------------------------------------------------------------------
+	inline void set_committed(		// blocks [0, num) are read-only
+		int num,						// num of blocks of committed tree
+		int epoch)						// epoch (seq) of committed tree
+	{ committed_ = num; epoch_ = epoch; fresh_.clear(); }
+
+	// -------------------------------------------------------------------------
+	inline void enable_writeback()	// updates of committed tree in memory
+	{ writeback_ = true; }
+
+	// -------------------------------------------------------------------------
+	inline int get_write_errors()	// num of failed (or refused) writes
+	{ return write_errors_.load(); }
+
+	// -------------------------------------------------------------------------
+	inline void begin_undo()		// keep images of the blocks changed
+	{ undo_on_ = true; }
+
+	// -------------------------------------------------------------------------
+	bool end_undo(					// drop the images, or restore them
+		bool keep);						// keep the changes?
+
+	// -------------------------------------------------------------------------
+	inline int get_num_dirty()		// num of dirty blocks of committed tree
+	{ return (int) dirty_.size(); }
+
+	// -------------------------------------------------------------------------
+	void get_dirty(					// dirty blocks of committed tree
+		std::vector<int> &index,		// pos of blocks (return)
+		std::vector<char*> &blocks);	// blocks (return)
+
+	// -------------------------------------------------------------------------
+	bool write_image(				// write a block in place (checkpoint)
+		const char *block,				// a block (sealed)
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	void clear_dirty();				// drop dirty blocks (written back)
+
+	// -------------------------------------------------------------------------
+	bool read_version(				// read a block as of a committed tree
+		Block block,					// a block (return)
+		int   index,					// pos of the block
+		int   epoch);					// epoch of the committed tree
+
+	// -------------------------------------------------------------------------
+	void free_block(				// free a block once no reader sees it
+		int index,						// pos of the block
+		int until);						// visible to epochs < <until>
+
+	// -------------------------------------------------------------------------
+	void reclaim(					// free blocks which no reader sees
+		int oldest);					// oldest epoch pinned (MAXINT: none)
+
+	// -------------------------------------------------------------------------
+	inline int get_num_free()		// num of free blocks
+	{ return num_free_; }
+
+	// -------------------------------------------------------------------------
+	int alloc_blocks(				// allocate an extent of free blocks
+		int num);						// num of blocks
+
+	// -------------------------------------------------------------------------
+	void free_blocks(				// free an extent of alloc_blocks()
+		int start,						// first block
+		int num);						// num of blocks
+
+	// -------------------------------------------------------------------------
+	bool save_free_map();			// write free map (before a commit)
+
+	// -------------------------------------------------------------------------
+	inline int get_map_block() { return map_block_; }
+	inline int get_map_num()   { return map_num_; }
+
+	// -------------------------------------------------------------------------
+	bool load_free_map(				// read free map of committed tree
+		int block,						// first block of free map
+		int num);						// num of blocks of free map
+
+	// -------------------------------------------------------------------------
+	void init_free_map(				// all blocks but <used> are free
+		const std::vector<int> &used);	// blocks of committed tree
+
+	// -------------------------------------------------------------------------
+	bool enable_crc(				// end every block with a crc32c trailer
+		bool verify);					// check the trailer on read?
+
+	inline bool is_crc() { return crc_; }
+
+	// -------------------------------------------------------------------------
+	int verify(						// check all blocks, return num of bad
+		int num_threads);				// num of threads
+
+	// -------------------------------------------------------------------------
+	void run_verify(				// verify chunks of blocks (one thread)
+		std::atomic<int> *next,			// next chunk to check
+		std::atomic<int> *bad);			// num of bad blocks (return)
+
+	// -------------------------------------------------------------------------
+	inline off_t get_file_size() { return lz4_ ? extent_end_ :
+		block_offset(num_blocks_); }
+
+	// -------------------------------------------------------------------------
+	void begin_bulk(				// start bulk (write-combining) mode
+		int  buffer_size,				// size of staging buffer (bytes)
+		bool async);					// flush by a background thread?
+
+	// -------------------------------------------------------------------------
+	void end_bulk();				// flush staged blocks and stop bulk mode
+
+	// -------------------------------------------------------------------------
+	void run_flusher();				// loop of the background flush thread
+
+protected:
+	// -------------------------------------------------------------------------
+	void read_tail();				// read the tail of header block
+
+	// -------------------------------------------------------------------------
+	void write_tail(				// write the tail of header block
+		off_t table_pos,				// offset of table of extents
+		int   table_num);				// num of entries of the table
+
+	// -------------------------------------------------------------------------
+	inline void seal_block(char *block) // set the crc32c trailer of a block
+	{
+		uint32_t crc = crc32c(block, block_length_ - BLOCK_CRC_LENGTH);
+		memcpy(&block[block_length_ - BLOCK_CRC_LENGTH], &crc,
+			BLOCK_CRC_LENGTH);
+	}
+
+	// -------------------------------------------------------------------------
+	bool read_raw(					// read a block from file (no cache)
+		Block block,					// a block (return)
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	bool write_raw(					// write a sealed block to file
+		const char *block,				// a block
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	int alloc_block(				// a free block or a new one at the end
+		int near);						// prefer a block after <near>
+
+	// -------------------------------------------------------------------------
+	inline bool is_free(int index)	// whether a block is free
+	{
+		size_t w = (size_t) index >> 6;
+		return w < free_map_.size() && (free_map_[w] >> (index & 63) & 1);
+	}
+
+	// -------------------------------------------------------------------------
+	void set_free(					// mark a block free or used
+		int  index,						// pos of the block
+		bool free);						// free?
+
+	// -------------------------------------------------------------------------
+	int find_free(					// first free block in [from, to)
+		int from,						// first pos
+		int to);						// end pos
+
+	// -------------------------------------------------------------------------
+	inline bool is_shadowed(int index) // block of committed tree (read-only)
+	{ return index < committed_ && fresh_.count(index) == 0; }
+
+	// -------------------------------------------------------------------------
+	bool check_block(				// check the crc32c trailer of a block
+		const char *block,				// a block
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	static std::atomic<ExtentWord*>* new_extent_table(); // no chunks yet
+
+	// -------------------------------------------------------------------------
+	bool get_extent(				// extent of a block (false: none)
+		int   index,					// pos of the block
+		Extent &e);						// extent (return)
+
+	// -------------------------------------------------------------------------
+	void set_extent(				// set extent of a block (hold ext_lock_)
+		int   index,					// pos of the block
+		off_t pos,						// offset in file
+		int   len);						// length in file
+
+	// -------------------------------------------------------------------------
+	off_t alloc_extent(				// space for an extent (hold ext_lock_)
+		int len);						// length of extent
+
+	// -------------------------------------------------------------------------
+	void add_hole(					// free space of extents (hold ext_lock_)
+		off_t pos,						// offset in file
+		off_t len);						// length of space
+
+	// -------------------------------------------------------------------------
+	void find_holes();				// the space no extent uses (on open)
+
+	// -------------------------------------------------------------------------
+	bool read_extent(				// read and decompress a block
+		Block block,					// a block (return)
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	bool write_extent(				// compress and write a block
+		const char *block,				// a block
+		int   index);					// pos of the block
+
+	// -------------------------------------------------------------------------
+	bool write_staged(				// write staged blocks (maybe compressed)
+		char  *data,					// staged blocks
+		int   base,						// pos of the first block
+		int   num,						// num of blocks
+		char  *pack);					// <num> blocks for extents (lz4)
+
+	// -------------------------------------------------------------------------
+	bool direct_bytes(				// unaligned i/o of O_DIRECT by a bounce
+		bool  write,					// write (true) or read (false)
+		char  *bytes,					// bytes
+		int   num,						// length of bytes
+		off_t pos);						// offset in file
+
+	// -------------------------------------------------------------------------
+	void flush_stage(				// write staged blocks with one pwrite
+		int lag);						// num of last blocks kept in stage
+
+	// -------------------------------------------------------------------------
+	StageBuffer* find_flushing(		// find buffer being flushed with block
+		int index);						// pos of the block
+};
+
+#endif // __BLOCK_FILE_H
@@ -0,0 +1,173 @@
+#include "bulk_loader.h"
+
+// -----------------------------------------------------------------------------
+BulkLoader::BulkLoader()			// constructor
+{
+	tree_       = NULL;
+	old_root_   = -1;
+	height_     = 0;
+	num_leaves_ = 0;
+	last_key_   = MINREAL;
+	ok_         = true;
+
+	leaf_       = NULL;
+	leaf_prev_  = NULL;
+	for (int i = 0; i < MAX_LEVELS; ++i) {
+		index_[i]      = NULL;
+		index_prev_[i] = NULL;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  the nodes left by a load without finish() are written as they are, but
+//  the tree is not replaced.
+// -----------------------------------------------------------------------------
+BulkLoader::~BulkLoader()			// destructor
+{
+	if (leaf_prev_ != NULL) { delete leaf_prev_; leaf_prev_ = NULL; }
+	if (leaf_ != NULL) { delete leaf_; leaf_ = NULL; }
+	for (int i = 0; i < MAX_LEVELS; ++i) {
+		if (index_prev_[i] != NULL) {
+			delete index_prev_[i]; index_prev_[i] = NULL;
+		}
+		if (index_[i] != NULL) {
+			delete index_[i]; index_[i] = NULL;
+		}
+	}
+	if (tree_ != NULL) { tree_->file_->end_bulk(); tree_ = NULL; }
+}
+
+// -----------------------------------------------------------------------------
+void BulkLoader::init(				// start a new tree (in bulk mode)
+	BTree *tree)						// b-tree, replaced by finish()
+{
+	tree_     = tree;
+	old_root_ = tree->committed_root_;
+	tree_->file_->begin_bulk(BULK_BUFFER, true); // one sequential stream
+}
+
+// -----------------------------------------------------------------------------
+bool BulkLoader::push(				// add an entry (in key order)
+	float key,							// input key
+	int   id)							// input object id
+{
+	if (key < last_key_) {
+		printf("bulkload: key %f after %f is not in order\n", key, last_key_);
+		ok_ = false;
+		return false;
+	}
+	last_key_ = key;
+
+	if (leaf_ != NULL && !leaf_->has_room(id, key)) close_leaf();
+	if (leaf_ == NULL) open_leaf();
+	leaf_->add_new_child(id, key);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool BulkLoader::push_batch(		// add entries (in key order)
+	int   n,							// number of entries
+	const Result *table)				// entries
+{
+	for (int i = 0; i < n; ++i) {
+		if (!push(table[i].key_, table[i].id_)) return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+void BulkLoader::open_leaf()		// new open leaf after <leaf_prev_>
+{
+	leaf_ = new BLeafNode();
+	leaf_->init(0, tree_);
+	if (leaf_prev_ != NULL) {
+		leaf_->set_left_sibling(leaf_prev_->get_block());
+		leaf_prev_->set_right_sibling(leaf_->get_block());
+		delete leaf_prev_; leaf_prev_ = NULL;
+	}
+	++num_leaves_;
+	height_ = MAX(height_, 1);
+}
+
+// -----------------------------------------------------------------------------
+void BulkLoader::close_leaf()		// close <leaf_>, add it to its parent
+{
+	leaf_prev_ = leaf_;
+	leaf_      = NULL;
+
+	PerfScope scope(PHASE_INDEX_BUILD);	// the levels above the leaves
+	add_index(1, leaf_prev_->get_key_of_node(), leaf_prev_->get_block());
+}
+
+// -----------------------------------------------------------------------------
+void BulkLoader::add_index(			// add a son to an index level
+	int   level,						// level (>= 1)
+	float key,							// first key of son
+	int   son)							// block of son
+{
+	if (level >= MAX_LEVELS) {
+		printf("bulkload: more than %d levels\n", MAX_LEVELS);
+		exit(1);
+	}
+	if (index_[level] != NULL && index_[level]->isFull()) close_index(level);
+	if (index_[level] == NULL) {
+		BIndexNode *node = new BIndexNode();
+		node->init(level, tree_);
+		if (index_prev_[level] != NULL) {
+			node->set_left_sibling(index_prev_[level]->get_block());
+			index_prev_[level]->set_right_sibling(node->get_block());
+			delete index_prev_[level]; index_prev_[level] = NULL;
+		}
+		index_[level] = node;
+		height_ = MAX(height_, level + 1);
+	}
+	index_[level]->add_new_child(key, son);
+}
+
+// -----------------------------------------------------------------------------
+void BulkLoader::close_index(		// close the open node of a level
+	int   level)						// level (>= 1)
+{
+	BIndexNode *node = index_[level];
+	index_prev_[level] = node;
+	index_[level]      = NULL;
+	add_index(level + 1, node->get_key_of_node(), node->get_block());
+}
+
+// -----------------------------------------------------------------------------
+//  closing the open node of a level adds a son to the level above, which
+//  may close (and open) a node there, or add a new top level.
+// -----------------------------------------------------------------------------
+int BulkLoader::finish()			// build the root, publish the new tree
+{
+	if (leaf_ == NULL) open_leaf();	// an empty tree has one leaf
+
+	int root = -1;
+	if (height_ == 1) root = leaf_->get_block();
+	else close_leaf();
+	if (leaf_prev_ != NULL) { delete leaf_prev_; leaf_prev_ = NULL; }
+	if (leaf_ != NULL) { delete leaf_; leaf_ = NULL; }
+
+	PerfScope *index_scope = new PerfScope(PHASE_INDEX_BUILD);
+	for (int level = 1; level < height_; ++level) {
+		if (level == height_ - 1) {	// the top level has one node
+			root = index_[level]->get_block();
+			delete index_[level]; index_[level] = NULL;
+		}
+		else close_index(level);
+
+		if (index_prev_[level] != NULL) {
+			delete index_prev_[level]; index_prev_[level] = NULL;
+		}
+	}
+	delete index_scope; index_scope = NULL;
+
+	BTree *tree = tree_;
+	tree_ = NULL;
+	tree->file_->end_bulk();
+	if (!ok_) return 1;				// keep the old tree
+
+	tree->root_ = root;
+	return tree->replace_tree(old_root_); // publish the new tree
+}
@@ -0,0 +1,97 @@
+#ifndef __BULK_LOADER_H
+#define __BULK_LOADER_H
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#include "def.h"
+#include "pri_queue.h"
+#include "b_node.h"
+#include "b_tree.h"
+
+class BTree;
+class BLeafNode;
+class BIndexNode;
+
+// -----------------------------------------------------------------------------
+//  BulkLoader: builds a new tree from entries pushed in key order, e.g., by
+//  a file reader or a merge, without an array of all entries.
+//
+//  only the rightmost node of each level is open (the right spine), and the
+//  node before it until it is linked to it. a node is closed when an entry
+//  does not fit into it any more, and its first key and block are added to
+//  its parent then. finish() closes the spine bottom-up; the top level has
+//  one node, which is the root. so the memory is O(height) blocks, and the
+//  tree has the same nodes as a level-by-level build (build_index()), but
+//  the nodes of a level are not consecutive blocks.
+//
+//  a node takes its block when it is opened, and it is written into the
+//  staging buffer of bulk mode when it is closed, so every block is written
+//  to disk once, in append order, and nothing is read back. only an index
+//  node which stays open longer than the staging buffer (at level 2 and up,
+//  a few per million entries) is written again by a late pwrite.
+//
+//  the price of one stream: leaves and index nodes take blocks from the
+//  same cursor, so an index node lies after about every <fanout> leaves,
+//  and the leaf chain is a run of consecutive blocks per index node, not
+//  one run as by bulkload_parallel() or rebuild(). a range of blocks for
+//  the index nodes would need the num of leaves in advance, or writes out
+//  of the sequential stream. compact() makes the leaves one run again.
+// -----------------------------------------------------------------------------
+class BulkLoader {
+public:
+	BulkLoader();					// constructor
+	~BulkLoader();					// destructor
+
+	// -------------------------------------------------------------------------
+	void init(						// start a new tree (in bulk mode)
+		BTree *tree);					// b-tree, replaced by finish()
+
+	// -------------------------------------------------------------------------
+	bool push(						// add an entry (in key order)
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	bool push_batch(				// add entries (in key order)
+		int   n,						// number of entries
+		const Result *table);			// entries
+
+	// -------------------------------------------------------------------------
+	int finish();					// build the root, publish the new tree
+
+	// -------------------------------------------------------------------------
+	inline int get_num_leaves() { return num_leaves_; }
+
+protected:
+	BTree *tree_;					// the tree (NULL: not started)
+	int   old_root_;				// root of the replaced tree
+	int   height_;					// num of levels with an open node
+	int   num_leaves_;				// num of leaves
+	float last_key_;				// key of the last entry
+	bool  ok_;						// all entries in key order so far
+
+	BLeafNode  *leaf_;				// open leaf (NULL: none)
+	BLeafNode  *leaf_prev_;			// closed leaf, not linked yet
+	BIndexNode *index_[MAX_LEVELS];	// open node of each index level
+	BIndexNode *index_prev_[MAX_LEVELS]; // closed node, not linked yet
+
+	// -------------------------------------------------------------------------
+	void open_leaf();				// new open leaf after <leaf_prev_>
+
+	// -------------------------------------------------------------------------
+	void close_leaf();				// close <leaf_>, add it to its parent
+
+	// -------------------------------------------------------------------------
+	void add_index(					// add a son to an index level
+		int   level,					// level (>= 1)
+		float key,						// first key of son
+		int   son);						// block of son
+
+	// -------------------------------------------------------------------------
+	void close_index(				// close the open node of a level
+		int   level);					// level (>= 1)
+};
+
+#endif // __BULK_LOADER_H
@@ -0,0 +1,80 @@
+#include "crc32c.h"
+
+#include <nmmintrin.h>
+
+const uint32_t CRC32C_POLY = 0x82f63b78u; // reflected castagnoli polynomial
+
+// -----------------------------------------------------------------------------
+//  table[k][b] is the crc of byte b followed by k zero bytes, so that 8 bytes
+//  are folded by 8 lookups which do not depend on each other.
+// -----------------------------------------------------------------------------
+struct Crc32cTable {
+	uint32_t t_[8][256];
+
+	Crc32cTable() {
+		for (int b = 0; b < 256; ++b) {
+			uint32_t crc = (uint32_t) b;
+			for (int j = 0; j < 8; ++j) {
+				crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : (crc >> 1);
+			}
+			t_[0][b] = crc;
+		}
+		for (int b = 0; b < 256; ++b) {
+			for (int k = 1; k < 8; ++k) {
+				t_[k][b] = (t_[k-1][b] >> 8) ^ t_[0][t_[k-1][b] & 0xff];
+			}
+		}
+	}
+};
+
+// -----------------------------------------------------------------------------
+static uint32_t crc32c_slice8(		// crc32c by slicing-by-8
+	uint32_t crc,						// crc of the previous bytes (inverted)
+	const unsigned char *p,				// bytes
+	int   len)							// num of bytes
+{
+	static const Crc32cTable table;
+	const uint32_t (*t)[256] = table.t_;
+
+	for (; len >= 8; p += 8, len -= 8) {
+		uint32_t lo = 0, hi = 0;
+		memcpy(&lo, p, 4); memcpy(&hi, p + 4, 4);
+		lo ^= crc;
+		crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+			t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+			t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+			t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+	}
+	for (; len > 0; ++p, --len) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+	return crc;
+}
+
+// -----------------------------------------------------------------------------
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(		// crc32c by the crc32 instruction
+	uint32_t crc,						// crc of the previous bytes (inverted)
+	const unsigned char *p,				// bytes
+	int   len)							// num of bytes
+{
+	uint64_t c = crc;
+	for (; len >= 8; p += 8, len -= 8) {
+		uint64_t v = 0; memcpy(&v, p, 8);
+		c = _mm_crc32_u64(c, v);
+	}
+	crc = (uint32_t) c;
+	for (; len > 0; ++p, --len) crc = _mm_crc32_u8(crc, *p);
+	return crc;
+}
+
+// -----------------------------------------------------------------------------
+uint32_t crc32c(					// crc32c of <len> bytes
+	const char *data,					// bytes
+	int   len)							// num of bytes
+{
+	static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+
+	const unsigned char *p = (const unsigned char *) data;
+	uint32_t crc = has_sse42 ? crc32c_sse42(0xffffffffu, p, len) :
+		crc32c_slice8(0xffffffffu, p, len);
+	return ~crc;
+}
@@ -0,0 +1,18 @@
+#ifndef __CRC32C_H
+#define __CRC32C_H
+
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  crc32c (castagnoli polynomial), as computed by the crc32 instruction of
+//  sse4.2. without sse4.2, it falls back to the table-driven slicing-by-8.
+// -----------------------------------------------------------------------------
+uint32_t crc32c(					// crc32c of <len> bytes
+	const char *data,					// bytes
+	int   len);							// num of bytes
+
+#endif // __CRC32C_H
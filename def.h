@@ -1,52 +1,101 @@
-#ifndef __DEF_H
-#define __DEF_H
-
-// -----------------------------------------------------------------------------
-//  Typedefs
-// -----------------------------------------------------------------------------
-typedef char Block[];
-
-// -----------------------------------------------------------------------------
-//  Macros
-// -----------------------------------------------------------------------------
-#define MIN(a, b)	(((a) < (b)) ? (a) : (b))
-#define MAX(a, b)	(((a) > (b)) ? (a) : (b))
-#define SQR(x)		((x) * (x))
-#define SUM(x, y)	((x) + (y))
-#define DIFF(x, y)	((y) - (x))
-#define SWAP(x, y)	{ int tmp=x; x=y; y=tmp; }
-
-#define SEEK_SET 0
-#define SEEK_CUR 1
-#define SEEK_END 2
-
-// -----------------------------------------------------------------------------
-//  Constants
-// -----------------------------------------------------------------------------
-// const int   TOPK[]         = { 1, 2, 5, 10, 20, 50, 100 };
-const int   TOPK[]         = {  100 };
-// const int   MAX_ROUND      = 7;
-const int   MAX_ROUND      = 1;  
-const int   MAXK           = TOPK[MAX_ROUND - 1];
-
-const float MAXREAL        = 3.402823466e+38F;
-const float MINREAL        = -MAXREAL;
-const int   MAXINT         = 2147483647;
-const int   MININT         = -MAXINT;
-
-const int   SIZEBOOL       = (int) sizeof(bool);
-const int   SIZECHAR       = (int) sizeof(char);
-const int   SIZEINT        = (int) sizeof(int);
-const int   SIZEFLOAT      = (int) sizeof(float);
-const int   SIZEDOUBLE     = (int) sizeof(double);
-
-const float E              = 2.7182818F;
-const float PI             = 3.141592654F;
-const float FLOATZERO      = 1e-6F;
-const float ANGLE          = PI / 8.0f;
-
-const int   CANDIDATES     = 100;
-const int   BFHEAD_LENGTH  = SIZEINT * 2;
-const int   LEAF_NODE_SIZE = 64;
-
-#endif // __DEF_H
+#ifndef __DEF_H
+#define __DEF_H
+
+// -----------------------------------------------------------------------------
+//  Typedefs
+// -----------------------------------------------------------------------------
+typedef char Block[];
+
+// -----------------------------------------------------------------------------
+//  Macros
+// -----------------------------------------------------------------------------
+#define MIN(a, b)	(((a) < (b)) ? (a) : (b))
+#define MAX(a, b)	(((a) > (b)) ? (a) : (b))
+#define SQR(x)		((x) * (x))
+#define SUM(x, y)	((x) + (y))
+#define DIFF(x, y)	((y) - (x))
+#define SWAP(x, y)	{ int tmp=x; x=y; y=tmp; }
+
+#define SEEK_SET 0
+#define SEEK_CUR 1
+#define SEEK_END 2
+
+// -----------------------------------------------------------------------------
+//  Constants
+// -----------------------------------------------------------------------------
+// const int   TOPK[]         = { 1, 2, 5, 10, 20, 50, 100 };
+const int   TOPK[]         = {  100 };
+// const int   MAX_ROUND      = 7;
+const int   MAX_ROUND      = 1;  
+const int   MAXK           = TOPK[MAX_ROUND - 1];
+
+const float MAXREAL        = 3.402823466e+38F;
+const float MINREAL        = -MAXREAL;
+const int   MAXINT         = 2147483647;
+const int   MININT         = -MAXINT;
+
+const int   SIZEBOOL       = (int) sizeof(bool);
+const int   SIZECHAR       = (int) sizeof(char);
+const int   SIZEINT        = (int) sizeof(int);
+const int   SIZEFLOAT      = (int) sizeof(float);
+const int   SIZEDOUBLE     = (int) sizeof(double);
+
+const float E              = 2.7182818F;
+const float PI             = 3.141592654F;
+const float FLOATZERO      = 1e-6F;
+const float ANGLE          = PI / 8.0f;
+
+const int   CANDIDATES     = 100;
+const int   BFHEAD_LENGTH  = SIZEINT * 2;
+const int   BFTAIL_LENGTH  = 32;	// tail of header block (extended header)
+const int   BFTAIL_MAGIC   = 0x31544642; // "BFT1"
+const int   BF_FLAG_LZ4    = 1;		// blocks are lz4 extents
+const int   BF_FLAG_CRC    = 2;		// blocks end with a crc32c trailer
+const int   BLOCK_CRC_LENGTH = 4;	// length of crc32c trailer of a block
+const int   VERIFY_CHUNK   = 256;	// num of blocks per read of verify()
+const int   HEADER_SLOT    = 64;	// length of a slot of double-buffered header
+const int   HEADER_MAGIC   = 0x31485442; // "BTH1"
+const int   HEADER_MAGIC2  = 0x32485442; // "BTH2": slot with free map
+const int   ALLOC_WINDOW   = 1024;	// blocks after a sibling to place a node
+const int   WAL_MAGIC      = 0x314c4157; // "WAL1"
+const int   WAL_HEAD_LENGTH = 16;	// <magic> and <base> of log file
+const int   WAL_RECORD_HEAD = 16;	// <len>, <type> and <lsn> of a record
+const int   WAL_BUFFER     = 1048576; // initial log buffer
+const int   WAL_CHECKPOINT = 64 * 1048576; // log size of auto checkpoint
+const int   WAL_INSERT     = 1;		// record: insert <key>, <id>
+const int   WAL_DELETE     = 2;		// record: delete <key>, <id>
+const int   WAL_IMAGE      = 3;		// record: <block> and its content
+const int   WAL_CKPT       = 4;		// record: <root>, <num_blocks>
+const int   MAX_LEVELS     = 32;	// max height of b-tree (update path)
+const int   LSM_RUN        = 8192;	// entries of a sorted run of front buffer
+const int   LSM_BUFFER     = 1048576; // entries of front buffer before a merge
+const int   EXT_OUT_BUFFER = 65536;	// entries of write buffer of a run file
+const int   EXT_MIN_BUFFER = 4096;	// min entries of read buffer of a run
+const int   EXTENT_CHUNK   = 65536;	// num of extents per chunk of table
+const int   EXTENT_CHUNKS  = 32768;	// max num of chunks of table
+const int   EXTENT_LEN_BITS = 24;	// bits of length in an entry of table
+const int   LEAF_NODE_SIZE = 64;
+const int   BULK_BUFFER    = 4 * 1048576; // staging buffer of bulkload
+const int   ASYNC_BUFFERS  = 4;		// staging buffers of async bulkload
+const int   LOAD_TASK_NODES = 256;	// nodes of a task of parallel bulkload
+const int   LOAD_TASK_ENTRIES = 1048576; // entries of a leaf count task
+const int   URING_DEPTH    = 64;	// max num of io_uring requests in flight
+const int   SEARCH_BATCH   = 256;	// num of queries per level of search_batch
+const int   DIRECT_ALIGN   = 4096;	// alignment of buffers, offsets for O_DIRECT
+const int   CACHE_LINE     = 64;	// size of a cache line
+
+// -----------------------------------------------------------------------------
+//  format versions of index nodes (stored in the header of b-tree)
+// -----------------------------------------------------------------------------
+const int   NODE_FORMAT_PACKED = 0;	// 13-byte header, interleaved key/son
+const int   NODE_FORMAT_SOA    = 1;	// 64-byte header, aligned key[], son[]
+const int   NODE_FORMAT_EYTZINGER = 2; // as SOA, key[] in eytzinger order
+
+// -----------------------------------------------------------------------------
+//  flags in the <level> byte of a block
+// -----------------------------------------------------------------------------
+const int   LEVEL_MASK     = 0x3f;	// bits of level
+const int   LEAF_COMPRESSED = 0x40;	// leaf of frame-of-reference + bit-packing
+const int   LEAF_COMPRESS_RATIO = 8; // max entries of compressed / plain leaf
+
+#endif // __DEF_H
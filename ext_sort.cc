@@ -0,0 +1,275 @@
+#include "ext_sort.h"
+
+// -----------------------------------------------------------------------------
+static bool result_less(			// ResultComp order of records
+	const Result &a,					// 1st record
+	const Result &b)					// 2nd record
+{
+	return ResultComp(&a, &b) < 0;
+}
+
+// -----------------------------------------------------------------------------
+struct SortArg {					// slice of a chunk sorted by a thread
+	Result *from_;						// first record
+	int    n_;							// num of records
+};
+
+// -----------------------------------------------------------------------------
+static void* sort_thread(			// sort a slice of a chunk
+	void *arg)							// the slice (SortArg)
+{
+	SortArg *slice = (SortArg *) arg;
+	std::sort(slice->from_, slice->from_ + slice->n_, result_less);
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+LoserTree::LoserTree(				// constructor
+	int k)								// num of sources
+{
+	k_    = MAX(k, 1);
+	tree_ = new int[k_];
+	head_ = new Result[k_];
+	done_ = new bool[k_];
+	for (int i = 0; i < k_; ++i) {
+		tree_[i] = i;
+		done_[i] = true;
+	}
+}
+
+// -----------------------------------------------------------------------------
+LoserTree::~LoserTree()				// destructor
+{
+	delete[] tree_; tree_ = NULL;
+	delete[] head_; head_ = NULL;
+	delete[] done_; done_ = NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  inner nodes are 1..k-1 and source i is node k+i, so that the parent of
+//  node j is j/2 for any k (not only powers of 2).
+// -----------------------------------------------------------------------------
+int LoserTree::play(				// winner of the subtree of <node>
+	int node)							// node
+{
+	if (node >= k_) return node - k_;
+
+	int a = play(2 * node);
+	int b = play(2 * node + 1);
+	if (less(b, a)) std::swap(a, b);
+	tree_[node] = b;				// keep the loser
+	return a;
+}
+
+// -----------------------------------------------------------------------------
+void LoserTree::build()				// play all matches
+{
+	tree_[0] = (k_ == 1) ? 0 : play(1);
+}
+
+// -----------------------------------------------------------------------------
+void LoserTree::replace(			// next head of the winner, replay its path
+	const Result *r)					// next head (NULL: source is empty)
+{
+	int w = tree_[0];
+	set(w, r);
+	for (int node = (w + k_) / 2; node > 0; node /= 2) {
+		if (less(tree_[node], w)) std::swap(tree_[node], w);
+	}
+	tree_[0] = w;
+}
+
+// -----------------------------------------------------------------------------
+ExtSort::ExtSort()					// constructor
+{
+	fname_[0]    = '\0';
+	num_runs_    = 0;
+	num_records_ = 0;
+	num_threads_ = 1;
+
+	run_fp_  = NULL;
+	run_buf_ = NULL;
+	run_pos_ = NULL;
+	run_num_ = NULL;
+	run_cap_ = EXT_MIN_BUFFER;
+	tree_    = NULL;
+	ok_      = true;
+}
+
+// -----------------------------------------------------------------------------
+ExtSort::~ExtSort()					// destructor (remove run files)
+{
+	char fname[220];
+	for (int i = 0; i < num_runs_; ++i) {
+		if (run_fp_ != NULL && run_fp_[i] != NULL) fclose(run_fp_[i]);
+		if (run_buf_ != NULL) delete[] run_buf_[i];
+
+		run_name(i, fname);
+		remove(fname);
+	}
+	delete[] run_fp_;  run_fp_  = NULL;
+	delete[] run_buf_; run_buf_ = NULL;
+	delete[] run_pos_; run_pos_ = NULL;
+	delete[] run_num_; run_num_ = NULL;
+	if (tree_ != NULL) { delete tree_; tree_ = NULL; }
+}
+
+// -----------------------------------------------------------------------------
+bool ExtSort::open(					// sort a file into runs
+	const char *fname,					// binary file of Result records
+	size_t mem_bytes,					// memory for records
+	int   num_threads)					// threads to sort a chunk
+{
+	strncpy(fname_, fname, sizeof(fname_) - 1);
+	fname_[sizeof(fname_) - 1] = '\0';
+	num_threads_ = MAX(num_threads, 1);
+
+	FILE *fp = fopen(fname, "rb");
+	if (!fp) {
+		printf("Could not open %s\n", fname);
+		return false;
+	}
+	// -------------------------------------------------------------------------
+	//  the chunk and the write buffer of a run share <mem_bytes>
+	// -------------------------------------------------------------------------
+	size_t mem = MIN(mem_bytes / sizeof(Result), (size_t) 1 << 30);
+	int chunk_n = MAX((int) mem - EXT_OUT_BUFFER, EXT_MIN_BUFFER);
+	Result *chunk = new Result[chunk_n];
+	Result *out   = new Result[EXT_OUT_BUFFER];
+
+	int n = 0;
+	while (ok_ && (n = (int) fread(chunk, sizeof(Result), chunk_n, fp)) > 0) {
+		num_records_ += n;
+		ok_ = write_run(chunk, n, out);
+	}
+	if (ferror(fp)) {
+		printf("could not read %s\n", fname);
+		ok_ = false;
+	}
+	fclose(fp);
+	delete[] chunk; chunk = NULL;
+	delete[] out;   out   = NULL;
+
+	run_cap_ = MAX((int) (mem / MAX(num_runs_, 1)), EXT_MIN_BUFFER);
+	return ok_ && start_merge();
+}
+
+// -----------------------------------------------------------------------------
+//  the slices are sorted in parallel, and merged into the write buffer, so
+//  that no second chunk is needed to merge them.
+// -----------------------------------------------------------------------------
+bool ExtSort::write_run(			// sort a chunk, write it as a run
+	Result *chunk,						// records of chunk
+	int   n,							// num of records
+	Result *out)						// write buffer of EXT_OUT_BUFFER
+{
+	int t = MIN(num_threads_, MAX(n / EXT_MIN_BUFFER, 1));
+	pthread_t *threads = new pthread_t[t];
+	SortArg   *slices  = new SortArg[t];
+	for (int j = 0; j < t; ++j) {
+		int from = (int) ((int64_t) n * j / t);
+		int to   = (int) ((int64_t) n * (j + 1) / t);
+		slices[j].from_ = &chunk[from];
+		slices[j].n_    = to - from;
+		pthread_create(&threads[j], NULL, sort_thread, &slices[j]);
+	}
+	for (int j = 0; j < t; ++j) pthread_join(threads[j], NULL);
+
+	char fname[220];
+	run_name(num_runs_, fname);
+	FILE *fp = fopen(fname, "wb");
+	if (!fp) {
+		printf("Could not create %s\n", fname);
+		delete[] threads; delete[] slices;
+		return false;
+	}
+	++num_runs_;					// removed by destructor from now on
+
+	LoserTree *merger = new LoserTree(t);
+	int *pos = new int[t];
+	for (int j = 0; j < t; ++j) {
+		pos[j] = 0;
+		merger->set(j, slices[j].n_ > 0 ? slices[j].from_ : NULL);
+	}
+	merger->build();
+
+	bool ok = true;
+	int  m  = 0;					// num of records in <out>
+	while (ok && !merger->empty()) {
+		int w = merger->winner();
+		out[m++] = merger->top();
+		if (m == EXT_OUT_BUFFER) {
+			ok = (int) fwrite(out, sizeof(Result), m, fp) == m;
+			m  = 0;
+		}
+		++pos[w];
+		merger->replace(pos[w] < slices[w].n_ ? &slices[w].from_[pos[w]] : NULL);
+	}
+	if (ok && m > 0) ok = (int) fwrite(out, sizeof(Result), m, fp) == m;
+	if (fclose(fp) != 0) ok = false;
+	if (!ok) printf("could not write %s\n", fname);
+
+	delete merger;    merger  = NULL;
+	delete[] pos;     pos     = NULL;
+	delete[] threads; threads = NULL;
+	delete[] slices;  slices  = NULL;
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool ExtSort::start_merge()			// open runs and build the loser tree
+{
+	char fname[220];
+	run_fp_  = new FILE*[MAX(num_runs_, 1)];
+	run_buf_ = new Result*[MAX(num_runs_, 1)];
+	run_pos_ = new int[MAX(num_runs_, 1)];
+	run_num_ = new int[MAX(num_runs_, 1)];
+	tree_    = new LoserTree(num_runs_);
+
+	for (int i = 0; i < num_runs_; ++i) {
+		run_name(i, fname);
+		run_fp_[i]  = fopen(fname, "rb");
+		run_buf_[i] = new Result[run_cap_];
+		run_pos_[i] = 0;
+		run_num_[i] = 0;
+		if (!run_fp_[i]) {
+			printf("Could not open %s\n", fname);
+			ok_ = false;
+		}
+	}
+	for (int i = 0; ok_ && i < num_runs_; ++i) tree_->set(i, read_run(i));
+	tree_->build();
+
+	return ok_;
+}
+
+// -----------------------------------------------------------------------------
+const Result* ExtSort::read_run(	// next record of a run in merge
+	int i)								// run (NULL: end of run)
+{
+	if (run_pos_[i] == run_num_[i]) {
+		run_num_[i] = (int) fread(run_buf_[i], sizeof(Result), run_cap_,
+			run_fp_[i]);
+		run_pos_[i] = 0;
+		if (run_num_[i] == 0) {
+			if (ferror(run_fp_[i])) {
+				printf("could not read run %d of %s\n", i, fname_);
+				ok_ = false;
+			}
+			return NULL;
+		}
+	}
+	return &run_buf_[i][run_pos_[i]++];
+}
+
+// -----------------------------------------------------------------------------
+bool ExtSort::next(					// next record in ResultComp order
+	Result &r)							// record (return)
+{
+	if (tree_ == NULL || !ok_ || tree_->empty()) return false;
+
+	r = tree_->top();
+	tree_->replace(read_run(tree_->winner()));
+	return true;
+}
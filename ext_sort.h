@@ -0,0 +1,137 @@
+#ifndef __EXT_SORT_H
+#define __EXT_SORT_H
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "def.h"
+#include "pri_queue.h"
+
+// -----------------------------------------------------------------------------
+//  LoserTree: k-way merge of sorted sources in ResultComp order. the head of
+//  each source is a leaf, and every inner node keeps the loser of the match
+//  below it, so that replacing the head of the winner replays one path only
+//  (log k comparisons). an empty source loses against all others.
+// -----------------------------------------------------------------------------
+class LoserTree {
+public:
+	LoserTree(int k);				// constructor (given num of sources)
+	~LoserTree();					// destructor
+
+	// -------------------------------------------------------------------------
+	inline void set(				// set the head of a source before build()
+		int   i,						// source
+		const Result *r)				// head (NULL: empty source)
+	{
+		if (r != NULL) head_[i] = *r;
+		done_[i] = (r == NULL);
+	}
+
+	// -------------------------------------------------------------------------
+	void build();					// play all matches
+
+	// -------------------------------------------------------------------------
+	inline bool empty() { return done_[tree_[0]]; }
+
+	// -------------------------------------------------------------------------
+	inline int winner() { return tree_[0]; }
+
+	// -------------------------------------------------------------------------
+	inline const Result& top() { return head_[tree_[0]]; }
+
+	// -------------------------------------------------------------------------
+	void replace(					// next head of the winner, replay its path
+		const Result *r);				// next head (NULL: source is empty)
+
+protected:
+	int    k_;						// num of sources
+	int    *tree_;					// losers of inner nodes, winner at 0
+	Result *head_;					// head of each source
+	bool   *done_;					// whether a source is empty
+
+	// -------------------------------------------------------------------------
+	inline bool less(int a, int b) { // head of <a> before head of <b>?
+		if (done_[a] || done_[b]) return done_[b] && (!done_[a] || a < b);
+		int ret = ResultComp(&head_[a], &head_[b]);
+		return ret < 0 || (ret == 0 && a < b);
+	}
+
+	// -------------------------------------------------------------------------
+	int play(int node);				// winner of the subtree of <node>
+};
+
+// -----------------------------------------------------------------------------
+//  ExtSort: external sort of a binary file of Result records which does not
+//  fit into memory.
+//
+//  open() reads the file in chunks of <mem_bytes>, sorts each chunk by
+//  <num_threads> threads (each sorts a slice, the slices are merged by a
+//  LoserTree while the run is written) and writes it into <fname>.run<i>.
+//  next() then merges all runs in one pass by a LoserTree, with a read
+//  buffer of <mem_bytes> / (num of runs) for each run. one pass is enough
+//  as long as there are at most <mem_bytes> / (EXT_MIN_BUFFER records)
+//  runs, e.g., 8192 runs (2 TB of input) with 256 MB. the run files are
+//  removed by the destructor.
+// -----------------------------------------------------------------------------
+class ExtSort {
+public:
+	ExtSort();						// constructor
+	~ExtSort();						// destructor (remove run files)
+
+	// -------------------------------------------------------------------------
+	bool open(						// sort a file into runs
+		const char *fname,				// binary file of Result records
+		size_t mem_bytes,				// memory for records
+		int   num_threads);				// threads to sort a chunk
+
+	// -------------------------------------------------------------------------
+	bool next(						// next record in ResultComp order
+		Result &r);						// record (return)
+
+	// -------------------------------------------------------------------------
+	inline int get_num_runs() { return num_runs_; }
+
+	// -------------------------------------------------------------------------
+	inline int64_t get_num_records() { return num_records_; }
+
+	// -------------------------------------------------------------------------
+	inline bool is_ok() { return ok_; }
+
+protected:
+	char    fname_[200];			// file name of input
+	int     num_runs_;				// num of run files
+	int64_t num_records_;			// num of records of input
+	int     num_threads_;			// threads to sort a chunk
+
+	FILE    **run_fp_;				// run files in merge
+	Result  **run_buf_;				// read buffer of each run
+	int     *run_pos_;				// next record in read buffer
+	int     *run_num_;				// num of records in read buffer
+	int     run_cap_;				// capacity of a read buffer
+	LoserTree *tree_;				// merge of runs (NULL: not started)
+	bool    ok_;					// no i/o error so far
+
+	// -------------------------------------------------------------------------
+	inline void run_name(int i, char *fname) { // name of run file <i>
+		sprintf(fname, "%s.run%d", fname_, i);
+	}
+
+	// -------------------------------------------------------------------------
+	bool write_run(					// sort a chunk, write it as a run
+		Result *chunk,					// records of chunk
+		int   n,						// num of records
+		Result *out);					// write buffer of EXT_OUT_BUFFER
+
+	// -------------------------------------------------------------------------
+	bool start_merge();				// open runs and build the loser tree
+
+	// -------------------------------------------------------------------------
+	const Result* read_run(			// next record of a run in merge
+		int i);							// run (NULL: end of run)
+};
+
+#endif // __EXT_SORT_H
@@ -0,0 +1,271 @@
+#include "front_buffer.h"
+
+// -----------------------------------------------------------------------------
+static bool key_less(				// order of entries in runs
+	const Result &a,					// 1st entry
+	const Result &b)					// 2nd entry
+{
+	return a.key_ < b.key_;
+}
+
+// -----------------------------------------------------------------------------
+static void* merge_thread(			// background merge thread
+	void *arg)							// the front buffer
+{
+	((FrontBuffer *) arg)->run_merger();
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+FrontBuffer::FrontBuffer()			// constructor
+{
+	fname_[0]   = '\0';
+	tree_       = NULL;
+	num_        = 0;
+	limit_      = LSM_BUFFER;
+	num_merges_ = 0;
+	ok_         = true;
+	stop_       = false;
+	started_    = false;
+
+	pthread_rwlock_init(&tree_lock_, NULL);
+	pthread_mutex_init(&lock_, NULL);
+	pthread_cond_init(&cond_, NULL);
+}
+
+// -----------------------------------------------------------------------------
+FrontBuffer::~FrontBuffer()			// destructor (flush)
+{
+	if (started_) {
+		flush();
+		pthread_mutex_lock(&lock_);
+		stop_ = true;
+		pthread_cond_broadcast(&cond_);
+		pthread_mutex_unlock(&lock_);
+		pthread_join(merger_, NULL);
+	}
+	for (size_t i = 0; i < runs_.size(); ++i) delete runs_[i];
+	runs_.clear();
+	if (tree_ != NULL) { delete tree_; tree_ = NULL; }
+
+	pthread_cond_destroy(&cond_);
+	pthread_mutex_destroy(&lock_);
+	pthread_rwlock_destroy(&tree_lock_);
+}
+
+// -----------------------------------------------------------------------------
+bool FrontBuffer::open(				// open an existing tree file
+	const char *fname,					// file name
+	int   limit)						// entries in memory before a merge
+{
+	strncpy(fname_, fname, sizeof(fname_) - 1);
+	fname_[sizeof(fname_) - 1] = '\0';
+	limit_ = MAX(limit, LSM_RUN);
+
+	tree_ = new BTree();
+	tree_->init_restore(fname_);
+	if (tree_->key_stride_ != 1) {
+		printf("front buffer needs full keys in leaves (stride 1)\n");
+		return false;
+	}
+	tail_.reserve(LSM_RUN);
+	started_ = true;
+	pthread_create(&merger_, NULL, merge_thread, (void *) this);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+//  the tail is sorted in place under <lock_>, which is short enough for a
+//  run of <LSM_RUN> entries, so readers never see a run being built. once
+//  a merge has failed, nothing is frozen again, and inserts return 1.
+// -----------------------------------------------------------------------------
+int FrontBuffer::insert(			// insert an entry (into memory)
+	float key,							// input key
+	int   id)							// input object id
+{
+	Result e;
+	e.key_ = key;
+	e.id_  = id;
+
+	pthread_mutex_lock(&lock_);
+	while (ok_ && num_ >= limit_ && !frozen_.empty()) { // merge is behind
+		pthread_cond_wait(&cond_, &lock_);
+	}
+	if (!ok_) {
+		pthread_mutex_unlock(&lock_);
+		return 1;
+	}
+	tail_.push_back(e);
+	++num_;
+	if ((int) tail_.size() >= LSM_RUN) seal_tail();
+	if (num_ >= limit_ && frozen_.empty()) freeze();
+	pthread_mutex_unlock(&lock_);
+
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+void FrontBuffer::seal_tail()		// sort <tail_> into a run (hold lock_)
+{
+	if (tail_.empty()) return;
+
+	std::vector<Result> *run = new std::vector<Result>();
+	run->swap(tail_);
+	std::stable_sort(run->begin(), run->end(), key_less);
+	runs_.push_back(run);
+	tail_.reserve(LSM_RUN);
+}
+
+// -----------------------------------------------------------------------------
+void FrontBuffer::freeze()			// hand <runs_> to merger (hold lock_)
+{
+	seal_tail();
+	frozen_.swap(runs_);
+	num_ = 0;
+	pthread_cond_broadcast(&cond_);
+}
+
+// -----------------------------------------------------------------------------
+//  the tree and the memory are read under <tree_lock_>, which is taken
+//  before <lock_> (as by the merger), so that frozen runs and the tree they
+//  are merged into are never both seen.
+// -----------------------------------------------------------------------------
+int FrontBuffer::range_scan(		// entries of keys in [lo, hi]
+	float lo,							// lower bound of keys
+	float hi,							// upper bound of keys
+	std::vector<Result> &res)			// entries in key order (return)
+{
+	std::vector<Result> mem;
+	Result lo_e; lo_e.key_ = lo; lo_e.id_ = 0;
+
+	pthread_rwlock_rdlock(&tree_lock_);
+	pthread_mutex_lock(&lock_);
+	for (size_t i = 0; i < tail_.size(); ++i) {
+		if (tail_[i].key_ >= lo && tail_[i].key_ <= hi) mem.push_back(tail_[i]);
+	}
+	for (int k = 0; k < 2; ++k) {
+		std::vector<std::vector<Result>*> &runs = k == 0 ? frozen_ : runs_;
+		for (size_t r = 0; r < runs.size(); ++r) {
+			std::vector<Result>::iterator it = std::lower_bound(
+				runs[r]->begin(), runs[r]->end(), lo_e, key_less);
+			for (; it != runs[r]->end() && it->key_ <= hi; ++it) {
+				mem.push_back(*it);
+			}
+		}
+	}
+	pthread_mutex_unlock(&lock_);
+	std::stable_sort(mem.begin(), mem.end(), key_less);
+
+	std::vector<int>   ids;
+	std::vector<float> keys;
+	Snapshot *snap = tree_->pin_snapshot();
+	tree_->range_scan(snap, lo, hi, ids, &keys);
+	tree_->release_snapshot(snap);
+	pthread_rwlock_unlock(&tree_lock_);
+
+	std::vector<Result> disk(ids.size());
+	for (size_t i = 0; i < ids.size(); ++i) {
+		disk[i].key_ = keys[i];
+		disk[i].id_  = ids[i];
+	}
+	size_t num = res.size();		// entries of the tree come first
+	res.resize(num + disk.size() + mem.size());
+	std::merge(disk.begin(), disk.end(), mem.begin(), mem.end(),
+		res.begin() + num, key_less);
+
+	return (int) (res.size() - num);
+}
+
+// -----------------------------------------------------------------------------
+bool FrontBuffer::flush()			// merge all entries in memory
+{
+	pthread_mutex_lock(&lock_);
+	while (ok_ && (num_ > 0 || !frozen_.empty())) {
+		if (frozen_.empty()) freeze();
+		else pthread_cond_wait(&cond_, &lock_);
+	}
+	bool ok = ok_;
+	pthread_mutex_unlock(&lock_);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+void FrontBuffer::run_merger()		// loop of the background merge thread
+{
+	pthread_mutex_lock(&lock_);
+	while (true) {
+		while (frozen_.empty() && !stop_) pthread_cond_wait(&cond_, &lock_);
+		if (frozen_.empty()) break;	// stop
+		pthread_mutex_unlock(&lock_);
+
+		bool ok = merge_frozen();
+
+		pthread_mutex_lock(&lock_);
+		if (!ok) {					// keep the runs in memory, oldest first
+			ok_ = false;
+			for (size_t r = 0; r < frozen_.size(); ++r) {
+				num_ += (int) frozen_[r]->size();
+			}
+			runs_.insert(runs_.begin(), frozen_.begin(), frozen_.end());
+			frozen_.clear();
+		}
+		pthread_cond_broadcast(&cond_);
+		if (!ok) break;
+	}
+	pthread_mutex_unlock(&lock_);
+}
+
+// -----------------------------------------------------------------------------
+//  <frozen_> does not change until it is cleared here, so it is read
+//  without <lock_>. the runs are merged pairwise (in order, so entries of
+//  the same key stay in insertion order), and then merged with the tree
+//  into a new file, which replaces the tree file atomically. the old tree
+//  stays readable through its open file until it is deleted.
+// -----------------------------------------------------------------------------
+bool FrontBuffer::merge_frozen()	// merge <frozen_> into the tree
+{
+	std::vector<Result> delta;
+	std::vector<size_t> bounds(1, 0);
+	for (size_t r = 0; r < frozen_.size(); ++r) {
+		delta.insert(delta.end(), frozen_[r]->begin(), frozen_[r]->end());
+		bounds.push_back(delta.size());
+	}
+	while (bounds.size() > 2) {		// log(num of runs) passes
+		std::vector<size_t> next(1, 0);
+		for (size_t i = 1; i < bounds.size(); i += 2) {
+			if (i + 1 < bounds.size()) {
+				std::inplace_merge(delta.begin() + bounds[i - 1],
+					delta.begin() + bounds[i], delta.begin() + bounds[i + 1],
+					key_less);
+				next.push_back(bounds[i + 1]);
+			}
+			else next.push_back(bounds[i]);
+		}
+		bounds.swap(next);
+	}
+
+	char merge_file[220];
+	snprintf(merge_file, sizeof(merge_file), "%s.merge", fname_);
+	if (tree_->merge(merge_file, (int) delta.size(), &delta[0])) return false;
+	if (rename(merge_file, fname_) != 0) {
+		printf("could not rename %s to %s\n", merge_file, fname_);
+		return false;
+	}
+	BTree *tree = new BTree();
+	tree->init_restore(fname_);
+
+	pthread_rwlock_wrlock(&tree_lock_);
+	pthread_mutex_lock(&lock_);
+	BTree *old = tree_;
+	tree_ = tree;
+	for (size_t r = 0; r < frozen_.size(); ++r) delete frozen_[r];
+	frozen_.clear();
+	++num_merges_;
+	pthread_mutex_unlock(&lock_);
+	pthread_rwlock_unlock(&tree_lock_);
+
+	delete old; old = NULL;			// its file is unlinked
+	return true;
+}
@@ -0,0 +1,89 @@
+#ifndef __FRONT_BUFFER_H
+#define __FRONT_BUFFER_H
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <pthread.h>
+
+#include "def.h"
+#include "pri_queue.h"
+#include "b_tree.h"
+
+// -----------------------------------------------------------------------------
+//  FrontBuffer: sorted runs in memory in front of a BTree (LSM style).
+//
+//  insert() appends to an unsorted tail, which is sorted into a run when it
+//  has <LSM_RUN> entries. when the runs hold <limit_> entries, they are
+//  frozen, and a background thread merges them into the tree by
+//  BTree::merge() into <fname>.merge, which then replaces the tree file by
+//  rename(). new inserts go to new runs meanwhile; they wait only if the
+//  runs are full again before the merge is done.
+//
+//  reads merge the tail, the runs, the frozen runs and a snapshot of the
+//  tree. entries in memory are lost by a crash, flush() makes them durable.
+//  after a failed merge, the runs stay in memory and insert() fails.
+//  the tree needs full keys in leaves (stride 1), as BTree::merge().
+// -----------------------------------------------------------------------------
+class FrontBuffer {
+public:
+	FrontBuffer();					// constructor
+	~FrontBuffer();					// destructor (flush)
+
+	// -------------------------------------------------------------------------
+	bool open(						// open an existing tree file
+		const char *fname,				// file name
+		int   limit = LSM_BUFFER);		// entries in memory before a merge
+
+	// -------------------------------------------------------------------------
+	int insert(						// insert an entry (into memory)
+		float key,						// input key
+		int   id);						// input object id
+
+	// -------------------------------------------------------------------------
+	int range_scan(					// entries of keys in [lo, hi]
+		float lo,						// lower bound of keys
+		float hi,						// upper bound of keys
+		std::vector<Result> &res);		// entries in key order (return)
+
+	// -------------------------------------------------------------------------
+	bool flush();					// merge all entries in memory
+
+	// -------------------------------------------------------------------------
+	inline int get_num_merges() { return num_merges_; }
+
+	// -------------------------------------------------------------------------
+	void run_merger();				// loop of the background merge thread
+
+protected:
+	char  fname_[200];				// file name of tree
+	BTree *tree_;					// tree on disk
+	pthread_rwlock_t tree_lock_;	// readers of <tree_> and its swap
+
+	std::vector<Result> tail_;		// unsorted entries of the last run
+	std::vector<std::vector<Result>*> runs_; // sorted runs
+	std::vector<std::vector<Result>*> frozen_; // runs being merged
+	int   num_;						// num of entries in <tail_> and <runs_>
+	int   limit_;					// entries in memory before a merge
+	int   num_merges_;				// num of merges into the tree
+	bool  ok_;						// false if a merge has failed
+	bool  stop_;					// stop the merge thread
+
+	pthread_mutex_t lock_;			// protect all of memory above
+	pthread_cond_t  cond_;			// runs frozen, merged or stop
+	pthread_t merger_;				// background merge thread
+	bool  started_;					// whether <merger_> is started
+
+	// -------------------------------------------------------------------------
+	void seal_tail();				// sort <tail_> into a run (hold lock_)
+
+	// -------------------------------------------------------------------------
+	void freeze();					// hand <runs_> to merger (hold lock_)
+
+	// -------------------------------------------------------------------------
+	bool merge_frozen();			// merge <frozen_> into the tree
+};
+
+#endif // __FRONT_BUFFER_H
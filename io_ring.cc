@@ -0,0 +1,206 @@
+#include "io_ring.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// -----------------------------------------------------------------------------
+IoRing::IoRing()					// constructor
+{
+	ring_fd_    = -1;
+	file_fd_    = -1;
+	depth_      = 0;
+	length_     = 0;
+	fixed_file_ = false;
+	fixed_bufs_ = false;
+	bufs_       = NULL;
+	sq_ptr_     = NULL;
+	cq_ptr_     = NULL;
+	sq_len_     = 0;
+	cq_len_     = 0;
+	sqes_       = NULL;
+	sqes_len_   = 0;
+}
+
+// -----------------------------------------------------------------------------
+IoRing::~IoRing()					// destructor
+{
+	if (sqes_ != NULL) munmap(sqes_, sqes_len_);
+	if (cq_ptr_ != NULL && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_len_);
+	if (sq_ptr_ != NULL) munmap(sq_ptr_, sq_len_);
+	if (ring_fd_ >= 0) close(ring_fd_);	// also unregisters file and buffers
+	if (bufs_ != NULL) { free(bufs_); bufs_ = NULL; }
+}
+
+// -----------------------------------------------------------------------------
+//  return false if io_uring is not available (old kernel, seccomp, ...), so
+//  that the caller falls back to pread/pwrite. registering the file and the
+//  buffers is best effort: it may fail under a small RLIMIT_MEMLOCK, and then
+//  the plain (non-fixed) operations are used.
+// -----------------------------------------------------------------------------
+bool IoRing::init(					// setup ring, return false if unavailable
+	int fd,								// file to be registered
+	int depth,							// max num of requests in flight
+	int length)							// length of each request (bytes)
+{
+	io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	ring_fd_ = (int) syscall(__NR_io_uring_setup, depth, &p);
+	if (ring_fd_ < 0) return false;
+
+	file_fd_ = fd;
+	depth_   = (int) p.sq_entries;
+	length_  = length;
+
+	// -------------------------------------------------------------------------
+	//  map submission queue, completion queue and submission queue entries
+	// -------------------------------------------------------------------------
+	sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	cq_len_ = p.cq_off.cqes  + p.cq_entries * sizeof(io_uring_cqe);
+	bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single_mmap) sq_len_ = cq_len_ = MAX(sq_len_, cq_len_);
+
+	sq_ptr_ = mmap(NULL, sq_len_, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+	if (sq_ptr_ == MAP_FAILED) { sq_ptr_ = NULL; return false; }
+
+	if (single_mmap) {
+		cq_ptr_ = sq_ptr_;
+	}
+	else {
+		cq_ptr_ = mmap(NULL, cq_len_, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+		if (cq_ptr_ == MAP_FAILED) { cq_ptr_ = NULL; return false; }
+	}
+
+	sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+	sqes_ = (io_uring_sqe *) mmap(NULL, sqes_len_, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+	if (sqes_ == MAP_FAILED) { sqes_ = NULL; return false; }
+
+	char *sq = (char *) sq_ptr_;
+	char *cq = (char *) cq_ptr_;
+	sq_head_  = (unsigned *) (sq + p.sq_off.head);
+	sq_tail_  = (unsigned *) (sq + p.sq_off.tail);
+	sq_mask_  = (unsigned *) (sq + p.sq_off.ring_mask);
+	sq_array_ = (unsigned *) (sq + p.sq_off.array);
+	cq_head_  = (unsigned *) (cq + p.cq_off.head);
+	cq_tail_  = (unsigned *) (cq + p.cq_off.tail);
+	cq_mask_  = (unsigned *) (cq + p.cq_off.ring_mask);
+	cqes_     = (io_uring_cqe *) (cq + p.cq_off.cqes);
+
+	// -------------------------------------------------------------------------
+	//  register buffers and file
+	// -------------------------------------------------------------------------
+	if (posix_memalign((void **) &bufs_, DIRECT_ALIGN,
+			(size_t) depth_ * length_) != 0) {
+		bufs_ = NULL;
+		return false;
+	}
+	iovec iov;
+	iov.iov_base = bufs_;
+	iov.iov_len  = (size_t) depth_ * length_;
+	fixed_bufs_ = syscall(__NR_io_uring_register, ring_fd_,
+		IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+
+	int fds[1] = { fd };
+	fixed_file_ = syscall(__NR_io_uring_register, ring_fd_,
+		IORING_REGISTER_FILES, fds, 1) == 0;
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool IoRing::read(					// read a batch of blocks
+	int   num,							// num of blocks
+	const off_t *pos,					// offsets in file
+	char  **bufs)						// blocks (return)
+{
+	int op = fixed_bufs_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	bool ok = true;
+	for (int i = 0; i < num; i += depth_) {
+		int cnt = MIN(depth_, num - i);
+		if (!submit(op, cnt, &pos[i])) ok = false;
+
+		for (int j = 0; j < cnt; ++j) {
+			memcpy(bufs[i + j], &bufs_[(size_t) j * length_], length_);
+		}
+	}
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool IoRing::write(					// write a batch of blocks
+	int   num,							// num of blocks
+	const off_t *pos,					// offsets in file
+	char  **bufs)						// blocks
+{
+	int op = fixed_bufs_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+	bool ok = true;
+	for (int i = 0; i < num; i += depth_) {
+		int cnt = MIN(depth_, num - i);
+		for (int j = 0; j < cnt; ++j) {
+			memcpy(&bufs_[(size_t) j * length_], bufs[i + j], length_);
+		}
+		if (!submit(op, cnt, &pos[i])) ok = false;
+	}
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+//  request j uses the j-th registered buffer. all <num> requests are queued
+//  before a single io_uring_enter, which also waits for their completion.
+// -----------------------------------------------------------------------------
+bool IoRing::submit(				// submit <num> requests and wait for them
+	int   opcode,						// IORING_OP_READ(_FIXED) or WRITE
+	int   num,							// num of requests (<= depth_)
+	const off_t *pos)					// offsets in file
+{
+	unsigned tail = *sq_tail_;
+	unsigned mask = *sq_mask_;
+	for (int j = 0; j < num; ++j) {
+		unsigned idx = tail & mask;
+		io_uring_sqe *sqe = &sqes_[idx];
+		memset(sqe, 0, sizeof(*sqe));
+
+		sqe->opcode    = (unsigned char) opcode;
+		sqe->fd        = fixed_file_ ? 0 : file_fd_;
+		sqe->flags     = fixed_file_ ? IOSQE_FIXED_FILE : 0;
+		sqe->addr      = (unsigned long long) &bufs_[(size_t) j * length_];
+		sqe->len       = (unsigned) length_;
+		sqe->off       = (unsigned long long) pos[j];
+		sqe->buf_index = 0;
+		sqe->user_data = (unsigned long long) j;
+
+		sq_array_[idx] = idx;
+		++tail;
+	}
+	__atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+	// -------------------------------------------------------------------------
+	//  submit and reap completions
+	// -------------------------------------------------------------------------
+	bool ok = true;
+	int  to_submit = num;
+	int  done = 0;
+	while (done < num) {
+		int ret = (int) syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+			num - done, IORING_ENTER_GETEVENTS, NULL, 0);
+		if (ret < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		to_submit -= MIN(ret, to_submit);
+
+		unsigned head = *cq_head_;
+		unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+		while (head != cq_tail) {
+			io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+			if (cqe->res != length_) ok = false;
+			++head; ++done;
+		}
+		__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+	}
+	return ok;
+}
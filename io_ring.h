@@ -0,0 +1,79 @@
+#ifndef __IO_RING_H
+#define __IO_RING_H
+
+#include <iostream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  IoRing: minimal io_uring backend of BlockFile (no liburing needed). one
+//  file is registered as fixed file 0 and a pool of <depth> registered
+//  buffers of <length> bytes is used for all reads and writes, so a batch of
+//  up to <depth> blocks costs a single io_uring_enter.
+//
+//  NOTE: an IoRing is not thread-safe. it is driven by the caller of
+//  BlockFile, which is either single-threaded or holds the lock of the tree.
+// -----------------------------------------------------------------------------
+class IoRing {
+public:
+	IoRing();						// constructor
+	~IoRing();						// destructor
+
+	// -------------------------------------------------------------------------
+	bool init(						// setup ring, return false if unavailable
+		int fd,							// file to be registered
+		int depth,						// max num of requests in flight
+		int length);					// length of each request (bytes)
+
+	// -------------------------------------------------------------------------
+	bool read(						// read a batch of blocks
+		int   num,						// num of blocks
+		const off_t *pos,				// offsets in file
+		char  **bufs);					// blocks (return)
+
+	// -------------------------------------------------------------------------
+	bool write(						// write a batch of blocks
+		int   num,						// num of blocks
+		const off_t *pos,				// offsets in file
+		char  **bufs);					// blocks
+
+	// -------------------------------------------------------------------------
+	inline int get_depth() { return depth_; }
+
+protected:
+	int  ring_fd_;					// fd of io_uring instance
+	int  file_fd_;					// registered file
+	int  depth_;					// num of entries of sq
+	int  length_;					// length of each request
+	bool fixed_file_;				// whether <file_fd_> is registered
+	bool fixed_bufs_;				// whether <bufs_> are registered
+	char *bufs_;					// <depth_> buffers of <length_> bytes
+
+	void     *sq_ptr_;				// mmap of submission queue ring
+	void     *cq_ptr_;				// mmap of completion queue ring
+	size_t   sq_len_;				// length of <sq_ptr_>
+	size_t   cq_len_;				// length of <cq_ptr_>
+	io_uring_sqe *sqes_;			// submission queue entries
+	size_t   sqes_len_;				// length of <sqes_>
+
+	unsigned *sq_head_;				// head of sq (moved by kernel)
+	unsigned *sq_tail_;				// tail of sq (moved by us)
+	unsigned *sq_mask_;				// mask of sq
+	unsigned *sq_array_;			// index array of sq
+	unsigned *cq_head_;				// head of cq (moved by us)
+	unsigned *cq_tail_;				// tail of cq (moved by kernel)
+	unsigned *cq_mask_;				// mask of cq
+	io_uring_cqe *cqes_;			// completion queue entries
+
+	// -------------------------------------------------------------------------
+	bool submit(					// submit <num> requests and wait for them
+		int   opcode,					// IORING_OP_READ(_FIXED) or WRITE
+		int   num,						// num of requests (<= depth_)
+		const off_t *pos);				// offsets in file
+};
+
+#endif // __IO_RING_H
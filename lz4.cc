@@ -0,0 +1,159 @@
+#include "lz4.h"
+
+// -----------------------------------------------------------------------------
+//  a sequence is: token (4 bits of literal length, 4 bits of match length
+//  - 4), extra bytes of literal length, literals, offset (2 bytes, little
+//  endian) and extra bytes of match length. the last sequence has literals
+//  only. as required by the format, the last 5 bytes are always literals and
+//  the last match starts at least 12 bytes before the end.
+// -----------------------------------------------------------------------------
+const int LZ4_MINMATCH  = 4;
+const int LZ4_HASH_LOG  = 12;
+const int LZ4_MAX_DIST  = 65535;
+const int LZ4_LAST_LITS = 5;
+const int LZ4_MFLIMIT   = 12;
+
+// -----------------------------------------------------------------------------
+static inline uint32_t read32(const char *p)
+{
+	uint32_t v = 0; memcpy(&v, p, sizeof(v)); return v;
+}
+
+// -----------------------------------------------------------------------------
+static inline int hash32(uint32_t v)
+{
+	return (int) ((v * 2654435761u) >> (32 - LZ4_HASH_LOG));
+}
+
+// -----------------------------------------------------------------------------
+static inline char* write_length(	// write extra bytes of a length >= 15
+	char *op,							// output
+	int  len)							// length - 15
+{
+	for (; len >= 255; len -= 255) *op++ = (char) 255;
+	*op++ = (char) len;
+	return op;
+}
+
+// -----------------------------------------------------------------------------
+static char* write_sequence(		// write a sequence, NULL if no room
+	char  *op,							// output
+	char  *oend,						// end of output
+	const char *lit,					// literals
+	int   lit_len,						// num of literals
+	int   offset,						// offset of match (0: last sequence)
+	int   match_len)					// length of match
+{
+	int need = 1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1;
+	if (op + need > oend) return NULL;
+
+	char *token = op++;
+	int  ml = offset ? match_len - LZ4_MINMATCH : 0;
+	*token = (char) ((MIN(lit_len, 15) << 4) | MIN(ml, 15));
+
+	if (lit_len >= 15) op = write_length(op, lit_len - 15);
+	memcpy(op, lit, lit_len); op += lit_len;
+	if (offset == 0) return op;
+
+	*op++ = (char) (offset & 0xff);
+	*op++ = (char) (offset >> 8);
+	if (ml >= 15) op = write_length(op, ml - 15);
+	return op;
+}
+
+// -----------------------------------------------------------------------------
+int lz4_compress(					// compress, return 0 if it does not fit
+	const char *src,					// input
+	int   len,							// length of input
+	char  *dst,							// compressed bytes (return)
+	int   cap)							// capacity of <dst>
+{
+	int table[1 << LZ4_HASH_LOG];
+	for (int i = 0; i < (1 << LZ4_HASH_LOG); ++i) table[i] = -1;
+
+	char *op   = dst;
+	char *oend = dst + cap;
+	int  anchor = 0;
+	int  ip     = 0;
+	int  match_limit = len - LZ4_LAST_LITS;
+
+	while (ip < len - LZ4_MFLIMIT) {
+		uint32_t seq = read32(&src[ip]);
+		int h   = hash32(seq);
+		int ref = table[h];
+		table[h] = ip;
+		if (ref < 0 || ip - ref > LZ4_MAX_DIST || read32(&src[ref]) != seq) {
+			++ip;
+			continue;
+		}
+
+		int match_len = LZ4_MINMATCH;
+		while (ip + match_len < match_limit &&
+				src[ref + match_len] == src[ip + match_len]) {
+			++match_len;
+		}
+		op = write_sequence(op, oend, &src[anchor], ip - anchor, ip - ref,
+			match_len);
+		if (op == NULL) return 0;
+
+		ip += match_len;
+		anchor = ip;
+	}
+	op = write_sequence(op, oend, &src[anchor], len - anchor, 0, 0);
+	if (op == NULL) return 0;
+
+	return (int) (op - dst);
+}
+
+// -----------------------------------------------------------------------------
+static inline bool read_length(		// read extra bytes of a length
+	const unsigned char *src,			// compressed bytes
+	int   len,							// length of compressed bytes
+	int   &ip,							// pos in <src> (return)
+	int   &val)							// length (return)
+{
+	unsigned char b = 255;
+	while (b == 255) {
+		if (ip >= len) return false;
+		b = src[ip++];
+		val += b;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+int lz4_decompress(					// decompress, return -1 if corrupted
+	const char *src,					// compressed bytes
+	int   len,							// length of compressed bytes
+	char  *dst,							// output (return)
+	int   cap)							// capacity of <dst>
+{
+	const unsigned char *in = (const unsigned char *) src;
+	int ip = 0;
+	int op = 0;
+	while (ip < len) {
+		int token   = in[ip++];
+		int lit_len = token >> 4;
+		if (lit_len == 15 && !read_length(in, len, ip, lit_len)) return -1;
+		if (ip + lit_len > len || op + lit_len > cap) return -1;
+
+		memcpy(&dst[op], &in[ip], lit_len);
+		ip += lit_len; op += lit_len;
+		if (ip == len) break;		// last sequence
+
+		if (ip + 2 > len) return -1;
+		int offset = in[ip] | (in[ip + 1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op) return -1;
+
+		int match_len = token & 15;
+		if (match_len == 15 && !read_length(in, len, ip, match_len)) return -1;
+		match_len += LZ4_MINMATCH;
+		if (op + match_len > cap) return -1;
+
+		const char *ref = &dst[op - offset];	// may overlap the output
+		for (int i = 0; i < match_len; ++i) dst[op + i] = ref[i];
+		op += match_len;
+	}
+	return op;
+}
@@ -0,0 +1,34 @@
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  minimal in-tree codec of the LZ4 block format (greedy matching with a
+//  single hash table, no frame format), used to compress whole blocks.
+// -----------------------------------------------------------------------------
+inline int lz4_bound(				// max compressed size of <len> bytes
+	int len)							// length of input
+{
+	return len + len / 255 + 16;
+}
+
+// -----------------------------------------------------------------------------
+int lz4_compress(					// compress, return 0 if it does not fit
+	const char *src,					// input
+	int   len,							// length of input
+	char  *dst,							// compressed bytes (return)
+	int   cap);							// capacity of <dst>
+
+// -----------------------------------------------------------------------------
+int lz4_decompress(					// decompress, return -1 if corrupted
+	const char *src,					// compressed bytes
+	int   len,							// length of compressed bytes
+	char  *dst,							// output (return)
+	int   cap);							// capacity of <dst>
+
+#endif // __LZ4_H
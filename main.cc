@@ -1,156 +1,549 @@
-#include <iostream>
-#include <algorithm>
-#include <cmath>
-#include <cstdlib>
-#include <cstring>
-#include <vector>
-#include <string>
-#include <set>
-#include <fstream>
-#include <sstream>
-
-#include "def.h"
-#include "util.h"
-#include "random.h"
-#include "pri_queue.h"
-#include "b_node.h"
-#include "b_tree.h"
-
-using namespace std;
-
-void print_tree(BTree* trees) {
-	char print_file[200];
-	strncpy(print_file, "./result/print_tree.txt", sizeof(print_file));
-	printf("print_file = %s\n", print_file);
-
-	FILE *fp = fopen(print_file, "w+");
-	fclose(fp);
-	fp = fopen(print_file, "a");
-
-	BIndexNode *cur_node = NULL;
-	BIndexNode *nxt_node = NULL;
-	bool first_node;
-	int num_entries = 0;
-
-	int first_son_block = -1;
-	// print the index nodes
-	cur_node = new BIndexNode();
-	cur_node->init_restore(trees, trees->root_);
-	while (cur_node->get_level() != 0) {
-		first_node = true;
-		while (cur_node) {
-			// print every index node in the tree
-			if (cur_node->get_block() == trees->root_) {
-				fprintf(fp, "Root: ");
-			}
-			fprintf(fp, "Block %d\n", cur_node->get_block());
-			fprintf(fp, "\tlevel: %d\tnum_entries: %d\n", cur_node->get_level(), cur_node->get_num_entries());
-			num_entries = cur_node->get_num_entries();
-			for (int i = 0; i < num_entries; i++) {
-				fprintf(fp, "\t\tkey: %d\tson: %d\n", (int)cur_node->get_key(i), cur_node->get_son(i));
-			}
-
-			// get first node in each level
-			if (first_node) {
-				first_node = false;
-				first_son_block = cur_node->get_son(0);
-			}
-			nxt_node = cur_node->get_right_sibling();
-			delete cur_node; cur_node = nxt_node;
-		}
-		if (first_son_block == 1) break;  // when meet with leaf node, break
-		cur_node = new BIndexNode();
-		cur_node->init_restore(trees, first_son_block);
-	}
-	if (cur_node) {
-		delete cur_node; cur_node = NULL;
-	}
-
-	// print the leaf nodes
-	BLeafNode *leaf_node = NULL;
-	BLeafNode *next_node = NULL;
-	int leaf_num_entries = 0;
-	int leaf_num_keys = 0;
-	leaf_node = new BLeafNode();
-	leaf_node->init_restore(trees, 1);
-	while (leaf_node) {
-		fprintf(fp, "Leaf Block %d\n", leaf_node->get_block());
-		fprintf(fp, "\tlevel: %d\tnum_keys: %d\tnum_entries: %d\n", leaf_node->get_level(), leaf_node->get_num_keys(), leaf_node->get_num_entries());
-		leaf_num_entries = leaf_node->get_num_entries();
-		leaf_num_keys = leaf_node->get_num_keys();
-		for (int i = 0; i < leaf_num_entries; i++) {
-			if (i%16 == 0) {
-				fprintf(fp, "\t\tentry_id: %d\tkey: %d\n", leaf_node->get_entry_id(i), (int)leaf_node->get_key(i/16));
-			}
-			else {
-				fprintf(fp, "\t\tentry_id: %d\n", leaf_node->get_entry_id(i));
-			}
-		}
-
-		next_node = leaf_node->get_right_sibling();
-		delete leaf_node; leaf_node = next_node;
-	}
-	if (leaf_node) {
-		delete leaf_node; leaf_node = NULL;
-	}
-
-	fclose(fp);
-}
-
-// -----------------------------------------------------------------------------
-int main(int argc, char **args)
-{    
-	int num_workers = atoi(args[1]);
-	char data_file[200];
-	char tree_file[200];
-	int  B_ = 512; // node size
-	int n_pts_ = atoi(args[2]);
-
-	strncpy(data_file, "./data/dataset.csv", sizeof(data_file));
-	strncpy(tree_file, "./result/B_tree", sizeof(tree_file));
-	printf("data_file   = %s\n", data_file);
-	printf("tree_file   = %s\n", tree_file);
-
-	Result *table = new Result[n_pts_]; 
-	ifstream fp(data_file); 
-	string line;
-	int i=0;
-	while (getline(fp,line)){ 
-        string number;
-        istringstream readstr(line); 
-        
-		getline(readstr,number,','); 
-		table[i].key_ = atof(number.c_str()); 
-
-		getline(readstr,number,','); 
-		table[i].id_ = atoi(number.c_str());    
-        i++;
-    }
-	fp.close();
-
-	timeval start_t;  
-    timeval end_t;
-
-	gettimeofday(&start_t,NULL);
-	BTree* trees_ = new BTree();
-	trees_->init(B_, tree_file);
-	//对这个函数进行并行
-	if(num_workers == 0){
-		if(trees_->bulkload(n_pts_, table)) return 1;
-	}
-	else{
-		if (trees_->bulkload_parallel(n_pts_, table, num_workers)) return 1;
-	}
-	
-	delete[] table; table = NULL;
-
-	gettimeofday(&end_t, NULL);
-
-	float run_t1 = end_t.tv_sec - start_t.tv_sec + 
-						(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
-	printf("运行时间: %f  s\n", run_t1);
-	
-	print_tree(trees_);
-
-	return 0;
-}
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "def.h"
+#include "util.h"
+#include "random.h"
+#include "pri_queue.h"
+#include "b_node.h"
+#include "b_tree.h"
+#include "front_buffer.h"
+#include "radix_sort.h"
+#include "numa_topo.h"
+#include "perf_counter.h"
+
+using namespace std;
+
+// -----------------------------------------------------------------------------
+int leaf_runs(BTree* trees) {		// num of contiguous runs of leaf chain
+	int  block = trees->root_;
+	char *blk  = new_block(trees->file_->get_blocklength());
+	while (trees->file_->read_block(blk, block) &&
+			BNode::level_of_buffer(blk) > 0) {
+		BIndexNode *node = new BIndexNode();
+		node->init_restore(trees, block, blk);
+		block = node->get_son(0);
+		delete node; node = NULL;
+	}
+	delete_block(blk); blk = NULL;
+
+	int runs = 0;
+	int prev = -2;
+	BLeafNode *leaf = new BLeafNode();
+	leaf->init_restore(trees, block);
+	while (leaf) {
+		if (leaf->get_block() != prev + 1) ++runs;
+		prev = leaf->get_block();
+		BLeafNode *next = leaf->get_right_sibling();
+		delete leaf; leaf = next;
+	}
+	return runs;
+}
+
+// -----------------------------------------------------------------------------
+struct UpdateArg {					// keys of one writer thread
+	BTree *tree_;						// tree to update
+	FrontBuffer *buf_;					// front buffer of <tree_> (-lsm)
+	float *keys_;						// keys to insert
+	int   num_;							// num of keys
+	int   first_id_;					// id of the first key
+};
+
+// -----------------------------------------------------------------------------
+void* insert_thread(void *arg)		// insert keys one by one (durable)
+{
+	UpdateArg *u = (UpdateArg *) arg;
+	for (int i = 0; i < u->num_; ++i) {
+		if (u->tree_->insert(u->keys_[i], u->first_id_ + i)) break;
+	}
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+void* lsm_insert_thread(void *arg)	// insert keys into the front buffer
+{
+	UpdateArg *u = (UpdateArg *) arg;
+	for (int i = 0; i < u->num_; ++i) {
+		if (u->buf_->insert(u->keys_[i], u->first_id_ + i)) break;
+	}
+	return NULL;
+}
+
+void print_tree(BTree* trees) {
+	char print_file[200];
+	strncpy(print_file, "./result/print_tree.txt", sizeof(print_file));
+	printf("print_file = %s\n", print_file);
+
+	FILE *fp = fopen(print_file, "w+");
+	fclose(fp);
+	fp = fopen(print_file, "a");
+
+	BIndexNode *cur_node = NULL;
+	BIndexNode *nxt_node = NULL;
+	bool first_node;
+	int num_entries = 0;
+
+	int first_son_block = trees->root_;
+	int level = 0;
+	// print the index nodes
+	cur_node = new BIndexNode();
+	cur_node->init_restore(trees, trees->root_);
+	while (cur_node->get_level() != 0) {
+		first_node = true;
+		level = cur_node->get_level();
+		while (cur_node) {
+			// print every index node in the tree
+			if (cur_node->get_block() == trees->root_) {
+				fprintf(fp, "Root: ");
+			}
+			fprintf(fp, "Block %d\n", cur_node->get_block());
+			fprintf(fp, "\tlevel: %d\tnum_entries: %d\n", cur_node->get_level(), cur_node->get_num_entries());
+			num_entries = cur_node->get_num_entries();
+			for (int i = 0; i < num_entries; i++) {
+				fprintf(fp, "\t\tkey: %d\tson: %d\n", (int)cur_node->get_key(i), cur_node->get_son(i));
+			}
+
+			// get first node in each level
+			if (first_node) {
+				first_node = false;
+				first_son_block = cur_node->get_son(0);
+			}
+			nxt_node = cur_node->get_right_sibling();
+			delete cur_node; cur_node = nxt_node;
+		}
+		if (level == 1) break;  // when meet with leaf node, break
+		cur_node = new BIndexNode();
+		cur_node->init_restore(trees, first_son_block);
+	}
+	if (cur_node) {
+		delete cur_node; cur_node = NULL;
+	}
+
+	// print the leaf nodes
+	BLeafNode *leaf_node = NULL;
+	BLeafNode *next_node = NULL;
+	int leaf_num_entries = 0;
+	int leaf_num_keys = 0;
+	leaf_node = new BLeafNode();
+	leaf_node->init_restore(trees, first_son_block);
+	while (leaf_node) {
+		fprintf(fp, "Leaf Block %d\n", leaf_node->get_block());
+		fprintf(fp, "\tlevel: %d\tnum_keys: %d\tnum_entries: %d\n", leaf_node->get_level(), leaf_node->get_num_keys(), leaf_node->get_num_entries());
+		leaf_num_entries = leaf_node->get_num_entries();
+		leaf_num_keys = leaf_node->get_num_keys();
+		for (int i = 0; i < leaf_num_entries; i++) {
+			if (i%trees->key_stride_ == 0) {
+				fprintf(fp, "\t\tentry_id: %d\tkey: %d\n", leaf_node->get_entry_id(i), (int)leaf_node->get_key(i/trees->key_stride_));
+			}
+			else {
+				fprintf(fp, "\t\tentry_id: %d\n", leaf_node->get_entry_id(i));
+			}
+		}
+
+		next_node = leaf_node->get_right_sibling();
+		delete leaf_node; leaf_node = next_node;
+	}
+	if (leaf_node) {
+		delete leaf_node; leaf_node = NULL;
+	}
+
+	fclose(fp);
+}
+
+// -----------------------------------------------------------------------------
+struct ScanArg {					// full scans of snapshots
+	BTree *tree_;						// tree to scan
+	int   num_;							// num of scans
+	long  ids_;							// ids of the last scan (return)
+};
+
+// -----------------------------------------------------------------------------
+void* scan_thread(void *arg)		// scan pinned snapshots during inserts
+{
+	ScanArg *s = (ScanArg *) arg;
+	std::vector<int> ids;
+	for (int i = 0; i < s->num_; ++i) {
+		Snapshot *snap = s->tree_->pin_snapshot();
+		ids.clear();
+		s->tree_->range_scan(snap, MINREAL, MAXREAL, ids);
+		s->tree_->release_snapshot(snap);
+	}
+	s->ids_ = (long) ids.size();
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char **args)
+{    
+	int num_workers = atoi(args[1]);
+	char data_file[200];
+	char tree_file[200];
+	int  B_ = 512; // node size
+	int n_pts_ = atoi(args[2]);
+	bool uring = false;				// use io_uring for the tree file
+	int  qn    = 0;					// number of lookups after bulkload
+	bool direct = false;			// open the tree file with O_DIRECT
+	int  cache_blocks = 0;			// blocks of node cache (0: no cache)
+	int  format = NODE_FORMAT_PACKED; // format of index nodes
+	bool compress = false;			// build compressed leaves
+	int  stride = LEAF_NODE_SIZE / SIZEINT; // ids per key in leaves
+	bool lz4 = false;				// store blocks as lz4 extents
+	bool crc = false;				// end every block with crc32c
+	int  un  = 0;					// number of inserts after bulkload
+	int  num_writers = 1;			// threads of inserts
+	int  sn  = 0;					// number of scans during inserts
+	bool compact = false;			// rewrite leaves in key order at the end
+	float fill = 0.0f;				// fill of leaves of rebuild (0: none)
+	int  mn  = 0;					// number of delta entries to merge
+	int  ln  = 0;					// number of inserts into front buffer
+	int  em  = 0;					// MB of memory of external sort (0: none)
+	bool sort_table = false;		// shuffle the table, radix sort it again
+	bool numa = false;				// numa-local threads and table
+
+	// -------------------------------------------------------------------------
+	//  optional flags after [k] [N]
+	//  -perf:     time the hot phases of bulkload
+	//  -counters: also read hardware counters of the hot phases
+	//  -uring:    use io_uring for the tree file (fall back to pread/pwrite)
+	//  -query qn: run qn batched lookups of random keys after bulkload
+	//  -B size:   node size (default 512, a multiple of 4096 for -direct)
+	//  -direct:   bypass the page cache with O_DIRECT
+	//  -cache n:  keep the n most recently used blocks in memory
+	//  -soa:      cache-line aligned key[] and son[] in index nodes
+	//  -eytzinger: as -soa, with keys of index nodes in eytzinger order
+	//  -compress: frame-of-reference + bit-packed ids and keys in leaves
+	//  -stride s: keep one key per s ids in leaves (1: full keys)
+	//  -lz4:      compress every block of tree file with lz4 (smaller
+	//             only if the blocks compress, e.g. -stride 1)
+	//  -crc:      end every block with a crc32c trailer, checked on read
+	//  -updates u: insert u random keys after bulkload (needs -stride 1)
+	//  -writers w: insert by w threads, which share the syncs of the log
+	//  -scans s:  s full scans of snapshots by one thread during inserts
+	//  -compact:  rewrite the leaves in key order to one extent at the end
+	//  -rebuild f: copy the tree to B_tree.rebuild with leaves filled to f
+	//  -merge m:  merge m sorted random keys into B_tree.merge (-stride 1)
+	//  -lsm l:    insert l random keys by -writers threads into a front
+	//             buffer, which is merged into the tree (-stride 1)
+	//  -external m: bulkload from the shuffled table on disk by an external
+	//             sort with m MB of memory (k threads sort a chunk)
+	//  -sort:     shuffle the table, and sort it by k threads of radix sort
+	//             before bulkload
+	//  -numa:     pin the k threads of bulkload to numa nodes, and place
+	//             the slice of the table of each thread on its node
+	// -------------------------------------------------------------------------
+	for (int j = 3; j < argc; ++j) {
+		if (strcmp(args[j], "-perf") == 0) perf_enable(false);
+		else if (strcmp(args[j], "-counters") == 0) perf_enable(true);
+		else if (strcmp(args[j], "-uring") == 0) uring = true;
+		else if (strcmp(args[j], "-query") == 0 && j + 1 < argc) {
+			qn = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-B") == 0 && j + 1 < argc) {
+			B_ = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-direct") == 0) direct = true;
+		else if (strcmp(args[j], "-soa") == 0) format = NODE_FORMAT_SOA;
+		else if (strcmp(args[j], "-eytzinger") == 0) {
+			format = NODE_FORMAT_EYTZINGER;
+		}
+		else if (strcmp(args[j], "-compress") == 0) compress = true;
+		else if (strcmp(args[j], "-stride") == 0 && j + 1 < argc) {
+			stride = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-lz4") == 0) lz4 = true;
+		else if (strcmp(args[j], "-crc") == 0) crc = true;
+		else if (strcmp(args[j], "-cache") == 0 && j + 1 < argc) {
+			cache_blocks = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-updates") == 0 && j + 1 < argc) {
+			un = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-writers") == 0 && j + 1 < argc) {
+			num_writers = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-scans") == 0 && j + 1 < argc) {
+			sn = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-compact") == 0) compact = true;
+		else if (strcmp(args[j], "-rebuild") == 0 && j + 1 < argc) {
+			fill = atof(args[++j]);
+		}
+		else if (strcmp(args[j], "-merge") == 0 && j + 1 < argc) {
+			mn = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-lsm") == 0 && j + 1 < argc) {
+			ln = atoi(args[++j]);
+		}
+		else if (strcmp(args[j], "-sort") == 0) sort_table = true;
+		else if (strcmp(args[j], "-numa") == 0) numa = true;
+		else if (strcmp(args[j], "-external") == 0 && j + 1 < argc) {
+			em = atoi(args[++j]);
+		}
+		else printf("unknown flag %s\n", args[j]);
+	}
+
+	strncpy(data_file, "./data/dataset.csv", sizeof(data_file));
+	strncpy(tree_file, "./result/B_tree", sizeof(tree_file));
+	printf("data_file   = %s\n", data_file);
+	printf("tree_file   = %s\n", tree_file);
+
+	Result *table = new Result[n_pts_]; 
+	if (numa && num_workers > 0) {	// before the table is read
+		NumaTopo *topo = new NumaTopo();
+		topo->first_touch((char *) table, (size_t) n_pts_ * sizeof(Result),
+			num_workers);
+		printf("numa nodes  = %d\n", topo->get_num_nodes());
+		delete topo; topo = NULL;
+	}
+	ifstream fp(data_file); 
+	string line;
+	int i=0;
+	while (getline(fp,line)){ 
+        string number;
+        istringstream readstr(line); 
+        
+		getline(readstr,number,','); 
+		table[i].key_ = atof(number.c_str()); 
+
+		getline(readstr,number,','); 
+		table[i].id_ = atoi(number.c_str());    
+        i++;
+    }
+	fp.close();
+
+	float *query = new float[qn];	// sorted keys, so that reads are shared
+	for (int j = 0; j < qn; ++j) query[j] = table[rand() % n_pts_].key_;
+	sort(query, query + qn);
+
+	float *update = new float[un];	// keys of the inserts
+	for (int j = 0; j < un; ++j) update[j] = table[rand() % n_pts_].key_;
+
+	Result *delta = new Result[mn];	// sorted entries to merge
+	for (int j = 0; j < mn; ++j) {
+		delta[j].key_ = table[rand() % n_pts_].key_;
+		delta[j].id_  = n_pts_ + un + j;
+	}
+	qsort(delta, mn, sizeof(Result), ResultComp);
+
+	float *lsm_keys = new float[ln];	// keys of the inserts of -lsm
+	for (int j = 0; j < ln; ++j) lsm_keys[j] = table[rand() % n_pts_].key_;
+
+	char unsorted_file[sizeof(tree_file) + 16]; // input of -external, shuffled
+	snprintf(unsorted_file, sizeof(unsorted_file), "%s.unsorted", tree_file);
+	if (em > 0 || sort_table) random_shuffle(table, table + n_pts_);
+	if (em > 0) {
+		FILE *ufp = fopen(unsorted_file, "wb");
+		if (!ufp || (int) fwrite(table, sizeof(Result), n_pts_, ufp) != n_pts_) {
+			printf("could not write %s\n", unsorted_file);
+			return 1;
+		}
+		fclose(ufp);
+		delete[] table; table = NULL;	// the table is only on disk now
+	}
+
+	timeval start_t;  
+    timeval end_t;
+
+	gettimeofday(&start_t,NULL);
+	BTree* trees_ = new BTree();
+	trees_->init(B_, tree_file, format, stride);
+	trees_->compress_ = compress;
+	if (uring && !trees_->file_->enable_uring(URING_DEPTH)) {
+		printf("io_uring is not available, use pread/pwrite\n");
+	}
+	if (direct && !trees_->file_->enable_direct()) {
+		printf("use buffered i/o\n");
+	}
+	if (cache_blocks > 0) trees_->file_->enable_cache(cache_blocks);
+	if (numa) trees_->enable_numa();
+	if (lz4) trees_->file_->enable_lz4();
+	if (crc) trees_->file_->enable_crc(true);
+	if (sort_table && em == 0) {
+		timeval sort_t;
+		radix_sort(n_pts_, table, MAX(num_workers, 1));
+		gettimeofday(&sort_t, NULL);
+		printf("排序时间: %f  s\n", sort_t.tv_sec - start_t.tv_sec +
+			(sort_t.tv_usec - start_t.tv_usec) / 1000000.0f);
+	}
+	//对这个函数进行并行
+	if (em > 0) {
+		ExtSort *sorter = new ExtSort();
+		if (!sorter->open(unsorted_file, (size_t) em * 1048576,
+				MAX(num_workers, 1))) return 1;
+		if (trees_->bulkload(sorter)) return 1;
+		printf("外部排序: %lld entries, %d runs of %d MB\n",
+			(long long) sorter->get_num_records(), sorter->get_num_runs(), em);
+		delete sorter; sorter = NULL;
+		remove(unsorted_file);
+	}
+	else if(num_workers == 0){
+		if(trees_->bulkload(n_pts_, table)) return 1;
+	}
+	else{
+		if (trees_->bulkload_parallel(n_pts_, table, num_workers)) return 1;
+	}
+	
+	delete[] table; table = NULL;
+
+	gettimeofday(&end_t, NULL);
+
+	float run_t1 = end_t.tv_sec - start_t.tv_sec + 
+						(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+	printf("运行时间: %f  s\n", run_t1);
+	if (g_perf_enabled) perf_report(stdout);
+
+	if (qn > 0) {
+		int *blocks = new int[qn];
+		int *pos    = new int[qn];
+
+		gettimeofday(&start_t, NULL);
+		trees_->search_batch(qn, query, blocks, pos);
+		gettimeofday(&end_t, NULL);
+
+		float run_t2 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		printf("查询时间: %f  s (%d queries)\n", run_t2, qn);
+
+		delete[] blocks; blocks = NULL;
+		delete[] pos;    pos    = NULL;
+	}
+	delete[] query; query = NULL;
+
+	num_writers = MAX(num_writers, 1);
+	if (un > 0 && trees_->enable_wal()) {
+		pthread_t *threads = new pthread_t[num_writers];
+		UpdateArg *uargs   = new UpdateArg[num_writers];
+		int per = (un + num_writers - 1) / num_writers;
+
+		pthread_t scanner;
+		ScanArg   sarg = { trees_, sn, 0 };
+
+		gettimeofday(&start_t, NULL);
+		if (sn > 0) pthread_create(&scanner, NULL, scan_thread, &sarg);
+		for (int j = 0; j < num_writers; ++j) {
+			int from = MIN(j * per, un);
+			uargs[j].tree_     = trees_;
+			uargs[j].buf_      = NULL;
+			uargs[j].keys_     = &update[from];
+			uargs[j].num_      = MIN(from + per, un) - from;
+			uargs[j].first_id_ = n_pts_ + from;
+			pthread_create(&threads[j], NULL, insert_thread, &uargs[j]);
+		}
+		for (int j = 0; j < num_writers; ++j) pthread_join(threads[j], NULL);
+		gettimeofday(&end_t, NULL);
+		if (sn > 0) {
+			pthread_join(scanner, NULL);
+			printf("%d scans of snapshots, %ld ids in the last one\n", sn,
+				sarg.ids_);
+		}
+
+		float run_t3 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		printf("插入时间: %f  s (%d inserts, %d writers, %d syncs)\n",
+			run_t3, un, num_writers, trees_->wal_->get_num_syncs());
+
+		delete[] threads; threads = NULL;
+		delete[] uargs;   uargs   = NULL;
+	}
+	delete[] update; update = NULL;
+
+	if (ln > 0) {					// the buffer opens the tree file again
+		delete trees_; trees_ = NULL;
+		FrontBuffer *buf = new FrontBuffer();
+		if (!buf->open(tree_file)) return 1;
+
+		pthread_t *threads = new pthread_t[num_writers];
+		UpdateArg *uargs   = new UpdateArg[num_writers];
+		int per = (ln + num_writers - 1) / num_writers;
+
+		gettimeofday(&start_t, NULL);
+		for (int j = 0; j < num_writers; ++j) {
+			int from = MIN(j * per, ln);
+			uargs[j].tree_     = NULL;
+			uargs[j].buf_      = buf;
+			uargs[j].keys_     = &lsm_keys[from];
+			uargs[j].num_      = MIN(from + per, ln) - from;
+			uargs[j].first_id_ = n_pts_ + un + mn + from;
+			pthread_create(&threads[j], NULL, lsm_insert_thread, &uargs[j]);
+		}
+		for (int j = 0; j < num_writers; ++j) pthread_join(threads[j], NULL);
+		gettimeofday(&end_t, NULL);
+		float run_t7 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		if (!buf->flush()) return 1;
+		gettimeofday(&end_t, NULL);
+		float run_t8 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		printf("LSM 插入时间: %f  s (%d inserts, %d writers, %.0f inserts/s), "
+			"合并完成: %f  s (%d merges)\n", run_t7, ln, num_writers,
+			ln / MAX(run_t7, 1e-6f), run_t8, buf->get_num_merges());
+
+		delete buf; buf = NULL;
+		delete[] threads; threads = NULL;
+		delete[] uargs;   uargs   = NULL;
+
+		trees_ = new BTree();
+		trees_->init_restore(tree_file);
+	}
+	delete[] lsm_keys; lsm_keys = NULL;
+	
+	if (compact) {
+		int runs = leaf_runs(trees_);
+		gettimeofday(&start_t, NULL);
+		if (trees_->compact()) return 1;
+		gettimeofday(&end_t, NULL);
+
+		float run_t4 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		printf("压缩时间: %f  s (leaf runs %d -> %d, %d free blocks)\n",
+			run_t4, runs, leaf_runs(trees_), trees_->file_->get_num_free());
+	}
+	if (fill > 0.0f) {
+		char rebuild_file[sizeof(tree_file) + 16];
+		snprintf(rebuild_file, sizeof(rebuild_file), "%s.rebuild", tree_file);
+		gettimeofday(&start_t, NULL);
+		if (trees_->rebuild(rebuild_file, fill)) return 1;
+		gettimeofday(&end_t, NULL);
+
+		BTree *copy = new BTree();
+		copy->init_restore(rebuild_file);
+		float run_t5 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		printf("重建时间: %f  s (%s, leaf runs %d, %lld bytes)\n",
+			run_t5, rebuild_file, leaf_runs(copy),
+			(long long) copy->file_->get_file_size());
+		delete copy; copy = NULL;
+	}
+	if (mn > 0) {
+		char merge_file[sizeof(tree_file) + 16];
+		snprintf(merge_file, sizeof(merge_file), "%s.merge", tree_file);
+		gettimeofday(&start_t, NULL);
+		if (trees_->merge(merge_file, mn, delta)) return 1;
+		gettimeofday(&end_t, NULL);
+
+		float run_t6 = end_t.tv_sec - start_t.tv_sec + 
+							(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+		printf("合并时间: %f  s (%s, %d entries, %d leaves copied)\n",
+			run_t6, merge_file, mn, trees_->num_copied_);
+	}
+	delete[] delta; delta = NULL;
+
+	print_tree(trees_);
+	delete trees_; trees_ = NULL;	// write the header of tree file
+
+	struct stat st;					// after the last table of extents
+	if (stat(tree_file, &st) == 0) {
+		printf("file size: %lld bytes\n", (long long) st.st_size);
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "numa_topo.h"
+
+// -----------------------------------------------------------------------------
+NumaTopo::NumaTopo()				// constructor (reads the topology)
+{
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0) {
+		for (int c = 0; c < CPU_SETSIZE; ++c) CPU_SET(c, &allowed);
+	}
+
+	std::vector<int> nodes;
+	read_list("/sys/devices/system/node/online", nodes);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		char fname[100];
+		sprintf(fname, "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+		std::vector<int> ids;
+		if (!read_list(fname, ids)) continue;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (size_t j = 0; j < ids.size(); ++j) {
+			if (ids[j] < CPU_SETSIZE && CPU_ISSET(ids[j], &allowed)) {
+				CPU_SET(ids[j], &set);
+			}
+		}
+		if (CPU_COUNT(&set) > 0) cpus_.push_back(set); // no cpu: skip node
+	}
+	if (cpus_.empty()) cpus_.push_back(allowed);
+}
+
+// -----------------------------------------------------------------------------
+NumaTopo::~NumaTopo()				// destructor
+{
+	cpus_.clear();
+}
+
+// -----------------------------------------------------------------------------
+bool NumaTopo::read_list(			// parse a list like "0-3,8-11"
+	const char *fname,					// file of the list
+	std::vector<int> &ids)				// ids in the list (return)
+{
+	FILE *fp = fopen(fname, "r");
+	if (!fp) return false;
+
+	char line[4096];
+	bool ok = fgets(line, sizeof(line), fp) != NULL;
+	fclose(fp);
+	if (!ok) return false;
+
+	for (char *p = line; *p >= '0' && *p <= '9'; ) {
+		int lo = (int) strtol(p, &p, 10);
+		int hi = lo;
+		if (*p == '-') hi = (int) strtol(p + 1, &p, 10);
+		for (int i = lo; i <= hi; ++i) ids.push_back(i);
+		if (*p == ',') ++p;
+	}
+	return !ids.empty();
+}
+
+// -----------------------------------------------------------------------------
+bool NumaTopo::pin_thread(			// run the calling thread on its node
+	int tid,							// thread id
+	int num_threads)					// num of threads
+{
+	cpu_set_t &set = cpus_[node_of_thread(tid, num_threads)];
+	return sched_setaffinity(0, sizeof(cpu_set_t), &set) == 0;
+}
+
+// -----------------------------------------------------------------------------
+struct TouchArg {					// slice of a buffer of first_touch()
+	NumaTopo *topo_;					// topology
+	int    tid_;						// thread id
+	int    num_threads_;				// num of threads
+	char   *from_;						// first byte of slice
+	size_t len_;						// length of slice
+};
+
+// -----------------------------------------------------------------------------
+static void* touch_thread(			// write the pages of a slice
+	void *arg)							// the slice (TouchArg)
+{
+	TouchArg *ta = (TouchArg *) arg;
+	ta->topo_->pin_thread(ta->tid_, ta->num_threads_);
+
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	for (size_t i = 0; i < ta->len_; i += page) ta->from_[i] = 0;
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  slice j of <num_threads> equal slices (rounded to pages) is touched by a
+//  thread pinned to the node of thread j, so it is the memory of that node
+//  if the buffer is new (e.g., a large new[] which is mapped on demand).
+// -----------------------------------------------------------------------------
+void NumaTopo::first_touch(			// place slices of a buffer on nodes
+	char  *buf,							// buffer (not touched yet)
+	size_t len,							// length of buffer
+	int   num_threads)					// num of slices (threads)
+{
+	int    t    = MAX(num_threads, 1);
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+
+	pthread_t *threads = new pthread_t[t];
+	TouchArg  *args    = new TouchArg[t];
+	for (int j = 0; j < t; ++j) {
+		size_t from = len / t * j / page * page;
+		size_t to   = (j == t - 1) ? len : len / t * (j + 1) / page * page;
+		args[j].topo_        = this;
+		args[j].tid_         = j;
+		args[j].num_threads_ = t;
+		args[j].from_        = buf + from;
+		args[j].len_         = to - from;
+		pthread_create(&threads[j], NULL, touch_thread, &args[j]);
+	}
+	for (int j = 0; j < t; ++j) pthread_join(threads[j], NULL);
+
+	delete[] threads; threads = NULL;
+	delete[] args;    args    = NULL;
+}
@@ -0,0 +1,59 @@
+#ifndef __NUMA_TOPO_H
+#define __NUMA_TOPO_H
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  NumaTopo: the cpus of each numa node, read from /sys/devices/system/node
+//  (no libnuma needed), restricted to the cpus this process may run on. a
+//  machine without the directory is one node of all allowed cpus.
+//
+//  thread <tid> of <num_threads> belongs to node tid * nodes / num_threads,
+//  so consecutive threads (and the consecutive slices of data they start
+//  with) share a node. memory is placed by the first-touch policy of linux:
+//  a page is taken from the node of the thread which writes it first.
+// -----------------------------------------------------------------------------
+class NumaTopo {
+public:
+	NumaTopo();						// constructor (reads the topology)
+	~NumaTopo();					// destructor
+
+	// -------------------------------------------------------------------------
+	inline int get_num_nodes() { return (int) cpus_.size(); }
+
+	// -------------------------------------------------------------------------
+	inline int node_of_thread(		// numa node of a thread
+		int tid,						// thread id
+		int num_threads)				// num of threads
+	{ return (int) ((int64_t) tid * get_num_nodes() / MAX(num_threads, 1)); }
+
+	// -------------------------------------------------------------------------
+	bool pin_thread(				// run the calling thread on its node
+		int tid,						// thread id
+		int num_threads);				// num of threads
+
+	// -------------------------------------------------------------------------
+	void first_touch(				// place slices of a buffer on nodes
+		char  *buf,						// buffer (not touched yet)
+		size_t len,						// length of buffer
+		int   num_threads);				// num of slices (threads)
+
+protected:
+	std::vector<cpu_set_t> cpus_;	// allowed cpus of each node
+
+	// -------------------------------------------------------------------------
+	static bool read_list(			// parse a list like "0-3,8-11"
+		const char *fname,				// file of the list
+		std::vector<int> &ids);			// ids in the list (return)
+};
+
+#endif // __NUMA_TOPO_H
@@ -0,0 +1,198 @@
+#include "perf_counter.h"
+
+#include <atomic>
+#include <ctime>
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+bool g_perf_enabled = false;
+static bool g_perf_counters = false;// read hardware counters?
+
+static std::atomic<uint64_t> g_calls[NUM_PHASES];
+static std::atomic<uint64_t> g_time_ns[NUM_PHASES];
+static std::atomic<uint64_t> g_events[NUM_PHASES][NUM_EVENTS];
+static std::atomic<int>      g_event_ok[NUM_EVENTS];
+
+static const char *PHASE_NAME[NUM_PHASES] = {
+	"leaf_build", "index_build", "node_search", "file_read",
+	"file_write", "file_append", "flush_wait"
+};
+static const char *EVENT_NAME[NUM_EVENTS] = {
+	"cycles", "instructions", "llc_misses", "branch_misses"
+};
+static const uint64_t EVENT_CONFIG[NUM_EVENTS] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// -----------------------------------------------------------------------------
+static inline uint64_t now_ns()		// monotonic wall time (ns)
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+// -----------------------------------------------------------------------------
+//  PerfThread: group of hardware counters of the calling thread. counters are
+//  opened on the first use in each thread and are never disabled, so a scope
+//  only reads the group twice and takes the difference.
+// -----------------------------------------------------------------------------
+struct PerfThread {
+	bool opened_;					// whether open() has been called
+	int  leader_;					// fd of group leader (-1 if none)
+	int  fd_[NUM_EVENTS];			// fd of each event (-1 if not permitted)
+	int  slot_[NUM_EVENTS];			// pos of each event in a group read
+
+	// -------------------------------------------------------------------------
+	PerfThread() {
+		opened_ = false;
+		leader_ = -1;
+		for (int i = 0; i < NUM_EVENTS; ++i) { fd_[i] = -1; slot_[i] = -1; }
+	}
+
+	// -------------------------------------------------------------------------
+	~PerfThread() {
+		for (int i = 0; i < NUM_EVENTS; ++i) {
+			if (fd_[i] >= 0) close(fd_[i]);
+		}
+	}
+
+	// -------------------------------------------------------------------------
+	void open() {
+		opened_ = true;
+		int num = 0;
+		for (int i = 0; i < NUM_EVENTS; ++i) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size           = sizeof(attr);
+			attr.type           = PERF_TYPE_HARDWARE;
+			attr.config         = EVENT_CONFIG[i];
+			attr.exclude_kernel = 1;
+			attr.exclude_hv     = 1;
+			attr.read_format    = PERF_FORMAT_GROUP;
+
+			// -----------------------------------------------------------------
+			//  pid = 0 and cpu = -1: count the calling thread on any cpu.
+			//  it fails if not permitted (perf_event_paranoid or seccomp).
+			// -----------------------------------------------------------------
+			fd_[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1,
+				leader_, 0);
+			if (fd_[i] < 0) continue;
+
+			if (leader_ < 0) leader_ = fd_[i];
+			slot_[i] = num++;
+			g_event_ok[i] = 1;
+		}
+	}
+
+	// -------------------------------------------------------------------------
+	void read_all(uint64_t *cnt) {
+		uint64_t buf[NUM_EVENTS + 1];
+		memset(cnt, 0, NUM_EVENTS * sizeof(uint64_t));
+
+		if (!opened_) open();
+		if (leader_ < 0) return;
+		if (read(leader_, buf, sizeof(buf)) < (ssize_t) sizeof(uint64_t)) return;
+
+		for (int i = 0; i < NUM_EVENTS; ++i) {
+			if (slot_[i] >= 0 && slot_[i] < (int) buf[0]) {
+				cnt[i] = buf[slot_[i] + 1];
+			}
+		}
+	}
+};
+
+static thread_local PerfThread t_perf;
+
+// -----------------------------------------------------------------------------
+void perf_enable(					// enable the instrumentation layer
+	bool counters)						// also read hardware counters?
+{
+	perf_reset();
+	g_perf_counters = counters;
+	g_perf_enabled  = true;
+}
+
+// -----------------------------------------------------------------------------
+void perf_reset()					// clear all per-phase statistics
+{
+	for (int i = 0; i < NUM_PHASES; ++i) {
+		g_calls[i]   = 0;
+		g_time_ns[i] = 0;
+		for (int j = 0; j < NUM_EVENTS; ++j) g_events[i][j] = 0;
+	}
+}
+
+// -----------------------------------------------------------------------------
+//  print one line per phase that has been entered. wall time is summed over
+//  all threads, so it may be larger than the elapsed time of bulkload.
+// -----------------------------------------------------------------------------
+void perf_report(					// print per-phase report
+	FILE *fp)							// output file
+{
+	fprintf(fp, "%-12s %10s %10s", "phase", "calls", "time(s)");
+	if (g_perf_counters) {
+		for (int j = 0; j < NUM_EVENTS; ++j) {
+			fprintf(fp, " %14s", EVENT_NAME[j]);
+		}
+		fprintf(fp, " %6s", "ipc");
+	}
+	fprintf(fp, "\n");
+
+	for (int i = 0; i < NUM_PHASES; ++i) {
+		uint64_t calls = g_calls[i];
+		if (calls == 0) continue;
+
+		fprintf(fp, "%-12s %10llu %10.6f", PHASE_NAME[i],
+			(unsigned long long) calls, g_time_ns[i] / 1000000000.0);
+		if (g_perf_counters) {
+			for (int j = 0; j < NUM_EVENTS; ++j) {
+				if (g_event_ok[j]) {
+					fprintf(fp, " %14llu",
+						(unsigned long long) g_events[i][j].load());
+				}
+				else {
+					fprintf(fp, " %14s", "n/a");
+				}
+			}
+			uint64_t cycles = g_events[i][EVENT_CYCLES];
+			uint64_t instrs = g_events[i][EVENT_INSTRUCTIONS];
+			if (cycles > 0) fprintf(fp, " %6.2f", (double) instrs / cycles);
+			else fprintf(fp, " %6s", "n/a");
+		}
+		fprintf(fp, "\n");
+	}
+}
+
+// -----------------------------------------------------------------------------
+PerfScope::PerfScope(				// constructor (start of the phase)
+	PerfPhase phase)					// phase to be measured
+{
+	phase_  = phase;
+	active_ = g_perf_enabled;
+	if (!active_) return;
+
+	if (g_perf_counters) t_perf.read_all(start_cnt_);
+	start_ns_ = now_ns();
+}
+
+// -----------------------------------------------------------------------------
+PerfScope::~PerfScope()				// destructor (end of the phase)
+{
+	if (!active_) return;
+
+	uint64_t end_ns = now_ns();
+	g_calls[phase_]   += 1;
+	g_time_ns[phase_] += end_ns - start_ns_;
+
+	if (g_perf_counters) {
+		uint64_t end_cnt[NUM_EVENTS];
+		t_perf.read_all(end_cnt);
+		for (int j = 0; j < NUM_EVENTS; ++j) {
+			g_events[phase_][j] += end_cnt[j] - start_cnt_[j];
+		}
+	}
+}
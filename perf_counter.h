@@ -0,0 +1,68 @@
+#ifndef __PERF_COUNTER_H
+#define __PERF_COUNTER_H
+
+#include <iostream>
+#include <cstdio>
+#include <stdint.h>
+
+#include "def.h"
+
+// -----------------------------------------------------------------------------
+//  hot phases of building and searching a b-tree. nested phases are counted
+//  inclusively, e.g., PHASE_FILE_WRITE is also part of PHASE_LEAF_BUILD.
+// -----------------------------------------------------------------------------
+enum PerfPhase {
+	PHASE_LEAF_BUILD = 0,			// leaf-build loop of bulkload
+	PHASE_INDEX_BUILD,				// index-build loop of bulkload
+	PHASE_NODE_SEARCH,				// find_position_by_key of b-nodes
+	PHASE_FILE_READ,				// BlockFile::read_block
+	PHASE_FILE_WRITE,				// BlockFile::write_block
+	PHASE_FILE_APPEND,				// BlockFile::append_block
+	PHASE_FLUSH_WAIT,				// wait for a free staging buffer
+	NUM_PHASES
+};
+
+// -----------------------------------------------------------------------------
+//  hardware events read by perf_event_open (if permitted)
+// -----------------------------------------------------------------------------
+enum PerfEvent {
+	EVENT_CYCLES = 0,				// cpu cycles
+	EVENT_INSTRUCTIONS,				// retired instructions
+	EVENT_LLC_MISSES,				// last level cache misses
+	EVENT_BRANCH_MISSES,			// mispredicted branches
+	NUM_EVENTS
+};
+
+extern bool g_perf_enabled;			// global parameter: instrumentation on
+
+// -----------------------------------------------------------------------------
+void perf_enable(					// enable the instrumentation layer
+	bool counters);						// also read hardware counters?
+
+// -----------------------------------------------------------------------------
+void perf_reset();					// clear all per-phase statistics
+
+// -----------------------------------------------------------------------------
+void perf_report(					// print per-phase report
+	FILE *fp);							// output file
+
+// -----------------------------------------------------------------------------
+//  PerfScope: scoped timer (and counter reader) of a phase. it does nothing
+//  if the instrumentation layer is not enabled.
+// -----------------------------------------------------------------------------
+class PerfScope {
+public:
+	PerfScope(						// constructor (start of the phase)
+		PerfPhase phase);				// phase to be measured
+
+	// -------------------------------------------------------------------------
+	~PerfScope();					// destructor (end of the phase)
+
+protected:
+	PerfPhase phase_;				// phase measured by this scope
+	bool     active_;				// whether this scope is measuring
+	uint64_t start_ns_;				// wall time at the start (ns)
+	uint64_t start_cnt_[NUM_EVENTS];// counter values at the start
+};
+
+#endif // __PERF_COUNTER_H
@@ -0,0 +1,138 @@
+#include "radix_sort.h"
+#include "bit_pack.h"
+
+// -----------------------------------------------------------------------------
+const int RADIX_BITS    = 8;		// bits of a digit
+const int RADIX_BUCKETS = 1 << RADIX_BITS; // num of buckets of a pass
+const int RADIX_PASSES  = 64 / RADIX_BITS; // num of digits of a sort key
+const int RADIX_SLICE   = 65536;	// min entries of a thread
+
+// -----------------------------------------------------------------------------
+static inline uint64_t sort_key(	// 64-bit sort key of an entry
+	const Result &r)					// entry
+{
+	float key = r.key_;
+	if (key == 0.0f) key = 0.0f;	// -0 and +0 are equal by ResultComp
+	return ((uint64_t) float_to_ordered(key) << 32) |
+		((uint32_t) r.id_ ^ 0x80000000u);
+}
+
+// -----------------------------------------------------------------------------
+//  every thread owns a slice of the array. in a pass, it counts the digits
+//  of its slice, and after all threads have counted, it computes where its
+//  entries of each digit go (after all smaller digits, and after the same
+//  digit of the slices before it), so the scatter is stable.
+// -----------------------------------------------------------------------------
+struct RadixArg {					// state of a thread of radix_sort()
+	int    tid_;						// thread id
+	int    num_threads_;				// number of threads
+	int    n_;							// number of entries
+	Result *src_;						// entries
+	Result *tmp_;						// second array of entries
+	int    *count_;						// digit counts of all threads
+	uint64_t *and_;						// and of sort keys of each slice
+	uint64_t *or_;						// or of sort keys of each slice
+	pthread_barrier_t *barrier_;		// end of each step
+};
+
+// -----------------------------------------------------------------------------
+static void* radix_thread(			// a thread of radix_sort()
+	void *arg)							// state (RadixArg)
+{
+	RadixArg *ra = (RadixArg *) arg;
+	int t    = ra->tid_;
+	int from = (int) ((int64_t) ra->n_ * t / ra->num_threads_);
+	int to   = (int) ((int64_t) ra->n_ * (t + 1) / ra->num_threads_);
+
+	uint64_t all_and = ~0ull, all_or = 0ull; // constant bits of sort keys
+	for (int i = from; i < to; ++i) {
+		uint64_t k = sort_key(ra->src_[i]);
+		all_and &= k; all_or |= k;
+	}
+	ra->and_[t] = all_and; ra->or_[t] = all_or;
+	pthread_barrier_wait(ra->barrier_);
+
+	all_and = ~0ull; all_or = 0ull;
+	for (int j = 0; j < ra->num_threads_; ++j) {
+		all_and &= ra->and_[j]; all_or |= ra->or_[j];
+	}
+	uint64_t varies = all_and ^ all_or;
+
+	Result *src = ra->src_;
+	Result *dst = ra->tmp_;
+	int *count  = &ra->count_[t * RADIX_BUCKETS];
+	int pos[RADIX_BUCKETS];
+	for (int p = 0; p < RADIX_PASSES; ++p) {
+		int shift = p * RADIX_BITS;
+		if (((varies >> shift) & (RADIX_BUCKETS - 1)) == 0) continue;
+
+		memset(count, 0, RADIX_BUCKETS * SIZEINT);
+		for (int i = from; i < to; ++i) {
+			++count[(sort_key(src[i]) >> shift) & (RADIX_BUCKETS - 1)];
+		}
+		pthread_barrier_wait(ra->barrier_);
+
+		int sum = 0;
+		for (int d = 0; d < RADIX_BUCKETS; ++d) {
+			for (int j = 0; j < ra->num_threads_; ++j) {
+				int c = ra->count_[j * RADIX_BUCKETS + d];
+				if (j == t) pos[d] = sum;
+				sum += c;
+			}
+		}
+		for (int i = from; i < to; ++i) {
+			int d = (int) ((sort_key(src[i]) >> shift) & (RADIX_BUCKETS - 1));
+			dst[pos[d]++] = src[i];
+		}
+		pthread_barrier_wait(ra->barrier_); // counts and <src> are reused
+
+		Result *swap = src; src = dst; dst = swap;
+	}
+	if (src != ra->src_) {			// odd num of passes: copy back
+		memcpy(&ra->src_[from], &src[from], (size_t) (to - from) *
+			sizeof(Result));
+	}
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+void radix_sort(					// sort entries in ResultComp order
+	int   n,							// number of entries
+	Result *table,						// entries (sorted on return)
+	int   num_threads)					// number of threads
+{
+	if (n <= 1) return;
+	int t = MAX(MIN(num_threads, n / RADIX_SLICE), 1);
+
+	Result    *tmp     = new Result[n];
+	int       *count   = new int[t * RADIX_BUCKETS];
+	uint64_t  *ands    = new uint64_t[t];
+	uint64_t  *ors     = new uint64_t[t];
+	pthread_t *threads = new pthread_t[t];
+	RadixArg  *args    = new RadixArg[t];
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, t);
+	for (int j = 0; j < t; ++j) {
+		args[j].tid_         = j;
+		args[j].num_threads_ = t;
+		args[j].n_           = n;
+		args[j].src_         = table;
+		args[j].tmp_         = tmp;
+		args[j].count_       = count;
+		args[j].and_         = ands;
+		args[j].or_          = ors;
+		args[j].barrier_     = &barrier;
+		if (j > 0) pthread_create(&threads[j], NULL, radix_thread, &args[j]);
+	}
+	radix_thread(&args[0]);			// the caller is thread 0
+	for (int j = 1; j < t; ++j) pthread_join(threads[j], NULL);
+	pthread_barrier_destroy(&barrier);
+
+	delete[] tmp;     tmp     = NULL;
+	delete[] count;   count   = NULL;
+	delete[] ands;    ands    = NULL;
+	delete[] ors;     ors     = NULL;
+	delete[] threads; threads = NULL;
+	delete[] args;    args    = NULL;
+}
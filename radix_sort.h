@@ -0,0 +1,24 @@
+#ifndef __RADIX_SORT_H
+#define __RADIX_SORT_H
+
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "def.h"
+#include "pri_queue.h"
+
+// -----------------------------------------------------------------------------
+//  parallel lsd radix sort of Result in ResultComp order. the sort key of an
+//  entry is 64 bits: the order-preserving form of <key_> (high half) and
+//  <id_> with its sign bit flipped (low half), sorted by 8 bits per pass.
+//  a pass is skipped if all entries have the same digit in it. it needs a
+//  second array of <n> entries.
+// -----------------------------------------------------------------------------
+void radix_sort(					// sort entries in ResultComp order
+	int   n,							// number of entries
+	Result *table,						// entries (sorted on return)
+	int   num_threads = 1);				// number of threads
+
+#endif // __RADIX_SORT_H
@@ -0,0 +1,162 @@
+#include "task_pool.h"
+
+// -----------------------------------------------------------------------------
+TaskDeque::TaskDeque(				// constructor
+	int capacity)						// max num of tasks
+{
+	int cap = 1;
+	while (cap < capacity) cap <<= 1;
+	mask_ = cap - 1;
+	buf_  = new std::atomic<int>[cap];
+	for (int i = 0; i < cap; ++i) buf_[i].store(-1, std::memory_order_relaxed);
+	top_.store(0);
+	bottom_.store(0);
+}
+
+// -----------------------------------------------------------------------------
+TaskDeque::~TaskDeque()				// destructor
+{
+	delete[] buf_; buf_ = NULL;
+}
+
+// -----------------------------------------------------------------------------
+void TaskDeque::push(				// add a task at the bottom (owner)
+	int task)							// task id
+{
+	int64_t b = bottom_.load(std::memory_order_relaxed);
+	buf_[b & mask_].store(task, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom_.store(b + 1, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+//  the owner takes the slot first (by decreasing <bottom_>), then looks at
+//  <top_>: only the last task can be raced for, and a cas on <top_>
+//  decides it, the same as for a thief.
+// -----------------------------------------------------------------------------
+bool TaskDeque::pop(				// take the bottom task (owner)
+	int &task)							// task id (return)
+{
+	int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+	bottom_.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top_.load(std::memory_order_relaxed);
+
+	if (t > b) {					// empty
+		bottom_.store(b + 1, std::memory_order_relaxed);
+		return false;
+	}
+	task = buf_[b & mask_].load(std::memory_order_relaxed);
+	if (t == b) {					// the last task: race with thieves
+		bool won = top_.compare_exchange_strong(t, t + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed);
+		bottom_.store(b + 1, std::memory_order_relaxed);
+		return won;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool TaskDeque::steal(				// take the top task (other threads)
+	int &task)							// task id (return)
+{
+	int64_t t = top_.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom_.load(std::memory_order_acquire);
+	if (t >= b) return false;		// empty
+
+	task = buf_[t & mask_].load(std::memory_order_relaxed);
+	return top_.compare_exchange_strong(t, t + 1,
+		std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+struct PoolArg {					// state of a thread of run_tasks()
+	int    tid_;						// thread id
+	int    num_threads_;				// num of threads
+	TaskDeque **deques_;				// deque of each thread
+	std::atomic<int> *unclaimed_;		// num of tasks not taken yet
+	std::atomic<bool> *ok_;				// no task failed
+	TaskFunc func_;						// task function
+	void   *ctx_;						// context of <func_>
+	NumaTopo *numa_;					// pin threads to nodes (NULL: no)
+};
+
+// -----------------------------------------------------------------------------
+//  a failed steal (empty deque or a lost race) moves on to the next victim.
+//  a thread stops once every task is taken, so it does not spin while the
+//  last tasks run; run_tasks() joins the threads.
+// -----------------------------------------------------------------------------
+static void* pool_thread(			// a thread of run_tasks()
+	void *arg)							// state (PoolArg)
+{
+	PoolArg *pa = (PoolArg *) arg;
+	TaskDeque *own = pa->deques_[pa->tid_];
+	int victim = pa->tid_;
+	int task   = -1;
+	if (pa->numa_ != NULL) pa->numa_->pin_thread(pa->tid_, pa->num_threads_);
+
+	while (pa->unclaimed_->load(std::memory_order_acquire) > 0) {
+		bool found = own->pop(task);
+		for (int k = 1; !found && k < pa->num_threads_; ++k) {
+			victim = (victim + 1) % pa->num_threads_;
+			if (victim == pa->tid_) victim = (victim + 1) % pa->num_threads_;
+			found = pa->deques_[victim]->steal(task);
+		}
+		if (!found) { sched_yield(); continue; }
+		pa->unclaimed_->fetch_sub(1, std::memory_order_release);
+
+		if (!pa->func_(pa->ctx_, task, pa->tid_)) {
+			pa->ok_->store(false, std::memory_order_relaxed);
+		}
+	}
+	return NULL;
+}
+
+// -----------------------------------------------------------------------------
+bool run_tasks(						// run tasks by work stealing
+	int   num_tasks,					// num of tasks
+	int   num_threads,					// num of threads
+	TaskFunc func,						// task function
+	void  *ctx,							// context of <func>
+	NumaTopo *numa)						// pin threads to nodes (NULL: no)
+{
+	if (num_tasks <= 0) return true;
+	int t = MAX(MIN(num_threads, num_tasks), 1);
+
+	std::atomic<int>  unclaimed(num_tasks);
+	std::atomic<bool> ok(true);
+	TaskDeque **deques = new TaskDeque*[t];
+	pthread_t *threads = new pthread_t[t];
+	PoolArg   *args    = new PoolArg[t];
+	for (int j = 0; j < t; ++j) {
+		int from = (int) ((int64_t) num_tasks * j / t);
+		int to   = (int) ((int64_t) num_tasks * (j + 1) / t);
+		deques[j] = new TaskDeque(to - from);
+		for (int i = to - 1; i >= from; --i) deques[j]->push(i); // pop: from
+	}
+	for (int j = 0; j < t; ++j) {
+		args[j].tid_         = j;
+		args[j].num_threads_ = t;
+		args[j].deques_      = deques;
+		args[j].unclaimed_   = &unclaimed;
+		args[j].ok_          = &ok;
+		args[j].func_        = func;
+		args[j].ctx_         = ctx;
+		args[j].numa_        = numa;
+		if (j > 0) pthread_create(&threads[j], NULL, pool_thread, &args[j]);
+	}
+	cpu_set_t caller;				// thread 0 is pinned for the run only
+	bool pinned = numa != NULL &&
+		sched_getaffinity(0, sizeof(cpu_set_t), &caller) == 0;
+	pool_thread(&args[0]);			// the caller is thread 0
+	for (int j = 1; j < t; ++j) pthread_join(threads[j], NULL);
+	if (pinned) sched_setaffinity(0, sizeof(cpu_set_t), &caller);
+
+	for (int j = 0; j < t; ++j) { delete deques[j]; deques[j] = NULL; }
+	delete[] deques;  deques  = NULL;
+	delete[] threads; threads = NULL;
+	delete[] args;    args    = NULL;
+
+	return ok.load();
+}
@@ -0,0 +1,68 @@
+#ifndef __TASK_POOL_H
+#define __TASK_POOL_H
+
+#include <iostream>
+#include <cstring>
+#include <atomic>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "def.h"
+#include "numa_topo.h"
+
+// -----------------------------------------------------------------------------
+//  TaskDeque: chase-lev deque of task ids. its owner pushes and pops at the
+//  bottom, and the other threads steal at the top. the capacity is fixed,
+//  since all tasks of a run are pushed before the threads start.
+// -----------------------------------------------------------------------------
+class TaskDeque {
+public:
+	TaskDeque(						// constructor
+		int capacity);					// max num of tasks
+	~TaskDeque();					// destructor
+
+	// -------------------------------------------------------------------------
+	void push(						// add a task at the bottom (owner)
+		int task);						// task id
+
+	// -------------------------------------------------------------------------
+	bool pop(						// take the bottom task (owner)
+		int &task);						// task id (return)
+
+	// -------------------------------------------------------------------------
+	bool steal(						// take the top task (other threads)
+		int &task);						// task id (return)
+
+protected:
+	int  mask_;						// capacity - 1 (a power of 2)
+	std::atomic<int> *buf_;			// ring of task ids
+	std::atomic<int64_t> top_;		// next task to steal
+	std::atomic<int64_t> bottom_;	// next free slot of the owner
+};
+
+// -----------------------------------------------------------------------------
+//  a task of run_tasks(): returns false if it failed
+// -----------------------------------------------------------------------------
+typedef bool (*TaskFunc)(			// run a task
+	void *ctx,							// context of run_tasks()
+	int   task,							// task id
+	int   tid);							// thread id
+
+// -----------------------------------------------------------------------------
+//  run tasks [0, num_tasks) by a pool of threads. every thread starts with
+//  a consecutive range of tasks in its own deque and runs them in order;
+//  when its deque is empty, it steals from the others, so a slow thread
+//  delays the end by about one task, not by its whole range. the caller
+//  is thread 0. with <numa>, thread j is pinned to its node (see NumaTopo),
+//  so it starts with the tasks of the j-th slice of the data. returns false
+//  if a task failed.
+// -----------------------------------------------------------------------------
+bool run_tasks(						// run tasks by work stealing
+	int   num_tasks,					// num of tasks
+	int   num_threads,					// num of threads
+	TaskFunc func,						// task function
+	void  *ctx,							// context of <func>
+	NumaTopo *numa = NULL);				// pin threads to nodes (NULL: no)
+
+#endif // __TASK_POOL_H
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "def.h"
+#include "block_file.h"
+
+using namespace std;
+
+// -----------------------------------------------------------------------------
+//  verify the crc32c trailers of all blocks of a tree file (built with -crc)
+//
+//  usage: ./verify [tree_file] [threads]
+//  by default, ./result/B_tree with one thread per core. exit code 1 if
+//  any block is bad.
+// -----------------------------------------------------------------------------
+int main(int argc, char **args)
+{
+	char tree_file[200];
+	strncpy(tree_file, "./result/B_tree", sizeof(tree_file));
+	if (argc > 1) strncpy(tree_file, args[1], sizeof(tree_file) - 1);
+	int num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (argc > 2) num_threads = atoi(args[2]);
+
+	FILE *fp = fopen(tree_file, "r");
+	if (!fp) {
+		printf("tree file %s does not exist\n", tree_file);
+		return 1;
+	}
+	fclose(fp);
+
+	timeval start_t;
+	timeval end_t;
+
+	gettimeofday(&start_t, NULL);
+	BlockFile *file = new BlockFile(0, tree_file);
+	int bad = file->verify(num_threads);
+	gettimeofday(&end_t, NULL);
+
+	float run_t = end_t.tv_sec - start_t.tv_sec +
+		(end_t.tv_usec - start_t.tv_usec) / 1000000.0f;
+	printf("%d blocks, %d bad, %d threads: %f s\n", file->get_num_of_blocks(),
+		bad, num_threads, run_t);
+	delete file; file = NULL;
+
+	return bad > 0 ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+#include "wal.h"
+
+// -----------------------------------------------------------------------------
+Wal::Wal()							// constructor
+{
+	fd_          = -1;
+	base_        = 0;
+	end_         = WAL_HEAD_LENGTH;
+	len_         = 0;
+	cap_         = WAL_BUFFER;
+	spare_cap_   = WAL_BUFFER;
+	buf_         = new char[cap_];
+	spare_       = new char[spare_cap_];
+	next_lsn_    = 1;
+	durable_lsn_ = 0;
+	buf_lsn_     = 1;
+	syncing_     = false;
+	num_syncs_   = 0;
+	load_        = NULL;
+
+	pthread_mutex_init(&lock_, NULL);
+	pthread_cond_init(&synced_, NULL);
+}
+
+// -----------------------------------------------------------------------------
+Wal::~Wal()							// destructor
+{
+	if (fd_ >= 0) { flush(); close(fd_); fd_ = -1; }
+
+	delete[] buf_;   buf_   = NULL;
+	delete[] spare_; spare_ = NULL;
+	delete[] load_;  load_  = NULL;
+	pthread_cond_destroy(&synced_);
+	pthread_mutex_destroy(&lock_);
+}
+
+// -----------------------------------------------------------------------------
+bool Wal::open(						// open (or create) a log file
+	const char *fname,					// file name
+	int   base)							// seq of tree (for a new log)
+{
+	fd_ = ::open(fname, O_RDWR | O_CREAT, 0644);
+	if (fd_ < 0) {
+		printf("could not open log file %s\n", fname);
+		return false;
+	}
+	char head[WAL_HEAD_LENGTH];
+	int  magic = 0;
+	off_t size = lseek(fd_, 0, SEEK_END);
+	if (size >= WAL_HEAD_LENGTH &&
+			pread(fd_, head, WAL_HEAD_LENGTH, 0) == WAL_HEAD_LENGTH) {
+		memcpy(&magic, head, SIZEINT);
+	}
+	if (magic != WAL_MAGIC) return reset(base); // new (or broken) log
+
+	memcpy(&base_, &head[SIZEINT], SIZEINT);
+	end_ = WAL_HEAD_LENGTH;			// extended by recover()
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool Wal::write_head()				// write <magic> and <base_>
+{
+	char head[WAL_HEAD_LENGTH];
+	int  magic = WAL_MAGIC;
+	memset(head, 0, WAL_HEAD_LENGTH);
+	memcpy(head, &magic, SIZEINT);
+	memcpy(&head[SIZEINT], &base_, SIZEINT);
+
+	return pwrite(fd_, head, WAL_HEAD_LENGTH, 0) == WAL_HEAD_LENGTH;
+}
+
+// -----------------------------------------------------------------------------
+//  scan the records after the head until the end of file, or the first
+//  record which is incomplete or has a wrong crc (a torn write of the last
+//  group). the log is cut there, so that new records follow the valid ones.
+// -----------------------------------------------------------------------------
+bool Wal::recover(					// read the valid records of the log
+	std::vector<WalRecord> &recs)		// records (return)
+{
+	off_t size = lseek(fd_, 0, SEEK_END) - WAL_HEAD_LENGTH;
+	delete[] load_;
+	load_ = new char[size + 1];
+	if (size > 0 && pread(fd_, load_, size, WAL_HEAD_LENGTH) != size) {
+		printf("could not read log file\n");
+		return false;
+	}
+	recs.clear();
+	off_t pos = 0;
+	while (pos + WAL_RECORD_HEAD + SIZEINT <= size) {
+		WalRecord rec;
+		memcpy(&rec.len_,  &load_[pos], SIZEINT);
+		memcpy(&rec.type_, &load_[pos + SIZEINT], SIZEINT);
+		memcpy(&rec.lsn_,  &load_[pos + SIZEINT * 2], sizeof(int64_t));
+		if (rec.len_ < 0 || pos + WAL_RECORD_HEAD + rec.len_ + SIZEINT > size) {
+			break;
+		}
+		int total = WAL_RECORD_HEAD + rec.len_;
+		uint32_t crc = 0;
+		memcpy(&crc, &load_[pos + total], SIZEINT);
+		if (crc != crc32c(&load_[pos], total)) break;
+
+		rec.data_ = &load_[pos + WAL_RECORD_HEAD];
+		recs.push_back(rec);
+		pos += total + SIZEINT;
+	}
+	end_ = WAL_HEAD_LENGTH + pos;
+	if (!recs.empty()) {
+		next_lsn_ = durable_lsn_ = recs.back().lsn_;
+		++next_lsn_;
+	}
+	buf_lsn_ = next_lsn_;
+	return ftruncate(fd_, end_) == 0;
+}
+
+// -----------------------------------------------------------------------------
+bool Wal::reset(					// drop all records (after a checkpoint)
+	int base)							// seq of tree of the new records
+{
+	pthread_mutex_lock(&lock_);
+	while (syncing_) pthread_cond_wait(&synced_, &lock_);
+
+	base_ = base;
+	end_  = WAL_HEAD_LENGTH;
+	len_  = 0;
+	durable_lsn_ = next_lsn_ - 1;	// lsn keeps increasing
+	buf_lsn_     = next_lsn_;
+	bool ok = ftruncate(fd_, 0) == 0 && write_head() && fdatasync(fd_) == 0;
+	pthread_mutex_unlock(&lock_);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+int64_t Wal::append(				// add a record, return its lsn
+	int   type,							// type of record
+	const char *data,					// payload
+	int   len)							// length of payload
+{
+	int total = WAL_RECORD_HEAD + len + SIZEINT;
+
+	pthread_mutex_lock(&lock_);
+	if (len_ + total > cap_) {		// grow the log buffer
+		int  cap = MAX(cap_ * 2, len_ + total);
+		char *buf = new char[cap];
+		memcpy(buf, buf_, len_);
+		delete[] buf_; buf_ = buf; cap_ = cap;
+	}
+	int64_t lsn = next_lsn_++;
+	char *rec = &buf_[len_];
+	memcpy(rec, &len, SIZEINT);
+	memcpy(&rec[SIZEINT], &type, SIZEINT);
+	memcpy(&rec[SIZEINT * 2], &lsn, sizeof(int64_t));
+	memcpy(&rec[WAL_RECORD_HEAD], data, len);
+	uint32_t crc = crc32c(rec, WAL_RECORD_HEAD + len);
+	memcpy(&rec[WAL_RECORD_HEAD + len], &crc, SIZEINT);
+	len_ += total;
+	pthread_mutex_unlock(&lock_);
+
+	return lsn;
+}
+
+// -----------------------------------------------------------------------------
+bool Wal::commit(					// wait until the record <lsn> is durable
+	int64_t lsn)						// lsn of record
+{
+	pthread_mutex_lock(&lock_);
+	while (durable_lsn_ < lsn && !is_lost(lsn)) {
+		if (syncing_) {				// follower: wait for the leader
+			pthread_cond_wait(&synced_, &lock_);
+			continue;
+		}
+		syncing_ = true;			// leader: sync all appended records
+		char    *buf  = buf_;
+		int     len   = len_;
+		int     cap   = cap_;
+		int64_t first = buf_lsn_;
+		int64_t last  = next_lsn_ - 1;
+		off_t   pos   = end_;
+		buf_ = spare_; cap_ = spare_cap_; len_ = 0;
+		spare_ = NULL; buf_lsn_ = last + 1;
+		pthread_mutex_unlock(&lock_);
+
+		bool ok = pwrite(fd_, buf, len, pos) == len && fdatasync(fd_) == 0;
+
+		pthread_mutex_lock(&lock_);
+		spare_ = buf; spare_cap_ = cap;
+		if (!ok) {
+			printf("could not sync log file\n");
+			lost_.push_back(std::make_pair(first, last));
+			syncing_ = false;
+			pthread_cond_broadcast(&synced_);
+			break;
+		}
+		end_ += len;
+		durable_lsn_ = last;
+		++num_syncs_;
+		syncing_ = false;
+		pthread_cond_broadcast(&synced_);
+	}
+	bool ok = !is_lost(lsn);
+	pthread_mutex_unlock(&lock_);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+bool Wal::flush()					// make all appended records durable
+{
+	pthread_mutex_lock(&lock_);
+	int64_t last = next_lsn_ - 1;
+	bool    none = is_lost(last);	// nothing after lost records
+	pthread_mutex_unlock(&lock_);
+
+	return none || commit(last);
+}
+
+// -----------------------------------------------------------------------------
+bool Wal::is_lost(					// whether a record is lost (hold lock_)
+	int64_t lsn)						// lsn of record
+{
+	for (size_t i = 0; i < lost_.size(); ++i) {
+		if (lsn >= lost_[i].first && lsn <= lost_[i].second) return true;
+	}
+	return false;
+}
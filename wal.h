@@ -0,0 +1,110 @@
+#ifndef __WAL_H
+#define __WAL_H
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "def.h"
+#include "crc32c.h"
+
+// -----------------------------------------------------------------------------
+//  WalRecord: a record of the redo log. <data_> points into the buffer of
+//  Wal::recover() and stays valid until the next reset().
+// -----------------------------------------------------------------------------
+struct WalRecord {
+	int     type_;					// WAL_INSERT, WAL_DELETE, ...
+	int64_t lsn_;					// log sequence number
+	int     len_;					// length of <data_>
+	const char *data_;				// payload
+};
+
+// -----------------------------------------------------------------------------
+//  Wal: redo log beside the tree file. the file starts with <magic> and the
+//  <seq> of the committed tree the records apply to; then each record is
+//  <len>, <type>, <lsn>, payload and the crc32c of all of them.
+//
+//  group commit: append() only copies a record into the log buffer. the
+//  first writer which calls commit() becomes the leader: it swaps the log
+//  buffer, then writes and syncs it without the lock, while the records of
+//  other writers go to the other buffer. followers whose record is covered
+//  by an in-progress sync wait for it, so one fdatasync serves all of them.
+//  if a sync fails, its records are lost (the next batch is written over
+//  them): commit() of each of them returns false, also for the followers.
+// -----------------------------------------------------------------------------
+class Wal {
+public:
+	Wal();							// constructor
+	~Wal();							// destructor
+
+	// -------------------------------------------------------------------------
+	bool open(						// open (or create) a log file
+		const char *fname,				// file name
+		int   base);					// seq of tree (for a new log)
+
+	// -------------------------------------------------------------------------
+	inline int get_base() { return base_; }
+
+	// -------------------------------------------------------------------------
+	inline off_t get_size() { return end_ + len_; }
+
+	// -------------------------------------------------------------------------
+	inline int get_num_syncs() { return num_syncs_; }
+
+	// -------------------------------------------------------------------------
+	bool recover(					// read the valid records of the log
+		std::vector<WalRecord> &recs);	// records (return)
+
+	// -------------------------------------------------------------------------
+	bool reset(						// drop all records (after a checkpoint)
+		int base);						// seq of tree of the new records
+
+	// -------------------------------------------------------------------------
+	int64_t append(					// add a record, return its lsn
+		int   type,						// type of record
+		const char *data,				// payload
+		int   len);						// length of payload
+
+	// -------------------------------------------------------------------------
+	bool commit(					// wait until the record <lsn> is durable
+		int64_t lsn);					// lsn of record
+
+	// -------------------------------------------------------------------------
+	bool flush();					// make all appended records durable
+
+protected:
+	int     fd_;					// file descriptor
+	int     base_;					// seq of tree the records apply to
+	off_t   end_;					// end of durable records in file
+
+	char    *buf_;					// records being appended
+	int     len_;					// length of <buf_>
+	int     cap_;					// capacity of <buf_>
+	char    *spare_;				// records being synced by the leader
+	int     spare_cap_;				// capacity of <spare_>
+
+	int64_t next_lsn_;				// lsn of the next record
+	int64_t durable_lsn_;			// all records <= it are durable
+	int64_t buf_lsn_;				// lsn of the first record of <buf_>
+	std::vector<std::pair<int64_t, int64_t> > lost_; // lsn ranges of failed syncs
+	bool    syncing_;				// whether a leader is syncing
+	int     num_syncs_;				// num of fdatasync of records
+	char    *load_;					// content of log read by recover()
+
+	pthread_mutex_t lock_;			// protect all above
+	pthread_cond_t  synced_;		// signaled when a sync is done
+
+	// -------------------------------------------------------------------------
+	bool write_head();				// write <magic> and <base_>
+
+	// -------------------------------------------------------------------------
+	bool is_lost(					// whether a record is lost (hold lock_)
+		int64_t lsn);					// lsn of record
+};
+
+#endif // __WAL_H